@@ -0,0 +1,79 @@
+#include "activation.h"
+#include "registryclient.h"
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static bool CheckKeyRequests(HttpRequestGroup& group, const ActivationEndpoints& endpoints, const std::string& token, bool& valid, std::string& error) {
+    HttpRequest workInkRequest;
+    workInkRequest.url = endpoints.validateUrl + token;
+    int workInk = group.Send("work.ink", std::move(workInkRequest));
+
+    HttpRequest ipRequest;
+    ipRequest.url = endpoints.ipUrl;
+    int ip = group.Send("ipify", std::move(ipRequest));
+
+    // an invalid key ends it here
+    const HttpResponse& workInkResponse = group.Wait(workInk);
+    if (!workInkResponse.Ok() || workInkResponse.status != 200 || workInkResponse.body.empty()) {
+        error = "Work.ink validation failed";
+        return false;
+    }
+    if (!json::parse(workInkResponse.body)["valid"].get<bool>()) {
+        error = "Invalid key";
+        return true;
+    }
+
+    const HttpResponse& ipResponse = group.Wait(ip);
+    if (!ipResponse.Ok() || ipResponse.status != 200 || ipResponse.body.empty()) {
+        error = "Failed to get IP address";
+        return false;
+    }
+
+    std::string currentIP;
+    try {
+        currentIP = json::parse(ipResponse.body)["ip"].get<std::string>();
+    }
+    catch (...) {
+        error = "Failed to parse IP address";
+        return false;
+    }
+
+    // one compare-and-set on the registry: the first machine to activate a key keeps it,
+    // NEVER override an existing IP
+    KeyRegistryClient registry(endpoints.registryUrl);
+    int bind = group.Send("registry bind", registry.BindRequest(token, currentIP), { workInk, ip });
+
+    std::string boundIP;
+    switch (KeyRegistryClient::ParseBind(group.Wait(bind), boundIP, error)) {
+    case BindResult::Bound:
+    case BindResult::AlreadyBound:
+        valid = true;
+        return true;
+    case BindResult::Conflict:
+        error = "HWID/IP Mismatch: This key is already registered to a different IP address";
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CheckKeyActivation(HttpRequestGroup& group, const ActivationEndpoints& endpoints, const std::string& token, bool& valid, std::string& error) {
+    valid = false;
+    bool answered = false;
+    try {
+        answered = CheckKeyRequests(group, endpoints, token, valid, error);
+    }
+    catch (const json::exception& e) {
+        error = std::string("JSON error: ") + e.what();
+    }
+    catch (const std::exception& e) {
+        error = std::string("Validation error: ") + e.what();
+    }
+    catch (...) {
+        error = "Unknown validation error";
+    }
+
+    group.Cancel(); // whatever wasn't needed for the answer
+    return answered;
+}
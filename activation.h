@@ -0,0 +1,19 @@
+#pragma once
+#include "http.h"
+#include <string>
+
+// where the online key check goes. the defaults are the production services, load tests point
+// them at local stand-ins
+struct ActivationEndpoints {
+    std::string validateUrl = "https://work.ink/_api/v2/token/isValid/"; // the key is appended
+    std::string ipUrl = "https://api.ipify.org/?format=json";
+    std::string registryUrl; // key registry service (keyregistry.cpp), no trailing slash
+};
+
+// the full online check: work.ink, then binding the key to this machine's IP in the key registry.
+// false when no answer could be had (network, bad responses), error says why. valid is the answer
+// otherwise, error says why for a rejected key. changes no globals, so it can run on any thread.
+// work.ink and the IP lookup don't depend on each other and go out together, the bind needs both.
+// the requests go through group, which has its timings afterwards; anything still in flight
+// when the answer is known gets cancelled
+bool CheckKeyActivation(HttpRequestGroup& group, const ActivationEndpoints& endpoints, const std::string& token, bool& valid, std::string& error);
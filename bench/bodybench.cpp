@@ -0,0 +1,129 @@
+// allocations and time spent reading multi-megabyte bodies. "per chunk" replays the old WinHTTP
+// loop in an onData callback (a zeroed vector for every chunk, appended to a string that grows as
+// it goes), "reserved" is HttpClient's own reader sizing the body once from Content-Length. only
+// C++ heap allocations are counted, curl's own mallocs are the same for both. the loopback server
+// runs in this process and its copy of each response is in both counts
+//   bodybench [--size <MB>]... [--rounds N]
+#include "http.h"
+#include "loopback.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<uint64_t> g_Allocations{ 0 };
+static std::atomic<uint64_t> g_AllocatedBytes{ 0 };
+
+void* operator new(size_t size) {
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+struct Sample {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+    bool ok = true;
+};
+
+template <class Read>
+static Sample Measure(int rounds, Read read) {
+    Sample sample;
+    for (int i = 0; i < rounds; ++i) {
+        uint64_t allocations = g_Allocations.load();
+        uint64_t bytes = g_AllocatedBytes.load();
+        auto start = std::chrono::steady_clock::now();
+        sample.ok = read() && sample.ok;
+        sample.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        sample.allocations += g_Allocations.load() - allocations;
+        sample.bytes += g_AllocatedBytes.load() - bytes;
+    }
+    sample.allocations /= rounds;
+    sample.bytes /= rounds;
+    sample.seconds /= rounds;
+    return sample;
+}
+
+static void Print(const char* label, const Sample& sample, size_t size) {
+    printf("  %-10s %6llu allocations  %8.1f MB allocated  %7.2f ms  %7.1f MB/s%s\n", label,
+        static_cast<unsigned long long>(sample.allocations), sample.bytes / 1048576.0, sample.seconds * 1000.0,
+        size / 1048576.0 / sample.seconds, sample.ok ? "" : "  FAILED");
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> sizesMb;
+    int rounds = 5;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--size") && hasValue) {
+            sizesMb.push_back(atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--rounds") && hasValue) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--size <MB>]... [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (sizesMb.empty()) sizesMb = { 1, 8, 64 };
+    for (int size : sizesMb) {
+        if (size < 1) {
+            fprintf(stderr, "sizes must be positive\n");
+            return 2;
+        }
+    }
+    if (rounds < 1) rounds = 1;
+
+    LoopbackServer server;
+    std::string error;
+    if (!server.Start(error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    bool ok = true;
+    {
+        HttpClient client;
+        for (int sizeMb : sizesMb) {
+            size_t size = static_cast<size_t>(sizeMb) << 20;
+            std::string path = "/body" + std::to_string(sizeMb);
+            server.Serve(path, std::string(size, 'b'));
+            HttpRequest request;
+            request.url = server.Url(path);
+            client.Fetch(request); // warm the connection
+
+            Sample perChunk = Measure(rounds, [&]() {
+                std::string body;
+                HttpRequest chunked = request;
+                chunked.onData = [&body](const char* data, size_t bytes) {
+                    std::vector<char> buffer(bytes + 1);
+                    memset(buffer.data(), 0, buffer.size());
+                    memcpy(buffer.data(), data, bytes);
+                    body.append(buffer.data(), bytes);
+                    return true;
+                };
+                return client.Fetch(chunked).Ok() && body.size() == size;
+            });
+            Sample reserved = Measure(rounds, [&]() {
+                HttpResponse response = client.Fetch(request);
+                return response.Ok() && response.Body().size() == size;
+            });
+
+            printf("%d MB body:\n", sizeMb);
+            Print("per chunk", perChunk, size);
+            Print("reserved", reserved, size);
+            ok = ok && perChunk.ok && reserved.ok;
+        }
+    }
+    HttpPoolShutdown();
+    server.Stop();
+    return ok ? 0 : 1;
+}
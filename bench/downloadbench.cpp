@@ -0,0 +1,89 @@
+// FetchFile one stream against N parallel ranges, on the loopback server with every connection
+// capped like a CDN edge caps it. each run downloads the whole payload into a fresh file and checks
+// its digest; the last line repeats the segmented run with no cap at all.
+//   downloadbench [--size <MB>] [--rate <MB/s per connection>] [--segments N]...
+#include "download.h"
+#include "loopback.h"
+#include "sha256.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static bool Run(LoopbackServer& server, const std::filesystem::path& dir, int segments, double sizeMb, const std::string& expected) {
+    DownloadOptions options;
+    options.segments = segments;
+    options.resume = segments > 1; // one segment without resume is the plain single stream
+    std::string output = (dir / ("payload-" + std::to_string(segments) + ".zip")).string();
+
+    std::string error, sha256;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = FetchFile(server.Url("/payload.zip"), output, options, error, &sha256);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::filesystem::remove(output);
+
+    if (!ok || sha256 != expected) {
+        printf("%2d segment(s): FAILED %s\n", segments, ok ? "digest mismatch" : error.c_str());
+        return false;
+    }
+    printf("%2d segment(s): %6.2f s  %7.1f MB/s\n", segments, seconds, sizeMb / seconds);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int sizeMb = 64;
+    double rateMb = 16.0;
+    std::vector<int> segmentCounts;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--size") && hasValue) {
+            sizeMb = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--rate") && hasValue) {
+            rateMb = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--segments") && hasValue) {
+            segmentCounts.push_back(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "usage: %s [--size <MB>] [--rate <MB/s per connection>] [--segments N]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (segmentCounts.empty()) segmentCounts = { 1, 2, 4, 8 };
+    if (sizeMb < 1 || rateMb < 0.0) {
+        fprintf(stderr, "size must be positive, rate not negative\n");
+        return 2;
+    }
+
+    LoopbackServer server;
+    std::string error;
+    if (!server.Start(error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::string payload(static_cast<size_t>(sizeMb) << 20, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(i * 2654435761u >> 24);
+    Sha256 hasher;
+    hasher.Update(payload.data(), payload.size());
+    std::string expected = Sha256::ToHex(hasher.Final());
+    server.Serve("/payload.zip", std::move(payload));
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "downloadbench";
+    std::filesystem::create_directories(dir);
+
+    bool ok = true;
+    server.bytesPerSec = static_cast<int>(rateMb * 1024 * 1024);
+    printf("%d MB, %.1f MB/s per connection\n", sizeMb, rateMb);
+    for (int segments : segmentCounts) ok = Run(server, dir, segments, sizeMb, expected) && ok;
+
+    server.bytesPerSec = 0;
+    printf("%d MB, no cap\n", sizeMb);
+    ok = Run(server, dir, 1, sizeMb, expected) && ok;
+    ok = Run(server, dir, segmentCounts.back(), sizeMb, expected) && ok;
+
+    std::filesystem::remove_all(dir);
+    server.Stop();
+    HttpPoolShutdown();
+    return ok ? 0 : 1;
+}
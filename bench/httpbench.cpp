@@ -0,0 +1,157 @@
+// latency and throughput of the portable HTTP client against the loopback server, no outside
+// services: small GET JSON one after another and many in flight, a large file whole and in
+// parallel ranges, and PUTs.
+//   httpbench [--requests N] [--concurrency C] [--size <MB>] [--ranges R]
+#include "http.h"
+#include "loopback.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double Percentile(std::vector<double> values, double q) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[(std::min)(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+static double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int requests = 2000;
+    int concurrency = 32;
+    int sizeMb = 64;
+    int ranges = 4;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--requests") && hasValue) {
+            requests = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--concurrency") && hasValue) {
+            concurrency = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--size") && hasValue) {
+            sizeMb = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--ranges") && hasValue) {
+            ranges = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--requests N] [--concurrency C] [--size <MB>] [--ranges R]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (requests < 1 || concurrency < 1 || sizeMb < 1 || ranges < 1) {
+        fprintf(stderr, "all counts must be positive\n");
+        return 2;
+    }
+
+    LoopbackServer server;
+    std::string error;
+    if (!server.Start(error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::string payload(static_cast<size_t>(sizeMb) << 20, 'x');
+    server.Serve("/payload.zip", payload);
+    server.Serve("/api/key", "{\"valid\":true}", "application/json");
+
+    {
+        HttpClient client;
+        HttpRequest json;
+        json.url = server.Url("/api/key");
+
+        // one at a time: the round trip itself
+        std::vector<double> latencyMs;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < requests; ++i) {
+            Clock::time_point sent = Clock::now();
+            client.Fetch(json);
+            latencyMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+        }
+        double seconds = SecondsSince(start);
+        printf("GET json, sequential:     %6.0f req/s  p50 %.3f ms  p99 %.3f ms\n", requests / seconds,
+            Percentile(latencyMs, 0.50), Percentile(latencyMs, 0.99));
+
+        // concurrency requests in flight at all times
+        latencyMs.clear();
+        start = Clock::now();
+        for (int sent = 0; sent < requests;) {
+            std::vector<std::pair<Clock::time_point, std::future<HttpResponse>>> batch;
+            for (int i = 0; i < concurrency && sent < requests; ++i, ++sent) batch.emplace_back(Clock::now(), client.Send(json));
+            for (auto& pending : batch) {
+                pending.second.get();
+                latencyMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - pending.first).count());
+            }
+        }
+        seconds = SecondsSince(start);
+        printf("GET json, %3d in flight:  %6.0f req/s  p50 %.3f ms  p99 %.3f ms\n", concurrency, requests / seconds,
+            Percentile(latencyMs, 0.50), Percentile(latencyMs, 0.99));
+
+        // the payload in one stream, then split into ranges fetched together
+        HttpRequest whole;
+        whole.url = server.Url("/payload.zip");
+        whole.timeout = 0;
+        size_t received = 0;
+        whole.onData = [&received](const char*, size_t size) {
+            received += size;
+            return true;
+        };
+        start = Clock::now();
+        HttpResponse response = client.Fetch(whole);
+        seconds = SecondsSince(start);
+        printf("GET %d MB, one stream:    %7.1f MB/s%s\n", sizeMb, sizeMb / seconds, response.status == 200 && received == payload.size() ? "" : "  FAILED");
+
+        std::vector<size_t> got(ranges, 0);
+        std::vector<std::future<HttpResponse>> parts;
+        size_t slice = payload.size() / ranges;
+        start = Clock::now();
+        for (int i = 0; i < ranges; ++i) {
+            HttpRequest part = whole;
+            size_t first = i * slice;
+            size_t last = i == ranges - 1 ? payload.size() - 1 : first + slice - 1;
+            part.range = std::to_string(first) + "-" + std::to_string(last);
+            size_t& counter = got[i];
+            part.onData = [&counter](const char*, size_t size) {
+                counter += size;
+                return true;
+            };
+            parts.push_back(client.Send(std::move(part)));
+        }
+        bool ok = true;
+        for (auto& part : parts) ok = part.get().status == 206 && ok;
+        seconds = SecondsSince(start);
+        size_t total = 0;
+        for (size_t counter : got) total += counter;
+        printf("GET %d MB, %d ranges:      %7.1f MB/s%s\n", sizeMb, ranges, sizeMb / seconds, ok && total == payload.size() ? "" : "  FAILED");
+
+        // PUTs of a small binding, as the registry client sends them
+        HttpRequest put;
+        put.method = "PUT";
+        put.body = "203.0.113.7";
+        start = Clock::now();
+        std::vector<std::future<HttpResponse>> puts;
+        for (int i = 0; i < requests; ++i) {
+            put.url = server.Url("/v1/keys/" + std::to_string(i));
+            puts.push_back(client.Send(put));
+            if (puts.size() == static_cast<size_t>(concurrency)) {
+                for (auto& pending : puts) pending.get();
+                puts.clear();
+            }
+        }
+        for (auto& pending : puts) pending.get();
+        seconds = SecondsSince(start);
+        printf("PUT, %3d in flight:       %6.0f req/s\n", concurrency, requests / seconds);
+    }
+
+    HttpPoolStats stats = HttpPoolGetStats();
+    printf("pool: %llu requests on %llu connections\n", static_cast<unsigned long long>(stats.requests),
+        static_cast<unsigned long long>(stats.connections));
+    server.Stop();
+    HttpPoolShutdown();
+    return 0;
+}
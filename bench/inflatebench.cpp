@@ -0,0 +1,111 @@
+// inflate MB/s per backend on payloads like a release's: script text, already-compressed binary
+// and zero-filled padding, as small entries and as one big one. Whole is libdeflate when the build
+// has it, Step streams through zlib (or zlib-ng) into a 64 KB buffer like extraction does
+//   inflatebench [--mb M]
+#include "inflater.h"
+#include "zipwriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string Script(size_t size) {
+    static const char* words[] = { "local ", "function ", "return ", "end\n", "velocity ", "inject ", "= ", "nil ", "then\n", "0x7f " };
+    std::string data;
+    uint32_t x = 7;
+    while (data.size() < size) {
+        x = x * 1103515245 + 12345;
+        data += (x >> 28) < 12 ? words[(x >> 16) % 10] : std::to_string(x >> 20) + " ";
+    }
+    data.resize(size);
+    return data;
+}
+
+static std::string Noise(size_t size) {
+    std::string data(size, '\0');
+    uint32_t x = 11;
+    for (char& c : data) c = static_cast<char>((x = x * 1103515245 + 12345) >> 24);
+    return data;
+}
+
+// seconds to inflate compressed rounds times, -1 if it didn't come out right
+static double TimeWhole(Inflater& inflater, const std::string& compressed, size_t size, int rounds) {
+    std::vector<unsigned char> out(size);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        if (inflater.Whole(reinterpret_cast<const unsigned char*>(compressed.data()), compressed.size(), out.data(), size) != InflateResult::Done)
+            return -1.0;
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double TimeStep(Inflater& inflater, const std::string& compressed, size_t size, int rounds) {
+    std::vector<unsigned char> out(64 * 1024);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        if (!inflater.Begin()) return -1.0;
+        size_t pos = 0;
+        size_t total = 0;
+        InflateResult result = InflateResult::More;
+        while (result == InflateResult::More) {
+            size_t consumed = 0;
+            size_t produced = 0;
+            result = inflater.Step(reinterpret_cast<const unsigned char*>(compressed.data()) + pos, compressed.size() - pos, consumed,
+                out.data(), out.size(), produced);
+            pos += consumed;
+            total += produced;
+            if (result == InflateResult::More && consumed == 0 && produced == 0) return -1.0;
+        }
+        if (result != InflateResult::Done || total != size) return -1.0;
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int totalMb = 256;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--mb") && i + 1 < argc) {
+            totalMb = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--mb M]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (totalMb < 1) {
+        fprintf(stderr, "--mb must be positive\n");
+        return 2;
+    }
+    printf("whole: %s, stream: %s, whole preferred up to %llu MB\n", Inflater::WholeBackend(), Inflater::StreamBackend(),
+        static_cast<unsigned long long>(Inflater::kWholeMaxSize >> 20));
+
+    struct Payload {
+        const char* name;
+        std::string data;
+    };
+    Payload payloads[] = {
+        { "script 64 KB", Script(64 * 1024) },
+        { "script 8 MB", Script(8 << 20) },
+        { "binary 8 MB", Noise(8 << 20) },
+        { "zeros 8 MB", std::string(8 << 20, '\0') },
+    };
+
+    bool ok = true;
+    Inflater inflater;
+    for (const Payload& payload : payloads) {
+        std::string compressed = ZipWriter::Deflate(payload.data);
+        int rounds = static_cast<int>((std::max)(size_t(1), (static_cast<size_t>(totalMb) << 20) / payload.data.size()));
+        double whole = TimeWhole(inflater, compressed, payload.data.size(), rounds);
+        double step = TimeStep(inflater, compressed, payload.data.size(), rounds);
+        double mb = payload.data.size() * static_cast<double>(rounds) / 1048576.0;
+        printf("%-13s ratio %5.2f  whole %8.1f MB/s  step %8.1f MB/s\n", payload.name,
+            static_cast<double>(payload.data.size()) / compressed.size(), whole > 0 ? mb / whole : 0.0, step > 0 ? mb / step : 0.0);
+        ok = ok && whole > 0 && step > 0;
+    }
+    if (!ok) printf("an inflate FAILED\n");
+    return ok ? 0 : 1;
+}
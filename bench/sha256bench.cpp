@@ -0,0 +1,57 @@
+// SHA-256 throughput per backend, on buffers sized like the chunks a download hands over and
+// like whole files
+//   sha256bench [--mb M]
+#include "sha256.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int totalMb = 256;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--mb") && i + 1 < argc) {
+            totalMb = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--mb M]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (totalMb < 1) {
+        fprintf(stderr, "--mb must be positive\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data(16 << 20);
+    uint32_t x = 1;
+    for (uint8_t& byte : data) byte = static_cast<uint8_t>((x = x * 1103515245 + 12345) >> 24);
+    size_t total = static_cast<size_t>(totalMb) << 20;
+
+    std::string reference;
+    for (Sha256::Backend backend : { Sha256::Backend::Portable, Sha256::Backend::ShaNi }) {
+        if (!Sha256::Supported(backend)) {
+            printf("%-8s not supported on this CPU\n", Sha256::BackendName(backend));
+            continue;
+        }
+        for (size_t chunk : { size_t(16 * 1024), size_t(1 << 20), data.size() }) {
+            Sha256 hasher(backend);
+            auto start = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < total; done += chunk) {
+                // the chunk sizes divide the buffer, so a chunk never runs off its end
+                hasher.Update(data.data() + done % data.size(), (std::min)(chunk, total - done));
+            }
+            std::string digest = Sha256::ToHex(hasher.Final());
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("%-8s %8zu KB chunks: %8.1f MB/s\n", Sha256::BackendName(backend), chunk / 1024, totalMb / seconds);
+            if (reference.empty()) reference = digest;
+            if (digest != reference) {
+                printf("digest mismatch: %s vs %s\n", digest.c_str(), reference.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
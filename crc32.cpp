@@ -0,0 +1,134 @@
+#include "crc32.h"
+#include <zlib.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// gcc and clang only emit PCLMUL/SSE4.1 instructions in functions that ask for them, MSVC always does
+#if defined(CRC32_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_TARGET __attribute__((target("pclmul,sse4.1")))
+#else
+#define CRC32_TARGET
+#endif
+
+#ifdef CRC32_X86
+// folding constants for the reflected CRC-32 polynomial 0x04C11DB7, x^n mod P for the fold
+// distances (512 +- 32, 128 +- 32, 64) and the Barrett reduction pair, as in Intel's
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ" paper
+alignas(16) static const uint64_t kFold512[2] = { 0x0154442bd4, 0x01c6e41596 };
+alignas(16) static const uint64_t kFold128[2] = { 0x01751997d0, 0x00ccaa009e };
+alignas(16) static const uint64_t kFold64[2] = { 0x0163cd6124, 0x0000000000 };
+alignas(16) static const uint64_t kBarrett[2] = { 0x01db710641, 0x01f7011641 };
+
+// crc over size bytes, size a multiple of 16 and at least 64. crc is the raw register, not inverted
+CRC32_TARGET static uint32_t FoldPclmul(const uint8_t* data, size_t size, uint32_t crc) {
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    data += 64;
+    size -= 64;
+
+    // four independent 128-bit lanes, each folded 512 bits forward per round
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(kFold512));
+    while (size >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+        data += 64;
+        size -= 64;
+    }
+
+    // the four lanes into one, then any 16-byte blocks left
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(kFold128));
+    __m128i lanes[3] = { x2, x3, x4 };
+    for (const __m128i& lane : lanes) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, lane), low);
+    }
+    while (size >= 16) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), low);
+        data += 16;
+        size -= 16;
+    }
+
+    // 128 -> 64 bits
+    __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kFold64));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(kBarrett));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+static bool CpuHasPclmul() {
+    int leaf1[4] = {};
+#ifdef _MSC_VER
+    __cpuid(leaf1, 1);
+#else
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    leaf1[2] = static_cast<int>(c);
+#endif
+    bool pclmul = (leaf1[2] & (1 << 1)) != 0;
+    bool sse41 = (leaf1[2] & (1 << 19)) != 0;
+    return pclmul && sse41;
+}
+
+static const bool g_HavePclmul = CpuHasPclmul();
+#endif
+
+uint32_t Crc32Update(uint32_t crc, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+#ifdef CRC32_X86
+    if (g_HavePclmul && size >= 64) {
+        size_t folded = size & ~static_cast<size_t>(15);
+        crc = ~FoldPclmul(bytes, folded, ~crc);
+        bytes += folded;
+        size -= folded;
+    }
+#endif
+    // zlib takes 32-bit lengths on some builds, feed it in chunks that always fit
+    while (size > 0) {
+        uInt chunk = static_cast<uInt>(size < (1u << 30) ? size : (1u << 30));
+        crc = static_cast<uint32_t>(crc32(crc, bytes, chunk));
+        bytes += chunk;
+        size -= chunk;
+    }
+    return crc;
+}
+
+const char* Crc32Backend() {
+#ifdef CRC32_X86
+    if (g_HavePclmul) return "pclmul";
+#endif
+    return "table";
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// zip/zlib CRC-32, same results as zlib's crc32(): start from 0 and feed the bytes in order.
+// folds 64 bytes at a time with carry-less multiply (PCLMULQDQ) when the CPU has it,
+// zlib's table code otherwise and for the last few bytes
+uint32_t Crc32Update(uint32_t crc, const void* data, size_t size);
+
+// which path Crc32Update takes on this CPU, for the debug log
+const char* Crc32Backend();
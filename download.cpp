@@ -0,0 +1,539 @@
+#include "download.h"
+#include "sha256.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static HttpClient& Client(const DownloadOptions& options) {
+    return options.client ? *options.client : DefaultHttpClient();
+}
+
+static FILE* OpenFile(const std::string& path, const char* mode) {
+#ifdef _WIN32
+    FILE* fp = nullptr;
+    return fopen_s(&fp, path.c_str(), mode) == 0 ? fp : nullptr;
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+// 64-bit offsets, the payloads outgrow a long on Windows
+static int SeekFile(FILE* fp, curl_off_t offset) {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, SEEK_SET);
+#else
+    return fseeko(fp, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+HttpRequest PayloadRequest(const DownloadOptions& options, const std::string& url, curl_off_t expectedBytes) {
+    HttpRequest request = options.request;
+    request.url = url;
+    request.timeout = 0;
+    request.lowSpeedLimit = 0;
+    request.lowSpeedTime = 0;
+    request.watchdog = std::make_shared<TransferWatchdog>(expectedBytes, options.expectedBytesPerSec);
+    return request;
+}
+
+std::string TransferError(const HttpResponse& response, const TransferWatchdog& watchdog) {
+    if (watchdog.Stalled()) return "connection stalled";
+    if (watchdog.Overdue()) return "transfer too slow to finish";
+    return !response.Ok() ?
+        std::string("CURL error: ") + response.error :
+        std::string("HTTP error: ") + std::to_string(response.status);
+}
+
+// what the range probe learned about the remote file
+struct DownloadProbe {
+    curl_off_t contentLength = -1;
+    bool acceptsRanges = false;
+    std::string etag;
+    std::string lastModified;
+};
+
+// ask for byte 0 only; a 206 with a Content-Range total means ranges work
+static bool ProbeDownload(const std::string& url, const DownloadOptions& options, DownloadProbe& probe) {
+    HttpRequest request = options.request;
+    request.url = url;
+    request.range = "0-0";
+    request.timeout = 15;
+    
+    // we asked for a single byte, anything more means the range was ignored
+    size_t received = 0;
+    request.onData = [&received](const char*, size_t size) {
+        received += size;
+        return received <= 1;
+    };
+    
+    HttpResponse response = Client(options).Fetch(std::move(request));
+    
+    // "Content-Range: bytes 0-0/12345" carries the full size on a 206
+    std::string contentRange = response.Header("Content-Range");
+    size_t slash = contentRange.find('/');
+    if (slash != std::string::npos && contentRange.compare(slash + 1, 1, "*") != 0) {
+        probe.contentLength = std::strtoll(contentRange.c_str() + slash + 1, nullptr, 10);
+    }
+    probe.etag = response.Header("ETag");
+    probe.lastModified = response.Header("Last-Modified");
+    
+    probe.acceptsRanges = response.Ok() && response.status == 206 && probe.contentLength > 0;
+    return probe.acceptsRanges;
+}
+
+// one byte range of a segmented download, written into its own slice of the file
+struct DownloadSegment {
+    curl_off_t start = 0;
+    curl_off_t end = 0;     // inclusive
+    curl_off_t written = 0; // bytes from start that are already in the file
+    FILE* fp = nullptr;
+    long httpCode = 0;
+    CURLcode result = CURLE_OK;
+    
+    curl_off_t length() const { return end - start + 1; }
+    bool complete() const { return written == length(); }
+};
+
+// partial download state kept next to the file so a dropped transfer can pick up where it stopped
+struct DownloadJournal {
+    std::string url;
+    std::string etag;
+    std::string lastModified;
+    curl_off_t totalSize = 0;
+    std::vector<DownloadSegment> segments;
+};
+
+std::string DownloadJournalPath(const std::string& outputPath) {
+    return outputPath + ".part";
+}
+
+static void RemoveDownloadJournal(const std::string& outputPath) {
+    try {
+        std::filesystem::remove(DownloadJournalPath(outputPath));
+    } catch (...) {}
+}
+
+static bool SaveDownloadJournal(const std::string& outputPath, const DownloadJournal& journal) {
+    try {
+        json data;
+        data["url"] = journal.url;
+        data["etag"] = journal.etag;
+        data["lastModified"] = journal.lastModified;
+        data["size"] = journal.totalSize;
+        data["ranges"] = json::array();
+        for (const DownloadSegment& segment : journal.segments) {
+            data["ranges"].push_back({ segment.start, segment.end, segment.written });
+        }
+        
+        // write then rename so a crash mid-save never leaves a torn journal
+        std::string journalPath = DownloadJournalPath(outputPath);
+        std::string tempPath = journalPath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) return false;
+            file << data.dump();
+        }
+        std::filesystem::rename(tempPath, journalPath);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+static bool LoadDownloadJournal(const std::string& outputPath, DownloadJournal& journal) {
+    try {
+        std::ifstream file(DownloadJournalPath(outputPath));
+        if (!file.is_open()) return false;
+        
+        json data = json::parse(file);
+        journal.url = data["url"].get<std::string>();
+        journal.etag = data["etag"].get<std::string>();
+        journal.lastModified = data["lastModified"].get<std::string>();
+        journal.totalSize = data["size"].get<curl_off_t>();
+        journal.segments.clear();
+        for (const auto& range : data["ranges"]) {
+            DownloadSegment segment;
+            segment.start = range[0].get<curl_off_t>();
+            segment.end = range[1].get<curl_off_t>();
+            segment.written = range[2].get<curl_off_t>();
+            if (segment.start > segment.end || segment.written < 0 || segment.written > segment.length()) return false;
+            journal.segments.push_back(segment);
+        }
+        return !journal.segments.empty();
+    } catch (...) {
+        return false;
+    }
+}
+
+// the partial file is only usable if the remote file is provably the same one
+static bool JournalMatchesProbe(const DownloadJournal& journal, const std::string& url, const DownloadProbe& probe, const std::string& outputPath) {
+    if (journal.totalSize != probe.contentLength) return false;
+    
+    if (!journal.etag.empty() || !probe.etag.empty()) {
+        if (journal.etag != probe.etag) return false;
+    } else if (!journal.lastModified.empty() || !probe.lastModified.empty()) {
+        if (journal.lastModified != probe.lastModified) return false;
+    } else if (journal.url != url) {
+        return false; // no validators at all, only trust the exact same URL
+    }
+    
+    try {
+        return std::filesystem::file_size(outputPath) == static_cast<uintmax_t>(journal.totalSize);
+    } catch (...) {
+        return false;
+    }
+}
+
+// a server that ignores Range sends the whole file, stop before it overwrites the next slice
+static bool WriteSegmentData(const DownloadSegment& segment, std::atomic<curl_off_t>& written, const char* data, size_t size) {
+    if (written + static_cast<curl_off_t>(size) > segment.length()) {
+        return false;
+    }
+    
+    size_t stored = fwrite(data, 1, size, segment.fp);
+    written += static_cast<curl_off_t>(stored);
+    return stored == size;
+}
+
+bool FetchRange(const std::string& url, curl_off_t first, curl_off_t last, FILE* fp, const DownloadOptions& options, curl_off_t& written) {
+    DownloadSegment segment;
+    segment.start = first;
+    segment.end = last;
+    segment.fp = fp;
+    
+    HttpRequest request = options.request;
+    request.url = url;
+    request.range = std::to_string(first) + "-" + std::to_string(last);
+    std::atomic<curl_off_t> counter = 0;
+    request.onData = [&segment, &counter](const char* data, size_t size) {
+        return WriteSegmentData(segment, counter, data, size);
+    };
+    
+    HttpResponse response = Client(options).Fetch(std::move(request));
+    segment.written = written = counter;
+    return response.Ok() && response.status == 206 && segment.complete();
+}
+
+// sha256 (if asked for) gets the digest of the body, hashed as it's written
+static bool DownloadFileSingle(const std::string& url, const std::string& outputPath, const DownloadOptions& options,
+    std::string& error, std::string* sha256) {
+    FILE* fp = OpenFile(outputPath, "wb");
+    if (!fp) {
+        error = "Failed to open file for writing: " + std::error_code(errno, std::generic_category()).message();
+        return false;
+    }
+    
+    Sha256 hasher;
+    Sha256* hashing = sha256 ? &hasher : nullptr;
+    HttpRequest request = PayloadRequest(options, url, -1);
+    request.onData = [fp, hashing](const char* data, size_t size) {
+        if (hashing) hashing->Update(data, size);
+        return fwrite(data, 1, size, fp) == size;
+    };
+    std::shared_ptr<TransferWatchdog> watchdog = request.watchdog;
+    
+    std::atomic<float>* progress = options.progress;
+    if (progress) {
+        *progress = 0.0f;
+        request.onProgress = [progress](curl_off_t total, curl_off_t now) {
+            *progress = total > 0 ? static_cast<float>(now) / static_cast<float>(total) : 0.0f;
+        };
+    }
+    
+    HttpResponse response = Client(options).Fetch(std::move(request));
+    fclose(fp);
+    
+    if (!response.Ok() || (response.status >= 400 && response.status < 600)) {
+        error = std::string("Download failed: ") + TransferError(response, *watchdog);
+        std::filesystem::remove(outputPath);
+        return false;
+    }
+    
+    if (sha256) *sha256 = Sha256::ToHex(hasher.Final());
+    return true;
+}
+
+// split a fresh download into ranges and preallocate the file they write into
+static bool StartDownloadJournal(const std::string& url, const std::string& outputPath, const DownloadProbe& probe,
+    const DownloadOptions& options, DownloadJournal& journal, std::string& error) {
+    journal = DownloadJournal();
+    journal.url = url;
+    journal.etag = probe.etag;
+    journal.lastModified = probe.lastModified;
+    journal.totalSize = probe.contentLength;
+    
+    curl_off_t segmentCount = (std::min)(static_cast<curl_off_t>(options.segments), probe.contentLength / (std::max)(options.minSegmentSize, curl_off_t(1)));
+    if (segmentCount < 1) segmentCount = 1;
+    curl_off_t segmentSize = probe.contentLength / segmentCount;
+    
+    for (curl_off_t i = 0; i < segmentCount; ++i) {
+        DownloadSegment segment;
+        segment.start = i * segmentSize;
+        segment.end = (i == segmentCount - 1) ? probe.contentLength - 1 : segment.start + segmentSize - 1;
+        journal.segments.push_back(segment);
+    }
+    
+    // preallocate so every segment can write straight into its own offset
+    try {
+        { std::ofstream create(outputPath, std::ios::binary | std::ios::trunc); }
+        std::filesystem::resize_file(outputPath, static_cast<uintmax_t>(probe.contentLength));
+    } catch (const std::exception& e) {
+        error = std::string("Failed to preallocate download file: ") + e.what();
+        return false;
+    }
+    
+    return !options.resume || SaveDownloadJournal(outputPath, journal);
+}
+
+// hashes a segmented download in file order while the ranges are still arriving. each pass reads
+// back the stretch of the file that has become contiguous since the last one, straight out of the
+// OS cache, so the digest is ready when the last byte lands instead of costing another pass
+struct PrefixHasher {
+    Sha256 hasher;
+    FILE* reader = nullptr;
+    curl_off_t hashed = 0;
+    std::vector<uint8_t> chunk;
+    
+    bool Open(const std::string& path) {
+        reader = OpenFile(path, "rb");
+        chunk.resize(1 << 20);
+        // unbuffered: a buffered read can run ahead of the contiguous end into bytes not written yet,
+        // and a seek back within the buffer would hand those stale bytes to the next pass
+        if (reader) setvbuf(reader, nullptr, _IONBF, 0);
+        return reader != nullptr;
+    }
+    
+    ~PrefixHasher() {
+        if (reader) fclose(reader);
+    }
+    
+    bool Advance(curl_off_t end) {
+        if (!reader || SeekFile(reader, hashed) != 0) return false;
+        while (hashed < end) {
+            size_t want = static_cast<size_t>((std::min)(static_cast<curl_off_t>(chunk.size()), end - hashed));
+            size_t got = fread(chunk.data(), 1, want, reader);
+            if (got != want) return false;
+            hasher.Update(chunk.data(), got);
+            hashed += static_cast<curl_off_t>(got);
+        }
+        return true;
+    }
+};
+
+// the file is complete up to here: every range before it finished, the one it's in got this far
+static curl_off_t ContiguousEnd(const std::vector<DownloadSegment>& segments, const std::vector<std::atomic<curl_off_t>>& written) {
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (written[i] < segments[i].length()) return segments[i].start + written[i];
+    }
+    return segments.empty() ? 0 : segments.back().end + 1;
+}
+
+// fetch the unfinished part of every journal range in parallel on the shared client.
+// sets rangesIgnored when the server answered a range with a plain 200 (no ranges, or If-Range mismatch).
+// sha256, if asked for, gets the file's digest (empty if it couldn't be hashed along the way)
+static bool DownloadFileSegmented(const std::string& outputPath, DownloadJournal& journal, const DownloadOptions& options,
+    bool& rangesIgnored, std::string& error, std::string* sha256) {
+    rangesIgnored = false;
+    
+    // If-Range makes the server send the full body instead of a stale slice when the file changed
+    const std::string& validator = !journal.etag.empty() ? journal.etag : journal.lastModified;
+    
+    std::vector<DownloadSegment>& segments = journal.segments;
+    std::vector<std::future<HttpResponse>> responses(segments.size());
+    
+    // the client thread writes the segments, this one only reads these counters until it's done
+    std::vector<std::atomic<curl_off_t>> written(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) written[i] = segments[i].written;
+    
+    bool ok = true;
+    std::vector<HttpResponse> finished(segments.size());
+    std::vector<std::shared_ptr<TransferWatchdog>> watchdogs(segments.size());
+    std::vector<int> reconnects(segments.size(), 0);
+    
+    // request what's left of one range, from wherever its bytes stopped. the file position
+    // already sits there, the range's writes are sequential
+    auto sendSegment = [&](size_t i) {
+        DownloadSegment& segment = segments[i];
+        HttpRequest request = PayloadRequest(options, journal.url, segment.length() - written[i]);
+        if (!validator.empty()) {
+            request.headers.push_back("If-Range: " + validator);
+        }
+        request.range = std::to_string(segment.start + written[i]) + "-" + std::to_string(segment.end);
+        std::atomic<curl_off_t>& counter = written[i];
+        request.onData = [&segment, &counter](const char* data, size_t size) {
+            return WriteSegmentData(segment, counter, data, size);
+        };
+        watchdogs[i] = request.watchdog;
+        responses[i] = Client(options).Send(std::move(request));
+    };
+    
+    for (size_t i = 0; i < segments.size(); ++i) {
+        DownloadSegment& segment = segments[i];
+        if (segment.complete()) continue;
+        
+        segment.fp = OpenFile(outputPath, "r+b");
+        if (!segment.fp || SeekFile(segment.fp, segment.start + segment.written) != 0) {
+            error = "Failed to open file for writing";
+            ok = false;
+            break;
+        }
+        sendSegment(i);
+    }
+    
+    PrefixHasher prefix;
+    bool hashing = sha256 && ok && prefix.Open(outputPath);
+    
+    if (options.progress) *options.progress = 0.0f;
+    auto lastSave = std::chrono::steady_clock::now();
+    
+    // every range that was sent has to finish (or fail) before its file handle can go
+    for (;;) {
+        bool pending = false;
+        for (size_t i = 0; i < responses.size(); ++i) {
+            if (!responses[i].valid()) continue;
+            if (responses[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                pending = true;
+                continue;
+            }
+            
+            // a stalled range reconnects for just its missing bytes while the others keep going
+            finished[i] = responses[i].get();
+            bool stalled = watchdogs[i]->Stalled() || watchdogs[i]->Overdue();
+            if (stalled && reconnects[i] < options.stallRetries && !(options.request.cancel && *options.request.cancel)) {
+                reconnects[i]++;
+                sendSegment(i);
+                pending = true;
+            }
+        }
+        if (!pending) break;
+        
+        curl_off_t done = 0;
+        for (const auto& counter : written) done += counter;
+        if (options.progress) *options.progress = static_cast<float>(done) / static_cast<float>(journal.totalSize);
+        
+        // counted bytes may still sit in the write buffers, flush them before reading them back
+        if (hashing) {
+            curl_off_t end = ContiguousEnd(segments, written);
+            if (end > prefix.hashed) {
+                for (DownloadSegment& segment : segments) {
+                    if (segment.fp) fflush(segment.fp);
+                }
+                hashing = prefix.Advance(end);
+            }
+        }
+        
+        // commit what has been written so far about once a second
+        if (options.resume && std::chrono::steady_clock::now() - lastSave > std::chrono::seconds(1)) {
+            DownloadJournal snapshot = journal;
+            for (size_t i = 0; i < segments.size(); ++i) {
+                snapshot.segments[i].written = written[i];
+                snapshot.segments[i].fp = nullptr;
+            }
+            for (DownloadSegment& segment : segments) {
+                if (segment.fp) fflush(segment.fp);
+            }
+            SaveDownloadJournal(outputPath, snapshot);
+            lastSave = std::chrono::steady_clock::now();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    
+    curl_off_t done = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        DownloadSegment& segment = segments[i];
+        segment.httpCode = finished[i].status;
+        segment.result = finished[i].result;
+        segment.written = written[i];
+        done += segment.written;
+        if (segment.fp) {
+            fclose(segment.fp);
+            segment.fp = nullptr;
+        }
+    }
+    if (options.progress) *options.progress = static_cast<float>(done) / static_cast<float>(journal.totalSize);
+    
+    for (size_t i = 0; i < segments.size() && ok; ++i) {
+        DownloadSegment& segment = segments[i];
+        if (segment.complete() && segment.httpCode == 0) continue; // finished on an earlier attempt
+        
+        if (segment.httpCode == 200) {
+            rangesIgnored = true;
+            segment.written = 0; // the body we got was not our slice
+            error = "Download failed: server ignored the byte range request";
+            ok = false;
+        } else if (segment.result != CURLE_OK || segment.httpCode != 206) {
+            error = std::string("Download failed: ") + TransferError(finished[i], *watchdogs[i]);
+            ok = false;
+        } else if (!segment.complete()) {
+            error = "Download failed: a segment ended early";
+            ok = false;
+        }
+    }
+    
+    if (!ok) {
+        // keep the partial file and its journal so the next attempt resumes instead of restarting
+        if (options.resume && !rangesIgnored && SaveDownloadJournal(outputPath, journal)) {
+            return false;
+        }
+        RemoveDownloadJournal(outputPath);
+        std::filesystem::remove(outputPath);
+        return false;
+    }
+    
+    // the tail that arrived after the last pass
+    if (hashing && prefix.Advance(journal.totalSize)) {
+        *sha256 = Sha256::ToHex(prefix.hasher.Final());
+    }
+    
+    RemoveDownloadJournal(outputPath);
+    return true;
+}
+
+bool FetchFile(const std::string& url, const std::string& outputPath, const DownloadOptions& options, std::string& error, std::string* sha256) {
+    try {
+        std::filesystem::path dir = std::filesystem::path(outputPath).parent_path();
+        std::filesystem::create_directories(dir);
+    } catch (const std::exception& e) {
+        error = std::string("Error creating directory: ") + e.what();
+        return false;
+    }
+    
+    // range-capable servers go through the journaled path, even with one segment, so they can resume
+    DownloadProbe probe;
+    if ((options.segments > 1 || options.resume) && ProbeDownload(url, options, probe)) {
+        DownloadJournal journal;
+        bool resumed = options.resume && LoadDownloadJournal(outputPath, journal) &&
+            JournalMatchesProbe(journal, url, probe, outputPath);
+        
+        if (resumed) {
+            journal.url = url;
+        } else if (!StartDownloadJournal(url, outputPath, probe, options, journal, error)) {
+            return false;
+        }
+        
+        bool rangesIgnored = false;
+        if (DownloadFileSegmented(outputPath, journal, options, rangesIgnored, error, sha256)) {
+            if (sha256 && sha256->empty()) *sha256 = Sha256File(outputPath); // couldn't keep up, one read back
+            return true;
+        }
+        if (!rangesIgnored) {
+            return false;
+        }
+    }
+    
+    // no range support (or it lied about it) - one plain stream, nothing to resume from
+    RemoveDownloadJournal(outputPath);
+    return DownloadFileSingle(url, outputPath, options, error, sha256);
+}
+
@@ -0,0 +1,37 @@
+#pragma once
+#include "http.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+// how FetchFile downloads. the defaults are the launcher's
+struct DownloadOptions {
+    HttpRequest request;                 // every request starts from this one: headers, user agent, TLS, cancel
+    int segments = 4;                    // parallel byte ranges per file, 1 = single stream
+    curl_off_t minSegmentSize = 1 << 20; // don't split below 1 MB per range
+    bool resume = true;                  // keep partial files + journal for the next attempt
+    int stallRetries = 3;                // reconnects per range after a stall before giving up
+    double expectedBytesPerSec = 0.0;    // what the server managed last time, 0 = unknown
+    std::atomic<float>* progress = nullptr; // share of the file that's in, while it downloads
+    HttpClient* client = nullptr;        // DefaultHttpClient() when null
+};
+
+// the payload itself: no fixed timeout or low speed limit, the watchdog fits both to the file and the link
+HttpRequest PayloadRequest(const DownloadOptions& options, const std::string& url, curl_off_t expectedBytes);
+
+// what went wrong with a payload transfer, for the "Download failed: " message
+std::string TransferError(const HttpResponse& response, const TransferWatchdog& watchdog);
+
+// download any file: segmented and resumable when the server allows it, one stream otherwise. a
+// range-capable server is probed with a one-byte range, the file preallocated and its ranges
+// fetched in parallel, each written into its own slice. sha256 (if asked for) gets the file's
+// digest, computed while it downloads. false with error when the file couldn't be downloaded
+bool FetchFile(const std::string& url, const std::string& outputPath, const DownloadOptions& options, std::string& error,
+    std::string* sha256 = nullptr);
+
+// bytes first..last of url into fp at its current position. a server that ignores the range is
+// stopped before it writes past it. written gets how much went in, true once all of it did
+bool FetchRange(const std::string& url, curl_off_t first, curl_off_t last, FILE* fp, const DownloadOptions& options, curl_off_t& written);
+
+// the journal FetchFile keeps beside a partial download it can resume
+std::string DownloadJournalPath(const std::string& outputPath);
@@ -0,0 +1,1041 @@
+#include "extract.h"
+#include "crc32.h"
+#include "sha256.h"
+#include "store.h"
+#include "uring.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t kLocalHeaderSignature = 0x04034b50;
+static const uint32_t kCentralHeaderSignature = 0x02014b50;
+static const uint32_t kEndOfCentralDirSignature = 0x06054b50;
+static const uint32_t kDescriptorSignature = 0x08074b50;
+static const uint32_t kZip64EndOfCentralDirSignature = 0x06064b50;
+static const uint32_t kZip64LocatorSignature = 0x07064b50;
+static const size_t kLocalHeaderSize = 30;
+static const size_t kCentralHeaderSize = 46;
+static const size_t kEndOfCentralDirSize = 22;
+
+static const uint16_t kFlagEncrypted = 0x0001;
+static const uint16_t kFlagDataDescriptor = 0x0008;
+static const uint16_t kMethodStored = 0;
+static const uint16_t kMethodDeflated = 8;
+
+static const size_t kWriteBufferSize = 1 << 20;        // per OutputFile, most entries go out in one write
+static const size_t kWriteAlignment = 4096;            // page-aligned so the kernel copies whole pages
+static const int64_t kPreallocateMinSize = 64 * 1024; // below this the single write lays the file out anyway
+
+static uint16_t ReadLE16(const char* p) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>(b[0] | (b[1] << 8));
+}
+
+static uint32_t ReadLE32(const char* p) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+        (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+static uint64_t ReadLE64(const char* p) {
+    return static_cast<uint64_t>(ReadLE32(p)) | (static_cast<uint64_t>(ReadLE32(p + 4)) << 32);
+}
+
+// refuse names that would escape the extraction folder
+bool IsSafeEntryName(const std::string& name) {
+    if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos) return false;
+    for (const auto& part : std::filesystem::path(name)) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+bool DirectoryCache::Ensure(const std::filesystem::path& directory, std::error_code& ec) {
+    if (directory.empty() || known.count(directory.string())) return true;
+
+    // parents first, each of them at most one mkdir too. the root is made in one go
+    if (directory == root || !directory.has_relative_path() || directory.parent_path() == directory) {
+        std::filesystem::create_directories(directory, ec);
+    } else {
+        if (!Ensure(directory.parent_path(), ec)) return false;
+        std::filesystem::create_directory(directory, ec);
+    }
+    if (ec) return false;
+    known.insert(directory.string());
+    return true;
+}
+
+OutputFile::~OutputFile() {
+    Discard();
+    if (buffer) ::operator delete(buffer, std::align_val_t(kWriteAlignment));
+}
+
+bool OutputFile::IsOpen() const {
+#ifdef _WIN32
+    return handle != nullptr;
+#else
+    return fd >= 0;
+#endif
+}
+
+bool OutputFile::Open(const std::filesystem::path& path, int64_t expectedSize) {
+    Discard();
+    if (!buffer) buffer = static_cast<unsigned char*>(::operator new(kWriteBufferSize, std::align_val_t(kWriteAlignment)));
+    used = 0;
+    failed = false;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    handle = file;
+    if (expectedSize >= kPreallocateMinSize) {
+        // reserves the clusters without moving end of file, a short entry isn't padded
+        FILE_ALLOCATION_INFO allocation = {};
+        allocation.AllocationSize.QuadPart = expectedSize;
+        SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation));
+    }
+#else
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+#ifdef __linux__
+    if (expectedSize >= kPreallocateMinSize) {
+        // same with KEEP_SIZE, and filesystems without fallocate just say no
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(expectedSize));
+    }
+#endif
+#endif
+    return true;
+}
+
+bool OutputFile::WriteThrough(const unsigned char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>((std::min)(size, static_cast<size_t>(1u << 30)));
+        DWORD done = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle), data, chunk, &done, nullptr) || done == 0) {
+            failed = true;
+            return false;
+        }
+#else
+        ssize_t done = write(fd, data, size);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) {
+            failed = true;
+            return false;
+        }
+#endif
+        data += done;
+        size -= static_cast<size_t>(done);
+    }
+    return true;
+}
+
+bool OutputFile::Flush() {
+    if (failed) return false;
+    if (used == 0) return true;
+    size_t pending = used;
+    used = 0;
+    return WriteThrough(buffer, pending);
+}
+
+unsigned char* OutputFile::Space(size_t& available) {
+    if (used == kWriteBufferSize && !Flush()) return nullptr;
+    available = kWriteBufferSize - used;
+    return buffer + used;
+}
+
+bool OutputFile::Write(const void* data, size_t size) {
+    if (failed) return false;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    // anything at least a buffer long skips the copy
+    if (size >= kWriteBufferSize) {
+        return Flush() && WriteThrough(bytes, size);
+    }
+    if (size > kWriteBufferSize - used && !Flush()) return false;
+    memcpy(buffer + used, bytes, size);
+    used += size;
+    return true;
+}
+
+bool OutputFile::Close() {
+    if (!IsOpen()) return false;
+    bool ok = Flush();
+#ifdef _WIN32
+    ok = CloseHandle(static_cast<HANDLE>(handle)) != 0 && ok;
+    handle = nullptr;
+#else
+    ok = close(fd) == 0 && ok;
+    fd = -1;
+#endif
+    return ok;
+}
+
+// close without flushing, what's buffered is dropped
+void OutputFile::Discard() {
+#ifdef _WIN32
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));
+    handle = nullptr;
+#else
+    if (fd >= 0) close(fd);
+    fd = -1;
+#endif
+    used = 0;
+}
+
+StreamingZipExtractor::StreamingZipExtractor(const std::string& extractPath, ContentStore* store)
+    : extractPath(extractPath), directories(this->extractPath), store(store) {
+}
+
+StreamingZipExtractor::~StreamingZipExtractor() {
+}
+
+bool StreamingZipExtractor::Fail(const std::string& message, bool layoutUnsupported) {
+    if (state != State::Failed) {
+        error = message;
+        unsupported = layoutUnsupported;
+        state = State::Failed;
+    }
+    return false;
+}
+
+// move bytes into pending until it holds count of them
+bool StreamingZipExtractor::Need(const char* data, size_t size, size_t& pos, size_t count) {
+    if (pending.size() < count) {
+        size_t take = (std::min)(count - pending.size(), size - pos);
+        pending.append(data + pos, take);
+        pos += take;
+    }
+    return pending.size() >= count;
+}
+
+bool StreamingZipExtractor::BeginEntry() {
+    const char* header = pending.data();
+    flags = ReadLE16(header + 6);
+    method = ReadLE16(header + 8);
+    crc32 = ReadLE32(header + 14);
+    uint64_t compressedSize = ReadLE32(header + 18);
+    uint64_t uncompressedSize = ReadLE32(header + 22);
+    uint16_t nameLength = ReadLE16(header + 26);
+    uint16_t extraLength = ReadLE16(header + 28);
+
+    entryName.assign(header + kLocalHeaderSize, nameLength);
+
+    // zip64 keeps the real sizes in extra field 0x0001 when the header ones are saturated
+    zip64 = false;
+    const char* extra = header + kLocalHeaderSize + nameLength;
+    for (size_t offset = 0; offset + 4 <= extraLength;) {
+        uint16_t id = ReadLE16(extra + offset);
+        uint16_t length = ReadLE16(extra + offset + 2);
+        if (offset + 4 + length > extraLength) break;
+        if (id == 0x0001) {
+            zip64 = true;
+            const char* field = extra + offset + 4;
+            size_t used = 0;
+            if (uncompressedSize == 0xFFFFFFFF && used + 8 <= length) { uncompressedSize = ReadLE64(field + used); used += 8; }
+            if (compressedSize == 0xFFFFFFFF && used + 8 <= length) { compressedSize = ReadLE64(field + used); used += 8; }
+        }
+        offset += 4 + length;
+    }
+    pending.clear();
+
+    if (flags & kFlagEncrypted) {
+        return Fail("Encrypted ZIP entries are not supported: " + entryName, true);
+    }
+    if (method != kMethodStored && method != kMethodDeflated) {
+        return Fail("Unsupported ZIP compression method in " + entryName, true);
+    }
+    if (!IsSafeEntryName(entryName)) {
+        return Fail("ZIP entry has an unsafe path: " + entryName);
+    }
+
+    compressedRemaining = compressedSize;
+    this->uncompressedSize = uncompressedSize;
+    std::filesystem::path outputPath = extractPath / entryName;
+
+    std::error_code ec;
+    if (entryName.back() == '/') {
+        if (!directories.Ensure(outputPath.parent_path(), ec)) {
+            return Fail("ZIP extraction error: " + ec.message());
+        }
+        // directories carry no data, at most an empty stored body and its descriptor
+        if (compressedSize != 0 || (method != kMethodStored && (flags & kFlagDataDescriptor))) {
+            return Fail("ZIP directory entry with data cannot be streamed: " + entryName, true);
+        }
+        state = (flags & kFlagDataDescriptor) ? State::Descriptor : State::Signature;
+        return true;
+    }
+    if (!directories.Ensure(outputPath.parent_path(), ec)) {
+        return Fail("ZIP extraction error: " + ec.message());
+    }
+
+    // a stored file with a trailing descriptor has no length we can find without the central directory
+    if (method == kMethodStored && (flags & kFlagDataDescriptor)) {
+        return Fail("Stored ZIP entry without a size cannot be streamed: " + entryName, true);
+    }
+
+    // the store can only vouch for content by its sha256, which a stream has once the bytes have
+    // gone by: every entry is written, and kept in the store for the next extraction from a file
+    bool sizeKnown = !(flags & kFlagDataDescriptor);
+    if (store) {
+        // the old file may be a hardlink to a blob, never write through it
+        std::filesystem::remove(outputPath, ec);
+        hasher = Sha256();
+    }
+
+    writtenCrc = 0;
+    writtenSize = 0;
+    if (!output.Open(outputPath, sizeKnown ? static_cast<int64_t>(uncompressedSize) : -1)) {
+        return Fail("Failed to open file for writing: " + outputPath.string());
+    }
+
+    if (method == kMethodDeflated && !inflater.Begin()) {
+        return Fail("Failed to initialize inflate");
+    }
+
+    state = State::Data;
+    if (method == kMethodStored && compressedRemaining == 0) {
+        return EndEntry();
+    }
+    return true;
+}
+
+bool StreamingZipExtractor::WriteData(const char* data, size_t size) {
+    if (!output.Write(data, size)) {
+        return Fail("Failed writing " + entryName + " (disk full?)");
+    }
+    TrackWritten(reinterpret_cast<const unsigned char*>(data), size);
+    return true;
+}
+
+void StreamingZipExtractor::TrackWritten(const unsigned char* data, size_t size) {
+    writtenCrc = Crc32Update(writtenCrc, data, size);
+    writtenSize += size;
+    if (store) hasher.Update(data, size);
+}
+
+bool StreamingZipExtractor::EndEntry() {
+    bool written = output.IsOpen();
+    if (written && !output.Close()) {
+        return Fail("Failed writing " + entryName + " (disk full?)");
+    }
+    ++entriesWritten;
+    pending.clear();
+
+    // a trailing descriptor carries the crc, the entry is checked and adopted once that has been read
+    verifyPending = written;
+    adoptPending = store && written;
+    if (!(flags & kFlagDataDescriptor)) {
+        if (verifyPending && !VerifyEntry()) return false;
+        if (adoptPending) AdoptEntry();
+    }
+    state = (flags & kFlagDataDescriptor) ? State::Descriptor : State::Signature;
+    return true;
+}
+
+// what went to disk against the crc32 and size the archive recorded for it
+bool StreamingZipExtractor::VerifyEntry() {
+    verifyPending = false;
+    if (writtenSize != uncompressedSize) {
+        return Fail("Corrupt ZIP stream: size mismatch in " + entryName);
+    }
+    if (writtenCrc != crc32) {
+        return Fail("Corrupt ZIP stream: CRC mismatch in " + entryName);
+    }
+    return true;
+}
+
+void StreamingZipExtractor::AdoptEntry() {
+    adoptPending = false;
+    store->Adopt(entryName, crc32, uncompressedSize, extractPath / entryName, Sha256::ToHex(hasher.Final()));
+}
+
+bool StreamingZipExtractor::Feed(const char* data, size_t size) {
+    size_t pos = 0;
+
+    while (pos < size) {
+        switch (state) {
+        case State::Done:
+            return true; // central directory and beyond, nothing left to extract
+
+        case State::Failed:
+            return false;
+
+        case State::Signature: {
+            if (!Need(data, size, pos, 4)) return true;
+            uint32_t signature = ReadLE32(pending.data());
+            if (signature == kLocalHeaderSignature) {
+                state = State::LocalHeader;
+            } else if (signature == kCentralHeaderSignature || signature == kEndOfCentralDirSignature) {
+                state = State::Done;
+            } else {
+                return Fail("Corrupt ZIP stream: unexpected record signature");
+            }
+            break;
+        }
+
+        case State::LocalHeader:
+            if (!Need(data, size, pos, kLocalHeaderSize)) return true;
+            state = State::NameExtra;
+            break;
+
+        case State::NameExtra: {
+            size_t headerSize = kLocalHeaderSize + ReadLE16(pending.data() + 26) + ReadLE16(pending.data() + 28);
+            if (!Need(data, size, pos, headerSize)) return true;
+            if (!BeginEntry()) return false;
+            break;
+        }
+
+        case State::Data: {
+            size_t available = size - pos;
+            bool sizeKnown = !(flags & kFlagDataDescriptor);
+            if (sizeKnown && compressedRemaining < available) {
+                available = static_cast<size_t>(compressedRemaining);
+            }
+
+            if (method == kMethodStored) {
+                if (!WriteData(data + pos, available)) return false;
+                pos += available;
+                compressedRemaining -= available;
+                if (compressedRemaining == 0 && !EndEntry()) return false;
+                break;
+            }
+
+            const unsigned char* input = reinterpret_cast<const unsigned char*>(data + pos);
+            size_t consumed = 0;
+            InflateResult result = InflateResult::More;
+            size_t room = 0;
+            size_t produced = 0;
+            do {
+                // inflate straight into the output buffer, the input arrives in whatever pieces the network gave
+                unsigned char* space = output.Space(room);
+                if (!space) return Fail("Failed writing " + entryName + " (disk full?)");
+                size_t used = 0;
+                result = inflater.Step(input + consumed, available - consumed, used, space, room, produced);
+                if (result == InflateResult::Corrupt) {
+                    return Fail("Corrupt ZIP stream: inflate failed in " + entryName);
+                }
+                consumed += used;
+                output.Produced(produced);
+                TrackWritten(space, produced);
+            } while (produced == room && result != InflateResult::Done);
+
+            pos += consumed;
+            if (sizeKnown) compressedRemaining -= consumed;
+
+            if (result == InflateResult::Done) {
+                if (sizeKnown && compressedRemaining != 0) {
+                    return Fail("Corrupt ZIP stream: size mismatch in " + entryName);
+                }
+                if (!EndEntry()) return false;
+            } else if (sizeKnown && compressedRemaining == 0) {
+                return Fail("Corrupt ZIP stream: truncated entry " + entryName);
+            }
+            break;
+        }
+
+        case State::Descriptor: {
+            // optional signature, then crc32 + compressed + uncompressed size (8 bytes each for zip64)
+            if (!Need(data, size, pos, 4)) return true;
+            size_t descriptorSize = zip64 ? 20 : 12;
+            if (ReadLE32(pending.data()) == kDescriptorSignature) descriptorSize += 4;
+            if (!Need(data, size, pos, descriptorSize)) return true;
+            if (verifyPending) {
+                const char* descriptor = pending.data() + descriptorSize - (zip64 ? 20 : 12);
+                crc32 = ReadLE32(descriptor);
+                uncompressedSize = zip64 ? ReadLE64(descriptor + 12) : ReadLE32(descriptor + 8);
+                if (!VerifyEntry()) return false;
+                if (adoptPending) AdoptEntry();
+            }
+            pending.clear();
+            state = State::Signature;
+            break;
+        }
+        }
+    }
+
+    return state != State::Failed;
+}
+
+bool StreamingZipExtractor::Finish() {
+    if (state == State::Done) return true;
+    if (state == State::Failed) return false;
+    return Fail("ZIP stream ended before the central directory");
+}
+
+// runs tasks [0, count) on threadCount workers. each worker owns a deque seeded round-robin,
+// takes from its front and steals from the back of the others when it runs dry. finish runs
+// on each worker's own thread once there's nothing left to take
+static void RunWorkStealing(size_t count, unsigned threadCount, const std::function<void(unsigned, size_t)>& task,
+    const std::function<void(unsigned)>& finish = nullptr) {
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+    
+    std::vector<WorkQueue> queues(threadCount);
+    for (size_t i = 0; i < count; ++i) {
+        queues[i % threadCount].items.push_back(i);
+    }
+    
+    auto worker = [&](unsigned self) {
+        for (;;) {
+            size_t item = 0;
+            bool found = false;
+            
+            {
+                std::lock_guard<std::mutex> guard(queues[self].lock);
+                if (!queues[self].items.empty()) {
+                    item = queues[self].items.front();
+                    queues[self].items.pop_front();
+                    found = true;
+                }
+            }
+            
+            for (unsigned offset = 1; !found && offset < threadCount; ++offset) {
+                WorkQueue& victim = queues[(self + offset) % threadCount];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.items.empty()) {
+                    item = victim.items.back();
+                    victim.items.pop_back();
+                    found = true;
+                }
+            }
+            
+            // nothing is ever queued after start, so empty everywhere means done
+            if (!found) {
+                if (finish) finish(self);
+                return;
+            }
+            task(self, item);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+MappedZipArchive::~MappedZipArchive() {
+    Close();
+}
+
+void MappedZipArchive::Close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle && fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data) munmap(const_cast<unsigned char*>(data), static_cast<size_t>(size));
+    if (fd >= 0) close(fd);
+#endif
+    data = nullptr;
+    size = 0;
+    fd = -1;
+    entries.clear();
+}
+
+bool MappedZipArchive::Open(const std::string& path, std::string& error) {
+    Close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER fileSize = {};
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        error = "Failed to open ZIP archive";
+        return false;
+    }
+    mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle) {
+        data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st = {};
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        Close();
+        error = "Failed to open ZIP archive";
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped != MAP_FAILED) {
+        data = static_cast<const unsigned char*>(mapped);
+        madvise(mapped, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    }
+    size = static_cast<uint64_t>(st.st_size);
+#endif
+
+    if (!data) {
+        Close();
+        error = "Failed to map ZIP archive";
+        return false;
+    }
+    if (!ParseCentralDirectory(error)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedZipArchive::ParseCentralDirectory(std::string& error) {
+    const char* base = reinterpret_cast<const char*>(data);
+
+    // the end record sits in the last 22 bytes plus an optional comment of up to 64 KB
+    if (size < kEndOfCentralDirSize) {
+        error = "Corrupt ZIP archive: file too small";
+        return false;
+    }
+    uint64_t eocd = 0;
+    bool found = false;
+    uint64_t lowest = size > kEndOfCentralDirSize + 0xFFFF ? size - kEndOfCentralDirSize - 0xFFFF : 0;
+    for (uint64_t pos = size - kEndOfCentralDirSize + 1; pos-- > lowest;) {
+        if (ReadLE32(base + pos) == kEndOfCentralDirSignature) {
+            eocd = pos;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        error = "Corrupt ZIP archive: end of central directory not found";
+        return false;
+    }
+
+    uint64_t entryCount = ReadLE16(base + eocd + 10);
+    uint64_t directorySize = ReadLE32(base + eocd + 12);
+    uint64_t directoryOffset = ReadLE32(base + eocd + 16);
+
+    // zip64 archives point at a bigger end record through a locator right before the classic one
+    if (eocd >= 20 && ReadLE32(base + eocd - 20) == kZip64LocatorSignature) {
+        uint64_t zip64End = ReadLE64(base + eocd - 20 + 8);
+        if (zip64End <= size && 56 <= size - zip64End && ReadLE32(base + zip64End) == kZip64EndOfCentralDirSignature) {
+            entryCount = ReadLE64(base + zip64End + 32);
+            directorySize = ReadLE64(base + zip64End + 40);
+            directoryOffset = ReadLE64(base + zip64End + 48);
+        }
+    }
+
+    if (directoryOffset > size || directorySize > size - directoryOffset) {
+        error = "Corrupt ZIP archive: central directory out of bounds";
+        return false;
+    }
+
+    entries.clear();
+    entries.reserve(static_cast<size_t>((std::min)(entryCount, directorySize / kCentralHeaderSize)));
+
+    uint64_t pos = directoryOffset;
+    uint64_t end = directoryOffset + directorySize;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        if (pos + kCentralHeaderSize > end || ReadLE32(base + pos) != kCentralHeaderSignature) {
+            error = "Corrupt ZIP archive: bad central directory entry";
+            return false;
+        }
+        const char* header = base + pos;
+        uint16_t nameLength = ReadLE16(header + 28);
+        uint16_t extraLength = ReadLE16(header + 30);
+        uint16_t commentLength = ReadLE16(header + 32);
+        if (pos + kCentralHeaderSize + nameLength + extraLength + commentLength > end) {
+            error = "Corrupt ZIP archive: central directory entry out of bounds";
+            return false;
+        }
+
+        Entry entry;
+        entry.flags = ReadLE16(header + 8);
+        entry.method = ReadLE16(header + 10);
+        entry.crc32 = ReadLE32(header + 16);
+        entry.compressedSize = ReadLE32(header + 20);
+        entry.uncompressedSize = ReadLE32(header + 24);
+        uint64_t localOffset = ReadLE32(header + 42);
+        entry.name.assign(header + kCentralHeaderSize, nameLength);
+
+        // zip64 extra field holds whichever of the three values were saturated, in this order
+        const char* extra = header + kCentralHeaderSize + nameLength;
+        for (size_t offset = 0; offset + 4 <= extraLength;) {
+            uint16_t id = ReadLE16(extra + offset);
+            uint16_t length = ReadLE16(extra + offset + 2);
+            if (offset + 4 + length > extraLength) break;
+            if (id == 0x0001) {
+                const char* field = extra + offset + 4;
+                size_t used = 0;
+                if (entry.uncompressedSize == 0xFFFFFFFF && used + 8 <= length) { entry.uncompressedSize = ReadLE64(field + used); used += 8; }
+                if (entry.compressedSize == 0xFFFFFFFF && used + 8 <= length) { entry.compressedSize = ReadLE64(field + used); used += 8; }
+                if (localOffset == 0xFFFFFFFF && used + 8 <= length) { localOffset = ReadLE64(field + used); used += 8; }
+            }
+            offset += 4 + length;
+        }
+
+        // the local header repeats name and extra with its own lengths, the data starts after them
+        if (localOffset > size || kLocalHeaderSize > size - localOffset || ReadLE32(base + localOffset) != kLocalHeaderSignature) {
+            error = "Corrupt ZIP archive: bad local header for " + entry.name;
+            return false;
+        }
+        entry.dataOffset = localOffset + kLocalHeaderSize + ReadLE16(base + localOffset + 26) + ReadLE16(base + localOffset + 28);
+        if (entry.dataOffset > size || entry.compressedSize > size - entry.dataOffset) {
+            error = "Corrupt ZIP archive: entry data out of bounds for " + entry.name;
+            return false;
+        }
+
+        entries.push_back(std::move(entry));
+        pos += kCentralHeaderSize + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+// per-worker scratch state, reused across entries
+struct ExtractWorker {
+    Inflater inflater;
+    std::vector<unsigned char> whole; // entries inflated in one go that don't fit the output buffer
+    std::vector<unsigned char> scratch; // inflated only to be hashed
+    OutputFile output;
+    std::unique_ptr<UringFileWriter> ring; // ExtractIo::IoUring and the kernel took it
+    bool ringTried = false;
+};
+
+static bool MappedEntrySupported(const MappedZipArchive::Entry& entry, std::string& error) {
+    if (entry.flags & kFlagEncrypted) {
+        error = "Encrypted ZIP entries are not supported: " + entry.name;
+        return false;
+    }
+    if (entry.method != kMethodStored && entry.method != kMethodDeflated) {
+        error = "Unsupported ZIP compression method in " + entry.name;
+        return false;
+    }
+    return true;
+}
+
+// stored entries go straight from the mapping (or kernel to kernel on Linux), deflated ones
+// are inflated from the mapping with no intermediate read buffer
+static bool ExtractMappedEntry(const MappedZipArchive& archive, const MappedZipArchive::Entry& entry,
+    const std::filesystem::path& outputPath, ExtractWorker& worker, Sha256* hasher, std::string& error) {
+    if (!MappedEntrySupported(entry, error)) return false;
+
+    OutputFile& output = worker.output;
+    if (!output.Open(outputPath, static_cast<int64_t>(entry.uncompressedSize))) {
+        error = "Failed to open file for writing: " + outputPath.string();
+        return false;
+    }
+
+    const unsigned char* source = archive.Data() + entry.dataOffset;
+    bool ok = true;
+    uint32_t crc = 0;
+    uint64_t written = 0;
+
+    if (entry.method == kMethodStored) {
+        // a stored entry is its own output, the crc comes off the mapping whichever way the copy goes
+        crc = Crc32Update(crc, source, static_cast<size_t>(entry.compressedSize));
+        written = entry.compressedSize;
+        if (hasher) hasher->Update(source, static_cast<size_t>(entry.compressedSize));
+        uint64_t remaining = entry.compressedSize;
+#ifdef __linux__
+        // nothing buffered in output yet, so its descriptor can take the copy directly
+        off64_t inputOffset = static_cast<off64_t>(entry.dataOffset);
+        while (remaining > 0) {
+            ssize_t copied = copy_file_range(archive.FileDescriptor(), &inputOffset, output.Descriptor(), nullptr, static_cast<size_t>(remaining), 0);
+            if (copied <= 0) break; // EXDEV/ENOSYS/EINVAL etc, finish from the mapping
+            remaining -= static_cast<uint64_t>(copied);
+        }
+        source += entry.compressedSize - remaining;
+#endif
+        ok = output.Write(source, static_cast<size_t>(remaining));
+    } else if (Inflater::PrefersWhole(entry.uncompressedSize)) {
+        // the whole entry in one call, into the output buffer when it fits there
+        size_t size = static_cast<size_t>(entry.uncompressedSize);
+        size_t room = 0;
+        unsigned char* target = output.Space(room);
+        bool inPlace = size <= room;
+        if (!inPlace) {
+            if (worker.whole.size() < size) worker.whole.resize(size);
+            target = worker.whole.data();
+        }
+        InflateResult result = worker.inflater.Whole(source, static_cast<size_t>(entry.compressedSize), target, size);
+        if (result != InflateResult::Done) {
+            output.Close();
+            error = (result == InflateResult::WrongSize ? "Corrupt ZIP entry: size mismatch in " : "Corrupt ZIP entry: ") + entry.name;
+            return false;
+        }
+        if (inPlace) {
+            output.Produced(size);
+        } else {
+            ok = output.Write(target, size);
+        }
+        crc = Crc32Update(crc, target, size);
+        written = size;
+        if (hasher) hasher->Update(target, size);
+    } else {
+        if (!worker.inflater.Begin()) {
+            output.Close();
+            error = "Failed to initialize inflate";
+            return false;
+        }
+
+        uint64_t offset = 0;
+        InflateResult result = InflateResult::More;
+        while (result == InflateResult::More) {
+            // inflate straight into the output buffer, a full one goes to disk on the next Space
+            size_t room = 0;
+            unsigned char* space = output.Space(room);
+            if (!space) {
+                output.Close();
+                error = "Failed writing " + outputPath.string() + " (disk full?)";
+                return false;
+            }
+            size_t consumed = 0;
+            size_t produced = 0;
+            result = worker.inflater.Step(source + offset, static_cast<size_t>(entry.compressedSize - offset), consumed, space, room, produced);
+            offset += consumed;
+            output.Produced(produced);
+            crc = Crc32Update(crc, space, produced);
+            written += produced;
+            if (hasher) hasher->Update(space, produced);
+            if (result == InflateResult::More && consumed == 0 && produced == 0) {
+                result = InflateResult::Corrupt; // ran out of input before the deflate stream ended
+            }
+        }
+        if (result != InflateResult::Done) {
+            output.Close();
+            error = "Corrupt ZIP entry: " + entry.name;
+            return false;
+        }
+    }
+
+    if (!output.Close() || !ok) {
+        error = "Failed writing " + outputPath.string() + " (disk full?)";
+        return false;
+    }
+    if (written != entry.uncompressedSize) {
+        error = "Corrupt ZIP entry: size mismatch in " + entry.name;
+        return false;
+    }
+    if (crc != entry.crc32) {
+        error = "Corrupt ZIP entry: CRC mismatch in " + entry.name;
+        return false;
+    }
+    return true;
+}
+
+// the sha256 of what the entry extracts to, without writing it anywhere. false if it doesn't
+// inflate cleanly to its size, extracting it then reports what's wrong
+static bool HashMappedEntry(const MappedZipArchive& archive, const MappedZipArchive::Entry& entry, ExtractWorker& worker, std::string& sha256) {
+    std::string unused;
+    if (!MappedEntrySupported(entry, unused)) return false;
+
+    const unsigned char* source = archive.Data() + entry.dataOffset;
+    Sha256 hasher;
+    if (entry.method == kMethodStored) {
+        if (entry.compressedSize != entry.uncompressedSize) return false;
+        hasher.Update(source, static_cast<size_t>(entry.compressedSize));
+    } else {
+        if (!worker.inflater.Begin()) return false;
+        if (worker.scratch.empty()) worker.scratch.resize(256 * 1024);
+        uint64_t offset = 0;
+        uint64_t produced = 0;
+        InflateResult result = InflateResult::More;
+        while (result == InflateResult::More) {
+            size_t consumed = 0;
+            size_t made = 0;
+            result = worker.inflater.Step(source + offset, static_cast<size_t>(entry.compressedSize - offset), consumed,
+                worker.scratch.data(), worker.scratch.size(), made);
+            offset += consumed;
+            produced += made;
+            hasher.Update(worker.scratch.data(), made);
+            if (result == InflateResult::More && consumed == 0 && made == 0) return false;
+        }
+        if (result != InflateResult::Done || produced != entry.uncompressedSize) return false;
+    }
+    sha256 = Sha256::ToHex(hasher.Final());
+    return true;
+}
+
+// a small entry on the io_uring path: built whole in one of the ring's buffers and checked
+// there, so a corrupt entry never reaches the disk. the file itself is written later, when the
+// ring gets to it, and only then does it go into the store
+static bool QueueMappedEntry(const MappedZipArchive& archive, const MappedZipArchive::Entry& entry,
+    const std::filesystem::path& outputPath, ExtractWorker& worker, ContentStore* store, std::string& error) {
+    if (!MappedEntrySupported(entry, error)) return false;
+
+    unsigned char* buffer = worker.ring->Buffer();
+    if (!buffer) {
+        worker.ring->Drain(error);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(entry.uncompressedSize);
+    const unsigned char* source = archive.Data() + entry.dataOffset;
+    if (entry.method == kMethodStored) {
+        if (entry.compressedSize != entry.uncompressedSize) {
+            error = "Corrupt ZIP entry: size mismatch in " + entry.name;
+            return false;
+        }
+        memcpy(buffer, source, size);
+    } else {
+        InflateResult result = worker.inflater.Whole(source, static_cast<size_t>(entry.compressedSize), buffer, size);
+        if (result != InflateResult::Done) {
+            error = (result == InflateResult::WrongSize ? "Corrupt ZIP entry: size mismatch in " : "Corrupt ZIP entry: ") + entry.name;
+            return false;
+        }
+    }
+
+    uint32_t crc = Crc32Update(0, buffer, size);
+    if (crc != entry.crc32) {
+        error = "Corrupt ZIP entry: CRC mismatch in " + entry.name;
+        return false;
+    }
+
+    std::function<void()> done;
+    if (store) {
+        Sha256 hasher;
+        hasher.Update(buffer, size);
+        done = [store, name = entry.name, crc, size = entry.uncompressedSize, outputPath, sha256 = Sha256::ToHex(hasher.Final())]() {
+            store->Adopt(name, crc, size, outputPath, sha256);
+        };
+    }
+    if (!worker.ring->Queue(outputPath.string(), size, std::move(done))) {
+        worker.ring->Drain(error);
+        return false;
+    }
+    return true;
+}
+
+bool ExtractZipParallel(const std::string& zipPath, const std::string& extractPath, unsigned threadCount, std::string& error,
+    ContentStore* store, ExtractIo io) {
+    MappedZipArchive archive;
+    if (!archive.Open(zipPath, error)) {
+        return false;
+    }
+
+    const std::vector<MappedZipArchive::Entry>& entries = archive.Entries();
+    std::vector<size_t> jobs;
+    std::vector<std::filesystem::path> outputPaths(entries.size());
+
+    // directories first and on one thread, so workers only ever write files into folders that exist
+    try {
+        std::set<std::filesystem::path> directories;
+        std::unordered_map<std::string, size_t> jobByPath; // a name listed twice is written once, the last one wins
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const MappedZipArchive::Entry& entry = entries[i];
+            if (!IsSafeEntryName(entry.name)) {
+                error = "ZIP entry has an unsafe path: " + entry.name;
+                return false;
+            }
+
+            outputPaths[i] = std::filesystem::path(extractPath) / entry.name;
+            if (entry.IsDirectory()) {
+                directories.insert(outputPaths[i].parent_path()); // "dir/" -> dir
+                continue;
+            }
+
+            directories.insert(outputPaths[i].parent_path());
+            auto listed = jobByPath.emplace(outputPaths[i].lexically_normal().generic_string(), jobs.size());
+            if (listed.second) jobs.push_back(i);
+            else jobs[listed.first->second] = i;
+        }
+
+        // sorted, so every parent is made before its children and each folder costs one mkdir
+        DirectoryCache created(extractPath);
+        for (const std::filesystem::path& directory : directories) {
+            std::error_code ec;
+            if (!created.Ensure(directory, ec)) {
+                error = "ZIP extraction error: " + ec.message() + ": " + directory.string();
+                return false;
+            }
+        }
+    } catch (const std::exception& e) {
+        error = std::string("ZIP extraction error: ") + e.what();
+        return false;
+    }
+
+    // biggest entries first so one large inflate doesn't end up last on a single worker
+    std::sort(jobs.begin(), jobs.end(), [&](size_t a, size_t b) { return entries[a].uncompressedSize > entries[b].uncompressedSize; });
+
+    if (threadCount == 0) threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned>((std::min)(static_cast<size_t>(threadCount), (std::max)(jobs.size(), static_cast<size_t>(1))));
+
+    std::vector<ExtractWorker> workers(threadCount);
+    std::atomic<bool> failed = false;
+    std::mutex errorLock;
+
+
+    RunWorkStealing(jobs.size(), threadCount, [&](unsigned worker, size_t item) {
+        if (failed) return;
+        size_t index = jobs[item];
+
+        const MappedZipArchive::Entry& entry = entries[index];
+        ExtractWorker& state = workers[worker];
+        if (store) {
+            // crc32 and size only say the store may have it, the content's sha256 decides
+            std::string sha256;
+            if (store->Candidate(entry.name, entry.crc32, entry.uncompressedSize) && HashMappedEntry(archive, entry, state, sha256) &&
+                (store->Unchanged(entry.name, entry.crc32, entry.uncompressedSize, sha256, outputPaths[index]) ||
+                 store->LinkFromStore(entry.name, entry.crc32, entry.uncompressedSize, sha256, outputPaths[index]))) {
+                return;
+            }
+            // the old file may be a hardlink to a blob, never write through it
+            std::error_code ec;
+            std::filesystem::remove(outputPaths[index], ec);
+        }
+
+        // each worker sets up its ring on its own thread, the requests belong to whoever submits them
+        if (io == ExtractIo::IoUring && !state.ringTried) {
+            state.ringTried = true;
+            state.ring = std::make_unique<UringFileWriter>();
+            if (!state.ring->Start()) state.ring.reset(); // no io_uring here, write synchronously
+        }
+
+        std::string entryError;
+        if (state.ring && entry.uncompressedSize <= UringFileWriter::kBufferSize) {
+            if (!QueueMappedEntry(archive, entry, outputPaths[index], workers[worker], store, entryError)) {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!failed.exchange(true)) error = entryError;
+            }
+            return;
+        }
+
+        Sha256 hasher;
+        if (!ExtractMappedEntry(archive, entry, outputPaths[index], state, store ? &hasher : nullptr, entryError)) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!failed.exchange(true)) error = entryError;
+            return;
+        }
+        if (store) {
+            store->Adopt(entry.name, entry.crc32, entry.uncompressedSize, outputPaths[index], Sha256::ToHex(hasher.Final()));
+        }
+    }, [&](unsigned worker) {
+        // what the ring still has in flight, also after a failure, before this thread exits
+        std::string ringError;
+        if (workers[worker].ring && !workers[worker].ring->Drain(ringError)) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!failed.exchange(true)) error = ringError;
+        }
+    });
+
+    return !failed;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "inflater.h"
+#include "sha256.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class ContentStore;
+
+// false for entry names that would land outside the extraction folder (absolute, drive, "..")
+bool IsSafeEntryName(const std::string& name);
+
+// directories known to exist under an extraction root. each one costs a single mkdir the first
+// time it's asked for and nothing after, instead of create_directories stat'ing every parent per entry
+class DirectoryCache {
+public:
+    explicit DirectoryCache(const std::filesystem::path& root) : root(root) {}
+
+    bool Ensure(const std::filesystem::path& directory, std::error_code& ec);
+
+private:
+    std::filesystem::path root;
+    std::unordered_set<std::string> known;
+};
+
+// write side of one extracted file: a large page-aligned buffer handed straight to the
+// inflater, plain write()/WriteFile underneath, and the file preallocated to its final size
+// so the filesystem can lay it out in one go. reused across entries, the buffer is allocated once
+class OutputFile {
+public:
+    OutputFile() = default;
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    // expectedSize < 0 when unknown, nothing is preallocated then
+    bool Open(const std::filesystem::path& path, int64_t expectedSize);
+
+    // room to produce output into directly, flushing the buffer first when it's full. null on a write error
+    unsigned char* Space(size_t& available);
+    void Produced(size_t size) { used += size; }
+
+    bool Write(const void* data, size_t size);
+
+    // flush and close, false if anything failed to reach the file
+    bool Close();
+
+    bool IsOpen() const;
+    int Descriptor() const { return fd; } // POSIX only, for copy_file_range. flush first
+
+    bool Flush();
+
+private:
+    bool WriteThrough(const unsigned char* data, size_t size);
+    void Discard();
+
+    int fd = -1;
+#ifdef _WIN32
+    void* handle = nullptr;
+#endif
+    unsigned char* buffer = nullptr;
+    size_t used = 0;
+    bool failed = false;
+};
+
+// decodes a zip archive as its bytes arrive and writes each entry under extractPath,
+// so the archive itself never has to land on disk. walks the local file headers in
+// stream order and stops at the central directory. with a store, every entry is written
+// and kept in it: only ExtractZipParallel can hash an entry before deciding to skip it
+class StreamingZipExtractor {
+public:
+    explicit StreamingZipExtractor(const std::string& extractPath, ContentStore* store = nullptr);
+    ~StreamingZipExtractor();
+
+    StreamingZipExtractor(const StreamingZipExtractor&) = delete;
+    StreamingZipExtractor& operator=(const StreamingZipExtractor&) = delete;
+
+    // feed the next chunk of the archive, false once the stream can't be decoded
+    bool Feed(const char* data, size_t size);
+
+    // true only if the stream reached the central directory, i.e. every entry was written
+    bool Finish();
+
+    const std::string& Error() const { return error; }
+    bool Unsupported() const { return unsupported; } // a layout that needs random access, extract from a file instead
+    size_t EntriesWritten() const { return entriesWritten; }
+
+private:
+    enum class State { Signature, LocalHeader, NameExtra, Data, Descriptor, Done, Failed };
+
+    bool Need(const char* data, size_t size, size_t& pos, size_t count);
+    bool BeginEntry();
+    bool WriteData(const char* data, size_t size);
+    bool EndEntry();
+    void TrackWritten(const unsigned char* data, size_t size);
+    bool VerifyEntry();
+    void AdoptEntry();
+    bool Fail(const std::string& message, bool layoutUnsupported = false);
+
+    std::filesystem::path extractPath;
+    DirectoryCache directories;
+    ContentStore* store = nullptr;
+    State state = State::Signature;
+    std::string pending; // header bytes collected across Feed calls
+
+    // current entry
+    std::string entryName;
+    uint16_t flags = 0;
+    uint16_t method = 0;
+    uint32_t crc32 = 0;
+    uint64_t uncompressedSize = 0;
+    uint64_t compressedRemaining = 0;
+    bool zip64 = false;
+    OutputFile output;
+    Inflater inflater;
+    bool verifyPending = false; // written, waiting for the descriptor's crc and size to check against
+    bool adoptPending = false;  // written, waiting for the descriptor's crc before it goes in the store
+    Sha256 hasher;
+    uint32_t writtenCrc = 0; // crc32 and length of what actually went to disk
+    uint64_t writtenSize = 0;
+
+    size_t entriesWritten = 0;
+    bool unsupported = false;
+    std::string error;
+};
+
+// read-only memory mapping of a zip file with its central directory parsed in place.
+// the mapping is shared by every extraction worker, entries are read straight out of it
+class MappedZipArchive {
+public:
+    struct Entry {
+        std::string name;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint32_t crc32 = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t dataOffset = 0; // first byte of the entry data, past its local header
+
+        bool IsDirectory() const { return !name.empty() && name.back() == '/'; }
+    };
+
+    MappedZipArchive() = default;
+    ~MappedZipArchive();
+
+    MappedZipArchive(const MappedZipArchive&) = delete;
+    MappedZipArchive& operator=(const MappedZipArchive&) = delete;
+
+    bool Open(const std::string& path, std::string& error);
+    void Close();
+
+    const std::vector<Entry>& Entries() const { return entries; }
+    const unsigned char* Data() const { return data; }
+    uint64_t Size() const { return size; }
+    int FileDescriptor() const { return fd; } // -1 on Windows, used for copy_file_range on Linux
+
+private:
+    bool ParseCentralDirectory(std::string& error);
+
+    const unsigned char* data = nullptr;
+    uint64_t size = 0;
+    int fd = -1;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    std::vector<Entry> entries;
+};
+
+// how ExtractZipParallel writes files. IoUring sends the small ones through batched io_uring
+// submissions on Linux, and quietly writes synchronously wherever io_uring isn't available
+enum class ExtractIo { Sync, IoUring };
+
+// extracts every entry of zipPath under extractPath. directories are created up front,
+// then file entries are spread over a work-stealing pool that reads from one shared mapping
+// of the archive. threadCount 0 = one worker per core. with a store, an entry whose sha256
+// (hashed from the mapping, nothing written) matches is skipped when unchanged and hardlinked from
+// the store when it's known content. every written entry is checked
+// against the crc32 and size in the central directory
+bool ExtractZipParallel(const std::string& zipPath, const std::string& extractPath, unsigned threadCount, std::string& error,
+    ContentStore* store = nullptr, ExtractIo io = ExtractIo::Sync);
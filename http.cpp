@@ -0,0 +1,508 @@
+#include "http.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+static const size_t kRecentRequests = 64;
+
+static CURLSH* g_Share = nullptr;
+static std::mutex g_ShareCreateLock;
+static std::mutex g_ShareLocks[CURL_LOCK_DATA_LAST];
+
+static std::mutex g_StatsLock;
+static HttpPoolStats g_Stats;
+
+static void LockShare(CURL*, curl_lock_data data, curl_lock_access, void*) {
+    g_ShareLocks[data].lock();
+}
+
+static void UnlockShare(CURL*, curl_lock_data data, void*) {
+    g_ShareLocks[data].unlock();
+}
+
+static CURLSH* SharedHandle() {
+    std::lock_guard<std::mutex> guard(g_ShareCreateLock);
+    if (!g_Share) {
+        g_Share = curl_share_init();
+        if (g_Share) {
+            curl_share_setopt(g_Share, CURLSHOPT_LOCKFUNC, LockShare);
+            curl_share_setopt(g_Share, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+            curl_share_setopt(g_Share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(g_Share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            // no CURL_LOCK_DATA_CONNECT: every client drives its handles from its own thread, and
+            // libcurl doesn't support a shared connection cache used that way. each client's
+            // multi handle keeps its own connections alive
+        }
+    }
+    return g_Share;
+}
+
+void HttpPoolAttach(CURL* curl) {
+    CURLSH* share = SharedHandle();
+    if (share) curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // handles run on worker threads
+}
+
+static double Milliseconds(curl_off_t microseconds) {
+    return static_cast<double>(microseconds) / 1000.0;
+}
+
+void HttpPoolRecord(CURL* curl) {
+    HttpRequestTiming timing;
+    long connects = 0;
+    curl_off_t connectTime = 0, tlsTime = 0, firstByteTime = 0, totalTime = 0;
+    char* url = nullptr;
+
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectTime);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tlsTime);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByteTime);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalTime);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &timing.httpCode);
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+
+    if (url) {
+        timing.url = url;
+        timing.url = timing.url.substr(0, timing.url.find('?'));
+    }
+    timing.newConnection = connects > 0;
+    timing.tlsHandshake = tlsTime > 0;
+    timing.connectMs = Milliseconds(connectTime);
+    timing.tlsMs = tlsTime > 0 ? Milliseconds(tlsTime - connectTime) : 0.0;
+    timing.firstByteMs = Milliseconds(firstByteTime);
+    timing.totalMs = Milliseconds(totalTime);
+
+    std::lock_guard<std::mutex> guard(g_StatsLock);
+    ++g_Stats.requests;
+    g_Stats.connections += static_cast<uint64_t>(connects);
+    if (timing.tlsHandshake) ++g_Stats.tlsHandshakes;
+    g_Stats.totalMs += timing.totalMs;
+    g_Stats.maxMs = (std::max)(g_Stats.maxMs, timing.totalMs);
+
+    if (g_Stats.recent.size() == kRecentRequests) {
+        g_Stats.recent.erase(g_Stats.recent.begin());
+    }
+    g_Stats.recent.push_back(std::move(timing));
+}
+
+HttpPoolStats HttpPoolGetStats() {
+    std::lock_guard<std::mutex> guard(g_StatsLock);
+    return g_Stats;
+}
+
+std::string HttpPoolReport() {
+    HttpPoolStats stats = HttpPoolGetStats();
+    std::string report;
+    char line[512];
+
+    for (const HttpRequestTiming& timing : stats.recent) {
+        snprintf(line, sizeof(line), "[http] %ld %s%s connect %.1fms tls %.1fms first byte %.1fms total %.1fms\n",
+            timing.httpCode, timing.url.c_str(), timing.newConnection ? " (new connection)" : " (reused)",
+            timing.connectMs, timing.tlsMs, timing.firstByteMs, timing.totalMs);
+        report += line;
+    }
+
+    snprintf(line, sizeof(line), "[http] %llu requests, %llu connections, %llu TLS handshakes, avg %.1fms, max %.1fms\n",
+        static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.connections),
+        static_cast<unsigned long long>(stats.tlsHandshakes),
+        stats.requests > 0 ? stats.totalMs / static_cast<double>(stats.requests) : 0.0, stats.maxMs);
+    report += line;
+    return report;
+}
+
+std::string HttpResponse::Header(const std::string& name) const {
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    auto found = headers.find(key);
+    return found != headers.end() ? found->second : "";
+}
+
+// never trust a Content-Length this big enough to reserve for it up front
+static const uint64_t kMaxBodyReserve = 256ull << 20;
+
+struct HttpClient::Transfer {
+    HttpRequest request;
+    HttpResponse response;
+    std::promise<HttpResponse> promise;
+    CURL* curl = nullptr;
+    struct curl_slist* headers = nullptr;
+    char errorBuffer[CURL_ERROR_SIZE] = {};
+};
+
+static size_t TransferWrite(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    HttpRequest& request = *static_cast<HttpRequest*>(userdata);
+    size_t bytes = size * nmemb;
+    if (request.onData) {
+        return request.onData(ptr, bytes) ? bytes : 0;
+    }
+    return bytes;
+}
+
+static size_t TransferWriteBody(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    static_cast<std::string*>(userdata)->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+static size_t TransferHeader(char* buffer, size_t size, size_t nitems, void* userdata) {
+    HttpClient::Transfer& transfer = *static_cast<HttpClient::Transfer*>(userdata);
+    std::map<std::string, std::string>& headers = transfer.response.headers;
+    size_t bytes = size * nitems;
+    std::string_view line(buffer, bytes);
+
+    // every status line starts a new response (redirects, 100-continue), keep only the last one's headers
+    if (line.substr(0, 5) == "HTTP/") {
+        headers.clear();
+        return bytes;
+    }
+
+    // end of the headers: size the body once from Content-Length instead of growing it chunk by chunk
+    if (line == "\r\n" || line == "\n") {
+        auto length = headers.find("content-length");
+        if (length != headers.end() && !transfer.request.onData && transfer.request.method != "HEAD") {
+            uint64_t expected = std::strtoull(length->second.c_str(), nullptr, 10);
+            if (expected > 0 && expected <= kMaxBodyReserve) {
+                transfer.response.body.reserve(static_cast<size_t>(expected));
+            }
+        }
+        return bytes;
+    }
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) return bytes;
+
+    std::string name(line.substr(0, colon));
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    size_t start = line.find_first_not_of(" \t", colon + 1);
+    size_t end = line.find_last_not_of(" \t\r\n");
+    headers[name] = (start == std::string_view::npos || end == std::string_view::npos || end < start) ?
+        std::string() : std::string(line.substr(start, end - start + 1));
+    return bytes;
+}
+
+static const double kMinTransferRate = 1024.0;      // bytes/s, anything slower counts as stalled
+static const double kRateTimeConstant = 3.0;       // seconds the moving average looks back, roughly
+static const double kStallBytes = 1024.0 * 1024;  // a stall window is the time the link needed for this much
+static const double kMinStallWindow = 4.0;
+static const double kMaxStallWindow = 20.0;
+
+TransferWatchdog::TransferWatchdog(curl_off_t expectedBytes, double expectedBytesPerSec)
+    : expected(expectedBytes), start(Clock::now()), lastSample(start) {
+    // until the link is measured assume it does at least 64 KB/s, with plenty of slack
+    if (expected > 0) {
+        double rate = expectedBytesPerSec > 0.0 ? expectedBytesPerSec : 64.0 * 1024;
+        deadline = (std::max)(120.0, expected / rate * 4.0 + 30.0);
+    }
+}
+
+bool TransferWatchdog::Check(curl_off_t received) {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - start).count();
+    if (deadline > 0.0 && elapsed > deadline) {
+        overdue = true;
+        return false;
+    }
+
+    double interval = std::chrono::duration<double>(now - lastSample).count();
+    if (interval < 0.25) return true;
+
+    double sample = (received - lastBytes) / interval;
+    double weight = 1.0 - std::exp(-interval / kRateTimeConstant);
+    averageRate += (sample - averageRate) * weight;
+    peakRate = (std::max)(peakRate, averageRate);
+    lastBytes = received;
+    lastSample = now;
+
+    // after a few seconds the observed rate replaces the guess: 4x what the rest should take, plus slack
+    if (!measured && elapsed >= 5.0 && averageRate > 0.0) {
+        measured = true;
+        if (expected > 0) {
+            deadline = (std::max)(60.0, elapsed + (expected - received) / averageRate * 4.0 + 30.0);
+        }
+    }
+
+    // slow means under 5% of the best this link has done; a fast link gets less time to come back
+    double floor = (std::max)(kMinTransferRate, peakRate / 20.0);
+    double window = peakRate > 0.0 ? (std::min)(kMaxStallWindow, (std::max)(kMinStallWindow, kStallBytes / peakRate)) : kMaxStallWindow;
+    if (averageRate >= floor) {
+        slow = false;
+    } else if (!slow) {
+        slow = true;
+        slowSince = now;
+    } else if (std::chrono::duration<double>(now - slowSince).count() > window) {
+        stalled = true;
+        return false;
+    }
+    return true;
+}
+
+static int TransferProgress(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t) {
+    HttpRequest* request = static_cast<HttpRequest*>(userdata);
+    if (request->cancel && *request->cancel) return 1;
+    if (request->watchdog && !request->watchdog->Check(dlnow)) return 1;
+    if (request->onProgress) request->onProgress(dltotal, dlnow);
+    return 0;
+}
+
+HttpClient::HttpClient() {
+    multi = curl_multi_init();
+    worker = std::thread(&HttpClient::Run, this);
+}
+
+HttpClient::~HttpClient() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    if (multi) curl_multi_wakeup(multi);
+    if (worker.joinable()) worker.join();
+    if (multi) curl_multi_cleanup(multi);
+}
+
+std::future<HttpResponse> HttpClient::Send(HttpRequest request) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    std::future<HttpResponse> future = transfer->promise.get_future();
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (stopping || !multi) {
+        transfer->response.result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->response.error = "HTTP client is shut down";
+        transfer->promise.set_value(std::move(transfer->response));
+        return future;
+    }
+    queued.push_back(std::move(transfer));
+    curl_multi_wakeup(multi);
+    return future;
+}
+
+void HttpClient::Start(std::unique_ptr<Transfer> transfer) {
+    const HttpRequest& request = transfer->request;
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        transfer->response.result = CURLE_FAILED_INIT;
+        transfer->response.error = "Failed to initialize CURL";
+        transfer->promise.set_value(std::move(transfer->response));
+        return;
+    }
+
+    for (const std::string& header : request.headers) {
+        transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+    }
+
+    HttpPoolAttach(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, request.userAgent.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, request.maxRedirects);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, request.verifyPeer ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, request.connectTimeout);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, request.timeout);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, request.lowSpeedLimit);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, request.lowSpeedTime);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer->errorBuffer);
+
+    if (!request.range.empty()) {
+        curl_easy_setopt(curl, CURLOPT_RANGE, request.range.c_str());
+    }
+    if (request.method == "HEAD") {
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    } else if (request.method != "GET") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size()));
+    }
+
+    if (request.onData) {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, TransferWrite);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->request);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, TransferWriteBody);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response.body);
+    }
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, TransferHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer.get());
+    if (request.onProgress || request.cancel || request.watchdog) {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, TransferProgress);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer->request);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    transfer->curl = curl;
+    if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+        Finish(transfer.get(), CURLE_FAILED_INIT);
+        return;
+    }
+    active[curl] = std::move(transfer);
+}
+
+void HttpClient::Finish(Transfer* transfer, CURLcode result) {
+    CURL* curl = transfer->curl;
+    HttpResponse& response = transfer->response;
+
+    response.result = result;
+    response.finishedAt = std::chrono::steady_clock::now();
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    if (result != CURLE_OK) {
+        response.error = transfer->errorBuffer[0] ? transfer->errorBuffer : curl_easy_strerror(result);
+    }
+    HttpPoolRecord(curl);
+
+    curl_multi_remove_handle(multi, curl);
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(transfer->headers);
+    transfer->promise.set_value(std::move(response));
+
+    active.erase(curl); // frees transfer when it was started
+}
+
+void HttpClient::Run() {
+    if (!multi) return;
+
+    for (;;) {
+        std::vector<std::unique_ptr<Transfer>> starting;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stopping) break;
+            starting.swap(queued);
+        }
+        for (auto& transfer : starting) {
+            Start(std::move(transfer));
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg = nullptr;
+        int pending = 0;
+        while ((msg = curl_multi_info_read(multi, &pending))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            auto found = active.find(msg->easy_handle);
+            if (found != active.end()) Finish(found->second.get(), msg->data.result);
+        }
+
+        curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+
+    // shutting down: whatever is still in flight or waiting fails instead of hanging its caller
+    while (!active.empty()) {
+        Finish(active.begin()->second.get(), CURLE_ABORTED_BY_CALLBACK);
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& transfer : queued) {
+        transfer->response.result = CURLE_ABORTED_BY_CALLBACK;
+        transfer->response.error = "HTTP client is shut down";
+        transfer->promise.set_value(std::move(transfer->response));
+    }
+    queued.clear();
+}
+
+static std::mutex g_ClientLock;
+static std::unique_ptr<HttpClient> g_DefaultClient;
+
+HttpClient& DefaultHttpClient() {
+    std::lock_guard<std::mutex> guard(g_ClientLock);
+    if (!g_DefaultClient) g_DefaultClient = std::make_unique<HttpClient>();
+    return *g_DefaultClient;
+}
+
+HttpRequestGroup::HttpRequestGroup(HttpClient& client)
+    : client(client), start(Clock::now()), cancel(std::make_shared<std::atomic<bool>>(false)) {
+}
+
+HttpRequestGroup::~HttpRequestGroup() {
+    // nobody is left to read the answers, the client finishes the aborted transfers on its own
+    Cancel();
+}
+
+int HttpRequestGroup::Send(const std::string& name, HttpRequest request, std::vector<int> after) {
+    if (!request.cancel) request.cancel = cancel;
+    Member member;
+    member.name = name;
+    member.after = std::move(after);
+    member.sent = Clock::now();
+    member.pending = client.Send(std::move(request));
+    members.push_back(std::move(member));
+    return static_cast<int>(members.size() - 1);
+}
+
+HttpResponse& HttpRequestGroup::Wait(int id) {
+    Member& member = members[id];
+    if (!member.done) {
+        member.response = member.pending.get();
+        member.done = true;
+    }
+    return member.response;
+}
+
+void HttpRequestGroup::Cancel() {
+    *cancel = true;
+}
+
+std::string HttpRequestGroup::Report() const {
+    auto ms = [this](Clock::time_point at) { return std::chrono::duration<double, std::milli>(at - start).count(); };
+
+    std::string report;
+    char line[256];
+    int last = -1;
+    for (size_t i = 0; i < members.size(); ++i) {
+        const Member& member = members[i];
+        if (!member.done) {
+            snprintf(line, sizeof(line), "  %-20s +%.0f ms, not waited for\n", member.name.c_str(), ms(member.sent));
+        } else {
+            snprintf(line, sizeof(line), "  %-20s +%.0f..+%.0f ms (%.0f ms) %ld%s\n", member.name.c_str(), ms(member.sent),
+                ms(member.response.finishedAt), ms(member.response.finishedAt) - ms(member.sent), member.response.status,
+                member.response.Ok() ? "" : " failed");
+            if (last < 0 || member.response.finishedAt > members[last].response.finishedAt) last = static_cast<int>(i);
+        }
+        report += line;
+    }
+    if (last < 0) return report;
+
+    // back from the request that finished last, each time through whichever input came in last
+    std::string path;
+    for (int at = last; at >= 0;) {
+        path = members[at].name + (path.empty() ? "" : " -> ") + path;
+        int slowest = -1;
+        for (int input : members[at].after) {
+            if (members[input].done && (slowest < 0 || members[input].response.finishedAt > members[slowest].response.finishedAt)) slowest = input;
+        }
+        at = slowest;
+    }
+    snprintf(line, sizeof(line), "  critical path %.0f ms: ", ms(members[last].response.finishedAt));
+    return report + line + path + "\n";
+}
+
+bool HttpGetString(const std::string& url, std::string& body, long& httpCode, std::string& error,
+    const std::vector<std::string>& headers, std::shared_ptr<std::atomic<bool>> cancel) {
+    HttpRequest request;
+    request.url = url;
+    request.headers = headers;
+    request.cancel = std::move(cancel);
+
+    HttpResponse response = DefaultHttpClient().Fetch(std::move(request));
+    body = std::move(response.body);
+    httpCode = response.status;
+    if (!response.Ok()) {
+        error = "HTTP request failed: " + response.error;
+        return false;
+    }
+    return true;
+}
+
+void HttpPoolShutdown() {
+    {
+        std::lock_guard<std::mutex> guard(g_ClientLock);
+        g_DefaultClient.reset();
+    }
+
+    std::lock_guard<std::mutex> guard(g_ShareCreateLock);
+    if (g_Share) {
+        curl_share_cleanup(g_Share);
+        g_Share = nullptr;
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// portable HTTP layer for the launchers: one async client driving a curl multi handle on its
+// own thread, on top of a process-wide DNS and TLS session cache. no Windows headers, so the
+// network core builds and runs the same on Linux
+
+// adaptive limits for a long transfer, in place of a fixed timeout and low speed limit. the
+// deadline follows the expected size and, once the link has been measured, the observed rate.
+// a stall is the moving-average rate sitting under a floor for a window that shrinks on fast links
+class TransferWatchdog {
+public:
+    // expectedBytes < 0 when unknown, expectedBytesPerSec <= 0 when nothing is known about the link
+    explicit TransferWatchdog(curl_off_t expectedBytes, double expectedBytesPerSec = 0.0);
+
+    // bytes received so far, false once the transfer should be dropped
+    bool Check(curl_off_t received);
+
+    bool Stalled() const { return stalled; }
+    bool Overdue() const { return overdue; }
+    double Rate() const { return averageRate; } // bytes/s
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    curl_off_t expected;
+    Clock::time_point start;
+    Clock::time_point lastSample;
+    Clock::time_point slowSince;
+    curl_off_t lastBytes = 0;
+    double averageRate = 0.0;
+    double peakRate = 0.0;
+    double deadline = 0.0; // seconds from start, 0 = none yet
+    bool measured = false;
+    bool slow = false;
+    bool stalled = false;
+    bool overdue = false;
+};
+
+// one request. GET by default, range makes it a ranged GET, body goes out with PUT/POST
+struct HttpRequest {
+    std::string method = "GET";
+    std::string url;
+    std::vector<std::string> headers; // "Name: value"
+    std::string body;
+    std::string range; // "first-last", as in a Range header without the "bytes="
+    std::string userAgent = "VelocityLauncher/1.0";
+    bool verifyPeer = true;
+    long connectTimeout = 30; // seconds, 0 = curl default
+    long timeout = 30;        // whole transfer, 0 = none
+    long lowSpeedLimit = 0;   // abort below this many bytes/s ...
+    long lowSpeedTime = 0;    // ... for this many seconds
+    long maxRedirects = 10;
+
+    // stream the body here instead of collecting it in the response. runs on the client thread,
+    // return false to abort the transfer
+    std::function<bool(const char* data, size_t size)> onData;
+
+    // download progress, runs on the client thread
+    std::function<void(curl_off_t total, curl_off_t now)> onProgress;
+
+    // set it from any thread to abort the transfer, it fails with CURLE_ABORTED_BY_CALLBACK
+    // within about a second even when the server has gone quiet
+    std::shared_ptr<std::atomic<bool>> cancel;
+
+    // aborts the transfer once it stalls or runs past its deadline, checked on the client thread.
+    // usually replaces timeout and lowSpeed*, which would otherwise still apply
+    std::shared_ptr<TransferWatchdog> watchdog;
+};
+
+struct HttpResponse {
+    CURLcode result = CURLE_OK;
+    long status = 0;
+    std::string body;                           // reserved from Content-Length, empty when the request had onData
+    std::map<std::string, std::string> headers; // lowercase names, final response of a redirect chain
+    std::string error;                          // curl's message when result != CURLE_OK
+    std::chrono::steady_clock::time_point finishedAt; // when the transfer completed, for timing breakdowns
+
+    bool Ok() const { return result == CURLE_OK; }
+    std::string Header(const std::string& name) const;
+
+    // parse straight out of the response buffer, no copy
+    std::string_view Body() const { return body; }
+};
+
+// async client, requests from any thread run concurrently on one multi handle
+class HttpClient {
+public:
+    HttpClient();
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    std::future<HttpResponse> Send(HttpRequest request);
+
+    // Send and wait
+    HttpResponse Fetch(HttpRequest request) { return Send(std::move(request)).get(); }
+
+    struct Transfer; // one in-flight request, internal to http.cpp
+
+private:
+    void Run();
+    void Start(std::unique_ptr<Transfer> transfer);
+    void Finish(Transfer* transfer, CURLcode result);
+
+    CURLM* multi = nullptr;
+    std::thread worker;
+    std::mutex lock;
+    std::vector<std::unique_ptr<Transfer>> queued;
+    std::map<CURL*, std::unique_ptr<Transfer>> active; // owned by the worker thread
+    bool stopping = false;
+};
+
+// the client every launcher request goes through, created on first use
+HttpClient& DefaultHttpClient();
+
+// related requests on one client: the independent ones go out together, one that needs an earlier
+// answer is sent as soon as that answer is in. each is timed from the group's start, and Report
+// shows them all plus the chain of waits that set the total, the critical path
+class HttpRequestGroup {
+public:
+    explicit HttpRequestGroup(HttpClient& client = DefaultHttpClient());
+    ~HttpRequestGroup(); // aborts whatever is still in flight
+
+    HttpRequestGroup(const HttpRequestGroup&) = delete;
+    HttpRequestGroup& operator=(const HttpRequestGroup&) = delete;
+
+    // send now and get an id for Wait. after lists the requests whose answers this one was built from
+    int Send(const std::string& name, HttpRequest request, std::vector<int> after = {});
+
+    // the response, waiting for it if it isn't in yet
+    HttpResponse& Wait(int id);
+
+    // abort everything still in flight, once an early answer made the rest pointless
+    void Cancel();
+
+    // "name +sent..+done ms" per request, then the critical path
+    std::string Report() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Member {
+        std::string name;
+        std::vector<int> after;
+        Clock::time_point sent;
+        std::future<HttpResponse> pending;
+        HttpResponse response;
+        bool done = false;
+    };
+
+    HttpClient& client;
+    Clock::time_point start;
+    std::shared_ptr<std::atomic<bool>> cancel;
+    std::vector<Member> members;
+};
+
+// attach a handle to the pool: DNS answers and TLS sessions are shared process-wide, idle
+// keep-alive connections are reused by the client's own multi handle. so a request after the
+// first skips the lookup + TCP + TLS handshake
+void HttpPoolAttach(CURL* curl);
+
+// note a finished transfer on a pooled handle: whether it had to connect / handshake, and its timings
+void HttpPoolRecord(CURL* curl);
+
+struct HttpRequestTiming {
+    std::string url; // no query string, signed CDN links don't belong in a log
+    long httpCode = 0;
+    bool newConnection = false;
+    bool tlsHandshake = false;
+    double connectMs = 0.0;
+    double tlsMs = 0.0;
+    double firstByteMs = 0.0;
+    double totalMs = 0.0;
+};
+
+struct HttpPoolStats {
+    uint64_t requests = 0;
+    uint64_t connections = 0;   // new TCP connections, the rest reused a pooled one
+    uint64_t tlsHandshakes = 0; // full or resumed handshakes, 0 for requests on a reused connection
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    std::vector<HttpRequestTiming> recent; // last few requests, oldest first
+};
+
+HttpPoolStats HttpPoolGetStats();
+
+// one line per recent request plus totals, for the debug log
+std::string HttpPoolReport();
+
+// GET a small document into body. false only on transport errors, any HTTP status comes back in httpCode
+bool HttpGetString(const std::string& url, std::string& body, long& httpCode, std::string& error,
+    const std::vector<std::string>& headers = {}, std::shared_ptr<std::atomic<bool>> cancel = nullptr);
+
+// stop the default client and drop the pool, before curl_global_cleanup
+void HttpPoolShutdown();
@@ -0,0 +1,368 @@
+#include "httpserver.h"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using Socket = SOCKET;
+using IoSize = int; // what recv and send take and return
+using IoLength = int;
+static const Socket kNoSocket = INVALID_SOCKET;
+#define SERVER_POLL WSAPoll
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using Socket = int;
+using IoSize = ssize_t;
+using IoLength = size_t;
+static const Socket kNoSocket = -1;
+#define SERVER_POLL poll
+#endif
+
+static const int kPollMs = 100; // how soon Stop is noticed
+static const int kAcceptBackoffMs = 50; // out of descriptors: leave the backlog alone this long
+static const size_t kReadChunk = 16 * 1024;
+static const int kPaceSteps = 20; // a paced answer goes out in about this many sends a second
+
+using Clock = std::chrono::steady_clock;
+
+struct Connection {
+    Socket socket = kNoSocket;
+    std::string in;
+    std::string out;
+    size_t sent = 0;
+    bool closeAfterSend = false;
+    Clock::time_point holdUntil; // a delayed answer, and everything pipelined behind it, waits for this
+    int bytesPerSec = 0;          // cap on what's queued in out, 0 = none
+    Clock::time_point pacedSince; // the cap counts from here ...
+    size_t pacedFrom = 0;         // ... and this offset in out
+    size_t stallAt = 0;           // offset in out where the answer goes silent ...
+    int stallMs = 0;              // ... this long, 0 = it doesn't
+};
+
+static void CloseSocket(Socket socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static bool WouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+// accept failed for want of a descriptor, the pending connection stays in the backlog
+static bool OutOfDescriptors() {
+#ifdef _WIN32
+    int code = WSAGetLastError();
+    return code == WSAEMFILE || code == WSAENOBUFS;
+#else
+    return errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+#endif
+}
+
+static void SetNonBlocking(Socket socket) {
+#ifdef _WIN32
+    u_long on = 1;
+    ioctlsocket(socket, FIONBIO, &on);
+#else
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+#endif
+    int noDelay = 1; // answers are one small write, don't let Nagle hold them back
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+}
+
+static const char* StatusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+// a HEAD answer carries the headers the GET would have, Content-Length included, and no body
+static void AppendResponse(Connection& connection, const HttpServerResponse& response, bool head = false) {
+    connection.out += "HTTP/1.1 " + std::to_string(response.status) + " " + StatusText(response.status) + "\r\n";
+    connection.out += "Content-Type: " + response.contentType + "\r\n";
+    connection.out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    for (const std::string& header : response.headers) connection.out += header + "\r\n";
+    if (connection.closeAfterSend) connection.out += "Connection: close\r\n";
+    connection.out += "\r\n";
+    if (!head) {
+        if (response.stallMs > 0 && response.stallAfter < response.body.size() && connection.stallMs == 0) {
+            connection.stallAt = connection.out.size() + response.stallAfter;
+            connection.stallMs = response.stallMs;
+        }
+        connection.out += response.body;
+    }
+    if (response.delayMs > 0)
+        connection.holdUntil = (std::max)(connection.holdUntil, Clock::now() + std::chrono::milliseconds(response.delayMs));
+    if (response.bytesPerSec > 0 && connection.bytesPerSec == 0) {
+        connection.bytesPerSec = response.bytesPerSec;
+        connection.pacedSince = (std::max)(connection.holdUntil, Clock::now());
+        connection.pacedFrom = connection.sent;
+    }
+}
+
+// answer every complete request in the input buffer, pipelined ones in order. one that can't be
+// parsed gets an error answer and the connection is closed after it
+static void ServeBuffered(Connection& connection, const HttpServer::Handler& handler) {
+    while (!connection.closeAfterSend) {
+        size_t headerEnd = connection.in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            if (connection.in.size() <= HttpServer::kMaxHeaderSize) return;
+            connection.closeAfterSend = true;
+            AppendResponse(connection, { 413, "Headers too large\n" });
+            return;
+        }
+
+        HttpServerRequest request;
+        size_t lineEnd = connection.in.find("\r\n");
+        std::string line = connection.in.substr(0, lineEnd);
+        size_t space1 = line.find(' ');
+        size_t space2 = line.find(' ', space1 == std::string::npos ? 0 : space1 + 1);
+        if (space1 == std::string::npos || space2 == std::string::npos) {
+            connection.closeAfterSend = true;
+            AppendResponse(connection, { 400, "Malformed request line\n" });
+            return;
+        }
+        request.method = line.substr(0, space1);
+        request.path = line.substr(space1 + 1, space2 - space1 - 1);
+        bool http10 = line.compare(space2 + 1, std::string::npos, "HTTP/1.0") == 0;
+
+        for (size_t at = lineEnd + 2; at < headerEnd;) {
+            size_t end = connection.in.find("\r\n", at);
+            std::string header = connection.in.substr(at, end - at);
+            at = end + 2;
+            size_t colon = header.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = header.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            size_t valueStart = header.find_first_not_of(' ', colon + 1);
+            request.headers[name] = valueStart == std::string::npos ? "" : header.substr(valueStart);
+        }
+
+        size_t bodySize = 0;
+        auto length = request.headers.find("content-length");
+        if (length != request.headers.end()) {
+            if (length->second.empty() || length->second.size() > 9 || length->second.find_first_not_of("0123456789") != std::string::npos ||
+                std::stoul(length->second) > HttpServer::kMaxBodySize) {
+                connection.closeAfterSend = true;
+                AppendResponse(connection, { 413, "Body too large\n" });
+                return;
+            }
+            bodySize = std::stoul(length->second);
+        }
+        if (connection.in.size() < headerEnd + 4 + bodySize) return; // body still coming
+        request.body = connection.in.substr(headerEnd + 4, bodySize);
+        connection.in.erase(0, headerEnd + 4 + bodySize);
+
+        auto connectionHeader = request.headers.find("connection");
+        if (http10 || (connectionHeader != request.headers.end() && connectionHeader->second == "close"))
+            connection.closeAfterSend = true;
+
+        HttpServerResponse response;
+        try {
+            response = handler(request);
+        }
+        catch (const std::exception& e) {
+            response = { 500, std::string(e.what()) + "\n" };
+        }
+        AppendResponse(connection, response, request.method == "HEAD");
+    }
+}
+
+HttpServer::~HttpServer() {
+    Stop();
+}
+
+bool HttpServer::Start(const std::string& host, int requestedPort, Handler serve, std::string& error) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        error = "WSAStartup failed";
+        return false;
+    }
+#endif
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<unsigned short>(requestedPort));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        error = "Bad listen address " + host;
+        return false;
+    }
+
+    Socket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == kNoSocket) {
+        error = "Failed to create socket";
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(socket, SOMAXCONN) != 0) {
+        CloseSocket(socket);
+        error = "Failed to listen on " + host + ":" + std::to_string(requestedPort);
+        return false;
+    }
+    SetNonBlocking(socket);
+
+    socklen_t size = sizeof(address);
+    getsockname(socket, reinterpret_cast<sockaddr*>(&address), &size);
+    port = ntohs(address.sin_port);
+    listener = static_cast<intptr_t>(socket);
+    handler = std::move(serve);
+    stopping = false;
+    thread = std::thread(&HttpServer::Run, this);
+    return true;
+}
+
+void HttpServer::Stop() {
+    if (!thread.joinable()) return;
+    stopping = true;
+    thread.join();
+    CloseSocket(static_cast<Socket>(listener));
+    listener = -1;
+}
+
+void HttpServer::Run() {
+    Socket listenSocket = static_cast<Socket>(listener);
+    std::vector<Connection> connections;
+    std::vector<pollfd> polled;
+    std::vector<char> chunk(kReadChunk);
+    // the listener stays readable while accept has no descriptor to give, polling it then would spin
+    Clock::time_point acceptPausedUntil;
+
+    while (!stopping) {
+        Clock::time_point now = Clock::now();
+        Clock::time_point wake = now + std::chrono::milliseconds(kPollMs);
+        bool acceptPaused = acceptPausedUntil > now;
+        if (acceptPaused) wake = (std::min)(wake, acceptPausedUntil);
+        polled.clear();
+        polled.push_back({ listenSocket, static_cast<short>(acceptPaused ? 0 : POLLIN), 0 });
+        for (const Connection& connection : connections) {
+            bool held = connection.holdUntil > now;
+            if (held) wake = (std::min)(wake, connection.holdUntil);
+            short events = connection.sent < connection.out.size() ? (held ? 0 : POLLOUT) : POLLIN;
+            polled.push_back({ connection.socket, events, 0 });
+        }
+        int timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(wake - now).count());
+        int ready = SERVER_POLL(polled.data(), static_cast<unsigned long>(polled.size()), timeout);
+        if (ready < 0) continue;
+        now = Clock::now();
+
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            short revents = polled[i + 1].revents;
+            bool drop = (revents & (POLLERR | POLLNVAL)) != 0 || ((revents & POLLHUP) && connection.sent < connection.out.size());
+
+            if (!drop && (revents & (POLLIN | POLLHUP)) && connection.sent == connection.out.size()) {
+                IoSize received = recv(connection.socket, chunk.data(), static_cast<IoLength>(chunk.size()), 0);
+                if (received > 0) {
+                    connection.in.append(chunk.data(), static_cast<size_t>(received));
+                    ServeBuffered(connection, handler);
+                } else if (received == 0 || !WouldBlock()) {
+                    drop = true;
+                }
+            }
+
+            // answers usually fit the socket buffer, so try right away instead of on the next poll
+            while (!drop && connection.sent < connection.out.size() && connection.holdUntil <= now) {
+#ifdef MSG_NOSIGNAL
+                int flags = MSG_NOSIGNAL;
+#else
+                int flags = 0;
+#endif
+                size_t length = connection.out.size() - connection.sent;
+                if (connection.stallMs > 0) {
+                    if (connection.sent >= connection.stallAt) {
+                        connection.holdUntil = now + std::chrono::milliseconds(connection.stallMs);
+                        connection.stallMs = 0;
+                        break;
+                    }
+                    length = (std::min)(length, connection.stallAt - connection.sent);
+                }
+                if (connection.bytesPerSec > 0) {
+                    // what the cap allows by now, past it the connection sleeps until the next step is due
+                    double rate = connection.bytesPerSec;
+                    double elapsed = (std::max)(0.0, std::chrono::duration<double>(now - connection.pacedSince).count());
+                    size_t allowed = connection.pacedFrom + static_cast<size_t>(rate * elapsed);
+                    if (allowed <= connection.sent) {
+                        size_t step = (std::max)(size_t(1), static_cast<size_t>(rate / kPaceSteps));
+                        double due = static_cast<double>(connection.sent + step - connection.pacedFrom) / rate;
+                        connection.holdUntil = connection.pacedSince + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(due));
+                        break;
+                    }
+                    length = (std::min)(length, allowed - connection.sent);
+                }
+                IoSize written = send(connection.socket, connection.out.data() + connection.sent,
+                    static_cast<IoLength>(length), flags);
+                if (written > 0) {
+                    connection.sent += static_cast<size_t>(written);
+                } else {
+                    drop = !WouldBlock();
+                    break;
+                }
+            }
+            if (!drop && connection.sent == connection.out.size()) {
+                connection.out.clear();
+                connection.sent = 0;
+                connection.bytesPerSec = 0;
+                connection.stallMs = 0;
+                if (connection.closeAfterSend) drop = true;
+            }
+
+            if (drop) {
+                CloseSocket(connection.socket);
+                connection.socket = kNoSocket;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+            [](const Connection& connection) { return connection.socket == kNoSocket; }), connections.end());
+
+        if (polled[0].revents & POLLIN) {
+            for (;;) {
+                Socket accepted = accept(listenSocket, nullptr, nullptr);
+                if (accepted == kNoSocket) {
+                    if (OutOfDescriptors()) acceptPausedUntil = Clock::now() + std::chrono::milliseconds(kAcceptBackoffMs);
+                    break;
+                }
+                SetNonBlocking(accepted);
+                Connection connection;
+                connection.socket = accepted;
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+
+    for (const Connection& connection : connections) {
+        CloseSocket(connection.socket);
+    }
+}
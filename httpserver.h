@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the small HTTP/1.1 server behind the key registry and the local stand-ins. one thread polls the
+// listening socket and every connection, so thousands of idle keep-alive launchers cost a socket
+// each and no thread. the handler runs on that thread and has to be quick: no I/O beyond a local
+// file append. Winsock on Windows, BSD sockets elsewhere
+struct HttpServerRequest {
+    std::string method;
+    std::string path; // as sent, query string included
+    std::map<std::string, std::string> headers; // names lowercased
+    std::string body;
+};
+
+struct HttpServerResponse {
+    int status = 200;
+    std::string body;
+    std::string contentType = "text/plain";
+    std::vector<std::string> headers = {}; // extra "Name: value" lines, e.g. Content-Range
+    int delayMs = 0; // hold the answer back this long without blocking other connections, for stand-ins
+    int bytesPerSec = 0; // send it no faster than this, like a slow link or a capped CDN edge. 0 = no cap
+    size_t stallAfter = 0; // with stallMs, go silent for stallMs once this much of the body is out,
+    int stallMs = 0;       // like a connection that hangs mid-transfer
+};
+
+class HttpServer {
+public:
+    using Handler = std::function<HttpServerResponse(const HttpServerRequest&)>;
+
+    static const size_t kMaxHeaderSize = 16 * 1024;
+    static const size_t kMaxBodySize = 1024 * 1024;
+
+    HttpServer() = default;
+    ~HttpServer(); // stops
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // listen on host:port (0 picks a free one) and serve on a new thread. false with error when the
+    // address can't be bound
+    bool Start(const std::string& host, int port, Handler handler, std::string& error);
+
+    // close the listener and every connection, whatever is half-sent is dropped
+    void Stop();
+
+    int Port() const { return port; }
+
+private:
+    void Run();
+
+    Handler handler;
+    intptr_t listener = -1;
+    int port = 0;
+    std::atomic<bool> stopping = false;
+    std::thread thread;
+};
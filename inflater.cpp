@@ -0,0 +1,104 @@
+#include "inflater.h"
+#include <algorithm>
+
+#if !defined(INFLATE_NO_LIBDEFLATE) && __has_include(<libdeflate.h>)
+#define INFLATE_LIBDEFLATE 1
+#include <libdeflate.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "deflate.lib")
+#endif
+#endif
+
+static const size_t kMaxStep = 1u << 30; // zlib counts in uInt, bigger buffers go through in slices
+
+Inflater::~Inflater() {
+    if (streamReady) inflateEnd(&stream);
+#ifdef INFLATE_LIBDEFLATE
+    if (decompressor) libdeflate_free_decompressor(static_cast<libdeflate_decompressor*>(decompressor));
+#endif
+}
+
+bool Inflater::PrefersWhole(uint64_t size) {
+#ifdef INFLATE_LIBDEFLATE
+    return size <= kWholeMaxSize;
+#else
+    (void)size;
+    return false;
+#endif
+}
+
+bool Inflater::Begin() {
+    if (streamReady) return inflateReset(&stream) == Z_OK;
+    stream = {};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return false;
+    streamReady = true;
+    return true;
+}
+
+InflateResult Inflater::Step(const unsigned char* in, size_t inSize, size_t& consumed, unsigned char* out, size_t outSize, size_t& produced) {
+    uInt inChunk = static_cast<uInt>((std::min)(inSize, kMaxStep));
+    uInt outChunk = static_cast<uInt>((std::min)(outSize, kMaxStep));
+    stream.next_in = const_cast<Bytef*>(in);
+    stream.avail_in = inChunk;
+    stream.next_out = out;
+    stream.avail_out = outChunk;
+    int ret = inflate(&stream, Z_NO_FLUSH);
+    consumed = inChunk - stream.avail_in;
+    produced = outChunk - stream.avail_out;
+    stream.avail_in = 0; // nothing of the caller's buffers is kept between calls
+
+    if (ret == Z_STREAM_END) return InflateResult::Done;
+    if (ret == Z_OK || ret == Z_BUF_ERROR) return InflateResult::More; // Z_BUF_ERROR: no progress possible yet
+    return InflateResult::Corrupt;
+}
+
+InflateResult Inflater::Whole(const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize) {
+#ifdef INFLATE_LIBDEFLATE
+    if (!decompressor) decompressor = libdeflate_alloc_decompressor();
+    if (decompressor) {
+        // without an actual size to report back it only succeeds on an exact fill
+        switch (libdeflate_deflate_decompress(static_cast<libdeflate_decompressor*>(decompressor), in, inSize, out, outSize, nullptr)) {
+        case LIBDEFLATE_SUCCESS:
+            return InflateResult::Done;
+        case LIBDEFLATE_SHORT_OUTPUT:
+        case LIBDEFLATE_INSUFFICIENT_SPACE:
+            return InflateResult::WrongSize;
+        default:
+            return InflateResult::Corrupt;
+        }
+    }
+#endif
+
+    if (!Begin()) return InflateResult::Corrupt;
+    size_t consumed = 0;
+    size_t produced = 0;
+    for (;;) {
+        size_t used = 0;
+        size_t made = 0;
+        InflateResult result = Step(in + consumed, inSize - consumed, used, out + produced, outSize - produced, made);
+        consumed += used;
+        produced += made;
+        if (result == InflateResult::Done) return produced == outSize ? InflateResult::Done : InflateResult::WrongSize;
+        if (result == InflateResult::Corrupt) return result;
+        if (used == 0 && made == 0) {
+            // stuck: out of room means the entry is bigger than it claims, out of input means it's cut short
+            return produced == outSize ? InflateResult::WrongSize : InflateResult::Corrupt;
+        }
+    }
+}
+
+const char* Inflater::WholeBackend() {
+#ifdef INFLATE_LIBDEFLATE
+    return "libdeflate";
+#else
+    return "zlib";
+#endif
+}
+
+const char* Inflater::StreamBackend() {
+#ifdef ZLIBNG_VERSION
+    return "zlib-ng " ZLIBNG_VERSION;
+#else
+    return "zlib " ZLIB_VERSION;
+#endif
+}
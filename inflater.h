@@ -0,0 +1,47 @@
+#pragma once
+#include <zlib.h>
+#include <cstddef>
+#include <cstdint>
+
+// More: wants more input or more output room. WrongSize: Whole only, the stream is fine but
+// doesn't inflate to exactly the size it was given
+enum class InflateResult { More, Done, WrongSize, Corrupt };
+
+// raw deflate (zip method 8) decoding with two backends behind it. Whole decodes an entry that's
+// entirely in memory in one call, through libdeflate when the build has it, which is a lot faster
+// than zlib but can't stop and resume. Step streams through zlib, which is zlib-ng's SIMD inflate
+// when the build links zlib-ng in compat mode. one per thread, reused across entries
+class Inflater {
+public:
+    // biggest entry PrefersWhole hands to libdeflate, beyond it memory stays bounded by streaming
+    static const uint64_t kWholeMaxSize = 16 << 20;
+
+    Inflater() = default;
+    ~Inflater();
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    // true when an entry of this size is better off inflated whole than streamed. only with
+    // libdeflate, zlib is no faster in one call and the whole entry would cost a buffer
+    static bool PrefersWhole(uint64_t size);
+
+    // every compressed byte in, exactly outSize bytes out
+    InflateResult Whole(const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize);
+
+    // start the next entry of a stream, false if zlib couldn't be set up
+    bool Begin();
+
+    // inflate from in into out, consumed and produced say how much of each was used. pass what's
+    // left of the input again on the next call. never WrongSize
+    InflateResult Step(const unsigned char* in, size_t inSize, size_t& consumed, unsigned char* out, size_t outSize, size_t& produced);
+
+    // "libdeflate" or "zlib", and "zlib-ng x.y" or "zlib x.y", for the debug log and benchmarks
+    static const char* WholeBackend();
+    static const char* StreamBackend();
+
+private:
+    z_stream stream = {};
+    bool streamReady = false;
+    void* decompressor = nullptr; // libdeflate's, made on first use
+};
@@ -0,0 +1,170 @@
+#include "keycache.h"
+#include "sha256.h"
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+
+// file: "VKC1", record count, then one fixed-size record per key, all little-endian
+static const char kMagic[4] = { 'V', 'K', 'C', '1' };
+static const size_t kHeaderSize = 8;
+static const size_t kRecordSize = 48; // sha256, checked at (int64), valid, padding
+
+static std::string KeyHash(const std::string& key) {
+    Sha256 hasher;
+    hasher.Update(key.data(), key.size());
+    Sha256::Digest digest = hasher.Final();
+    return std::string(reinterpret_cast<const char*>(digest.data()), digest.size());
+}
+
+static uint64_t ReadLE(const unsigned char* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = bytes; i-- > 0;) value = (value << 8) | p[i];
+    return value;
+}
+
+static void WriteLE(unsigned char* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i, value >>= 8) p[i] = static_cast<unsigned char>(value);
+}
+
+KeyValidationCache::~KeyValidationCache() {
+    WaitForRevalidation();
+}
+
+void KeyValidationCache::Open(const std::filesystem::path& cachePath) {
+    std::lock_guard<std::mutex> guard(lock);
+    path = cachePath;
+    entries.clear();
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < kHeaderSize || memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) return;
+    uint64_t count = ReadLE(data.data() + 4, 4);
+    if (data.size() != kHeaderSize + count * kRecordSize) return; // torn or foreign, start over
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const unsigned char* record = data.data() + kHeaderSize + i * kRecordSize;
+        Entry entry;
+        entry.checkedAt = static_cast<int64_t>(ReadLE(record + 32, 8));
+        entry.valid = record[40] != 0;
+        entries[std::string(reinterpret_cast<const char*>(record), 32)] = entry;
+    }
+}
+
+bool KeyValidationCache::Validate(const std::string& key, const Check& check, bool& valid, std::string& error) {
+    std::string hash = KeyHash(key);
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = entries.find(hash);
+        // an answer from the future means the clock went back, it isn't trusted
+        int64_t age = found != entries.end() ? now - found->second.checkedAt : -1;
+        if (age >= 0) {
+            const Entry& entry = found->second;
+            if (age < (entry.valid ? policy.positiveFreshFor : policy.negativeFreshFor)) {
+                ++hits;
+                valid = entry.valid;
+                return true;
+            }
+            if (entry.valid && age < policy.positiveFreshFor + policy.positiveStaleFor) {
+                ++staleHits;
+                valid = true;
+                if (revalidating.insert(hash).second) {
+                    workers.emplace_back([this, key, hash, check]() {
+                        bool answer = false;
+                        std::string ignored;
+                        bool answered = check(key, answer, ignored);
+                        std::lock_guard<std::mutex> guard(lock);
+                        revalidating.erase(hash);
+                        if (answered) {
+                            ++revalidations;
+                            StoreLocked(hash, answer, static_cast<int64_t>(time(nullptr)));
+                        }
+                    });
+                }
+                return true;
+            }
+        }
+    }
+
+    ++misses;
+    if (!check(key, valid, error)) return false;
+    std::lock_guard<std::mutex> guard(lock);
+    StoreLocked(hash, valid, static_cast<int64_t>(time(nullptr)));
+    return true;
+}
+
+void KeyValidationCache::Store(const std::string& key, bool valid) {
+    std::string hash = KeyHash(key);
+    std::lock_guard<std::mutex> guard(lock);
+    StoreLocked(hash, valid, static_cast<int64_t>(time(nullptr)));
+}
+
+void KeyValidationCache::StoreLocked(const std::string& hash, bool valid, int64_t now) {
+    Entry& entry = entries[hash];
+    entry.checkedAt = now;
+    entry.valid = valid;
+    Save();
+}
+
+// rewrite the whole file, it's a handful of records. answers past any use are dropped on the way
+void KeyValidationCache::Save() {
+    if (path.empty()) return;
+
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    for (auto it = entries.begin(); it != entries.end();) {
+        int64_t lifetime = it->second.valid ? policy.positiveFreshFor + policy.positiveStaleFor : policy.negativeFreshFor;
+        it = now - it->second.checkedAt >= lifetime ? entries.erase(it) : std::next(it);
+    }
+
+    std::vector<unsigned char> data(kHeaderSize + entries.size() * kRecordSize, 0);
+    memcpy(data.data(), kMagic, sizeof(kMagic));
+    WriteLE(data.data() + 4, entries.size(), 4);
+    unsigned char* record = data.data() + kHeaderSize;
+    for (const auto& item : entries) {
+        memcpy(record, item.first.data(), 32);
+        WriteLE(record + 32, static_cast<uint64_t>(item.second.checkedAt), 8);
+        record[40] = item.second.valid ? 1 : 0;
+        record += kRecordSize;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec); // first validation comes before the install folder
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()))) return;
+    }
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) std::filesystem::remove(temporary, ec);
+}
+
+void KeyValidationCache::WaitForRevalidation() {
+    for (;;) {
+        std::vector<std::thread> running;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            running.swap(workers);
+        }
+        if (running.empty()) return;
+        for (std::thread& worker : running) {
+            worker.join();
+        }
+    }
+}
+
+KeyCacheStats KeyValidationCache::Stats() const {
+    KeyCacheStats stats;
+    stats.hits = hits;
+    stats.staleHits = staleHits;
+    stats.misses = misses;
+    stats.revalidations = revalidations;
+    return stats;
+}
+
+std::string KeyValidationCache::Report() const {
+    KeyCacheStats stats = Stats();
+    return "key cache: " + std::to_string(stats.hits) + " hits, " + std::to_string(stats.staleHits) + " stale hits, " +
+        std::to_string(stats.misses) + " misses, " + std::to_string(stats.revalidations) + " revalidated\n";
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// how long validation answers are trusted. a positive answer is served as is for freshFor, then
+// for up to staleFor more it's still served but checked again in the background. negative
+// answers are never served stale, a key that was just bought shouldn't stay rejected
+struct KeyCachePolicy {
+    int64_t positiveFreshFor = 12 * 60 * 60;
+    int64_t positiveStaleFor = 7 * 24 * 60 * 60;
+    int64_t negativeFreshFor = 5 * 60;
+};
+
+struct KeyCacheStats {
+    uint64_t hits = 0;      // fresh answers, no request made
+    uint64_t staleHits = 0; // answered from the cache, revalidated in the background
+    uint64_t misses = 0;    // had to ask the server before answering
+    uint64_t revalidations = 0; // background checks that got an answer
+};
+
+// persistent cache of key validation results, keyed by the sha256 of the key so the file never
+// holds a key itself. the file is fixed-size binary records read in one go at startup, no parsing.
+// it only saves round trips: anyone who can write the file can make it say anything
+class KeyValidationCache {
+public:
+    // does the actual online check. false when there was no answer (network, bad response), error
+    // then says why and nothing is cached. valid is the server's answer otherwise
+    using Check = std::function<bool(const std::string& key, bool& valid, std::string& error)>;
+
+    explicit KeyValidationCache(KeyCachePolicy policy = KeyCachePolicy()) : policy(policy) {}
+    ~KeyValidationCache(); // waits for background revalidations
+
+    KeyValidationCache(const KeyValidationCache&) = delete;
+    KeyValidationCache& operator=(const KeyValidationCache&) = delete;
+
+    // load the cache file, a missing or damaged one just starts empty
+    void Open(const std::filesystem::path& path);
+
+    // the answer for key, from the cache when it has a usable one. false if the cache had nothing
+    // and check couldn't get an answer either
+    bool Validate(const std::string& key, const Check& check, bool& valid, std::string& error);
+
+    // record an answer obtained some other way
+    void Store(const std::string& key, bool valid);
+
+    // block until every background revalidation has finished, before exiting
+    void WaitForRevalidation();
+
+    KeyCacheStats Stats() const;
+
+    // one line of counters, for the debug log
+    std::string Report() const;
+
+private:
+    struct Entry {
+        int64_t checkedAt = 0; // unix seconds
+        bool valid = false;
+    };
+
+    void StoreLocked(const std::string& hash, bool valid, int64_t now);
+    void Save();
+
+    KeyCachePolicy policy;
+    std::filesystem::path path;
+    std::unordered_map<std::string, Entry> entries; // raw 32-byte sha256 -> answer
+    std::unordered_set<std::string> revalidating;
+    std::vector<std::thread> workers;
+    mutable std::mutex lock;
+
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> staleHits = 0;
+    std::atomic<uint64_t> misses = 0;
+    std::atomic<uint64_t> revalidations = 0;
+};
@@ -0,0 +1,65 @@
+// the key registry service: keeps which machine each key is activated on (registry.h).
+//   keyregistry [--listen <ip>] [--port <port>] [--store <file>]
+//   keyregistry --local     in memory on 127.0.0.1, any free port, for development
+#include "registry.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+static std::atomic<bool> g_Stop = false;
+
+static void OnSignal(int) {
+    g_Stop = true;
+}
+
+int main(int argc, char** argv) {
+    std::string listen = "0.0.0.0";
+    int port = 8080;
+    std::string store = "registry.krg";
+    bool local = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--local")) {
+            local = true;
+        } else if (!strcmp(argv[i], "--listen") && hasValue) {
+            listen = argv[++i];
+        } else if (!strcmp(argv[i], "--port") && hasValue) {
+            port = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--store") && hasValue) {
+            store = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--listen <ip>] [--port <port>] [--store <file>] | --local\n", argv[0]);
+            return 2;
+        }
+    }
+    if (local) {
+        listen = "127.0.0.1";
+        port = 0;
+        store.clear();
+    }
+
+    KeyRegistry registry;
+    HttpServer server;
+    std::string error;
+    if (!registry.Open(store, error) || !server.Start(listen, port, KeyRegistryHandler(registry), error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    printf("key registry on http://%s:%d, %zu keys bound, store %s\n", listen.c_str(), server.Port(), registry.Size(),
+        store.empty() ? "in memory" : store.c_str());
+    fflush(stdout);
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    while (!g_Stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    server.Stop();
+    return 0;
+}
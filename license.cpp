@@ -0,0 +1,134 @@
+#include "license.h"
+#include "sha256.h"
+#include <fstream>
+#include <vector>
+
+#if !defined(LICENSE_NO_SODIUM) && __has_include(<sodium.h>)
+#define LICENSE_ED25519 1
+#include <sodium.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "libsodium.lib")
+#endif
+#endif
+
+static const char* kTokenVersion = "v1";
+static const int64_t kClockSkew = 5 * 60; // a clock slightly behind the server's still accepts a fresh token
+
+std::string LicenseToken::SignedPart() const {
+    return std::string(kTokenVersion) + "." + keyHash + "." + std::to_string(issuedAt) + "." + std::to_string(expiresAt);
+}
+
+#ifdef LICENSE_ED25519
+static bool ParseHex(const std::string& text, std::vector<unsigned char>& bytes) {
+    if (text.size() % 2) return false;
+    bytes.clear();
+    for (size_t i = 0; i < text.size(); i += 2) {
+        int value = 0;
+        for (size_t j = i; j < i + 2; ++j) {
+            char c = text[j];
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0) return false;
+            value = value * 16 + digit;
+        }
+        bytes.push_back(static_cast<unsigned char>(value));
+    }
+    return true;
+}
+#endif
+
+static bool ParseSeconds(const std::string& text, int64_t& value) {
+    if (text.empty() || text.size() > 18 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    value = std::stoll(text);
+    return true;
+}
+
+bool ParseLicenseToken(const std::string& text, LicenseToken& token) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t dot = text.find('.', start);
+        fields.push_back(text.substr(start, dot == std::string::npos ? std::string::npos : dot - start));
+        if (dot == std::string::npos) break;
+        start = dot + 1;
+    }
+    if (fields.size() != 5 || fields[0] != kTokenVersion || fields[1].size() != 64) return false;
+
+    token.keyHash = fields[1];
+    token.signature = fields[4];
+    return ParseSeconds(fields[2], token.issuedAt) && ParseSeconds(fields[3], token.expiresAt);
+}
+
+std::string LicenseKeyHash(const std::string& key) {
+    Sha256 hasher;
+    hasher.Update(key.data(), key.size());
+    return Sha256::ToHex(hasher.Final());
+}
+
+bool VerifyLicenseToken(const std::string& text, const std::string& key, const std::string& publicKeyHex, int64_t now, std::string& error) {
+    LicenseToken token;
+    if (!ParseLicenseToken(text, token)) {
+        error = "Malformed license token";
+        return false;
+    }
+    if (token.keyHash != LicenseKeyHash(key)) {
+        error = "License token belongs to a different key";
+        return false;
+    }
+    if (now >= token.expiresAt) {
+        error = "License token expired";
+        return false;
+    }
+    if (now + kClockSkew < token.issuedAt) {
+        error = "License token is not valid yet, check the system clock";
+        return false;
+    }
+
+#ifdef LICENSE_ED25519
+    std::vector<unsigned char> publicKey, signature;
+    if (!ParseHex(publicKeyHex, publicKey) || publicKey.size() != crypto_sign_PUBLICKEYBYTES) {
+        error = "No license public key configured";
+        return false;
+    }
+    if (!ParseHex(token.signature, signature) || signature.size() != crypto_sign_BYTES) {
+        error = "Malformed license token";
+        return false;
+    }
+    if (sodium_init() < 0) {
+        error = "Failed to initialize libsodium";
+        return false;
+    }
+
+    std::string message = token.SignedPart();
+    if (crypto_sign_verify_detached(signature.data(), reinterpret_cast<const unsigned char*>(message.data()), message.size(), publicKey.data()) != 0) {
+        error = "License token signature is invalid";
+        return false;
+    }
+    return true;
+#else
+    (void)publicKeyHex;
+    error = "License tokens need a build with libsodium";
+    return false;
+#endif
+}
+
+std::string LoadLicenseToken(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::string text;
+    if (file) std::getline(file, text);
+    while (!text.empty() && (text.back() == '\r' || text.back() == ' ')) text.pop_back();
+    return text;
+}
+
+bool SaveLicenseToken(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!(file << text << "\n")) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (!ec) return true;
+    std::filesystem::remove(temporary, ec);
+    return false;
+}
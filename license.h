@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// offline license tokens. once a key has been validated online, the license server signs (Ed25519)
+// which key it saw and until when, and the launcher keeps that token next to key.txt. at startup the
+// signature is checked locally against the server's public key, tens of microseconds instead of a
+// validation round trip. one line of text:
+//   v1.<sha256 of the key, hex>.<issued, unix seconds>.<expires, unix seconds>.<signature, hex>
+// the signature covers everything before its own dot
+struct LicenseToken {
+    std::string keyHash;
+    int64_t issuedAt = 0;
+    int64_t expiresAt = 0;
+    std::string signature;
+
+    std::string SignedPart() const;
+};
+
+bool ParseLicenseToken(const std::string& text, LicenseToken& token);
+
+// hex sha256 of a key, what a token names instead of the key itself
+std::string LicenseKeyHash(const std::string& key);
+
+// the signature checks out against publicKeyHex (32 bytes as hex), the token was issued for key and
+// now is inside its lifetime. false with error saying why otherwise, also when no public key is
+// configured or the build has no Ed25519 (libsodium), the caller then validates online
+bool VerifyLicenseToken(const std::string& text, const std::string& key, const std::string& publicKeyHex, int64_t now, std::string& error);
+
+// the token stored at path, empty when there is none
+std::string LoadLicenseToken(const std::filesystem::path& path);
+
+// replace the stored token, never leaving a half-written one behind
+bool SaveLicenseToken(const std::filesystem::path& path, const std::string& text);
@@ -1,878 +1,1526 @@
-// Contribution: linhforreal
-#include "imgui.h"
-#include "imgui_impl_win32.h"
-#include "imgui_impl_dx11.h"
-#include <d3d11.h>
-#include <tchar.h>
-#include <Windows.h>
-#include <filesystem>
-#include <shellapi.h>
-#include <winhttp.h>
-#include <fstream>
-#include <iostream>
-#include <string>
-#include <thread>
-#include <curl/curl.h>
-#include <nlohmann/json.hpp>
-#include <shlobj.h>
-#include <zip.h>
-#include <wininet.h>
-
-#pragma comment(lib, "winhttp.lib")
-#pragma comment(lib, "zip.lib")
-#pragma comment(lib, "wininet.lib")
-
-// GLOBALS...
-extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-static std::string hiddenFolderPath;
-static float g_DownloadProgress = 0.0f;
-static bool g_DownloadInProgress = false;
-static std::atomic<bool> g_DownloadComplete = false;
-static std::atomic<bool> g_DownloadSuccess = false;
-static std::string g_ErrorMessage;
-
-// DirectX globals...
-static ID3D11Device* g_pd3dDevice = nullptr;
-static ID3D11DeviceContext* g_pd3dDeviceContext = nullptr;
-static IDXGISwapChain* g_pSwapChain = nullptr;
-static bool g_SwapChainOccluded = false;
-static UINT g_ResizeWidth = 0, g_ResizeHeight = 0;
-static ID3D11RenderTargetView* g_mainRenderTargetView = nullptr;
-
-// Screen boundaries
-static int g_ScreenWidth = 0;
-static int g_ScreenHeight = 0;
-
-// function declarations
-bool CreateDeviceD3D(HWND hWnd);
-void CleanupDeviceD3D();
-void CreateRenderTarget();
-void CleanupRenderTarget();
-LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-bool CheckForKeyAndLaunchSynapse();
-std::string CreateHiddenFolder();
-bool DownloadFile(const std::string& url, const std::string& outputPath);
-bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath);
-bool SaveKeyToFile(const std::string& key);
-bool validateKey(const std::string& token);
-void OpenBrowser(const std::wstring& url);
-
-using json = nlohmann::json;
-
-// easy url opening
-void OpenBrowser(const std::wstring& url) {
-    ShellExecuteW(nullptr, L"open", url.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
-}
-
-static size_t WriteCallbackFile(void* ptr, size_t size, size_t nmemb, FILE* stream) {
-    return fwrite(ptr, size, nmemb, stream);
-}
-
-static int ProgressCallback(void*, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t) {
-    g_DownloadProgress = dltotal > 0 ? static_cast<float>(dlnow) / static_cast<float>(dltotal) : 0.0f;
-    return 0;
-}
-
-// Function to retry download with alternative URL if the main one fails
-bool DownloadFileWithRetry(const std::string& url, const std::string& backupUrl, const std::string& outputPath) {
-    if (DownloadFile(url, outputPath)) {
-        return true;
-    }
-    
-    // if main URL fails, clear error and try backup URL
-    g_ErrorMessage = "Primary download failed, trying backup source...";
-    return DownloadFile(backupUrl, outputPath);
-}
-
-bool DownloadFile(const std::string& url, const std::string& outputPath) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        g_ErrorMessage = "Failed to initialize CURL";
-        return false;
-    }
-
-    try {
-        std::filesystem::path dir = std::filesystem::path(outputPath).parent_path();
-        std::filesystem::create_directories(dir);
-    } catch (const std::exception& e) {
-        g_ErrorMessage = std::string("Error creating directory: ") + e.what();
-        curl_easy_cleanup(curl);
-        return false;
-    }
-
-    FILE* fp = nullptr;
-    errno_t err = fopen_s(&fp, outputPath.c_str(), "wb");
-    if (err != 0 || !fp) {
-        char errbuf[256] = {0};
-        strerror_s(errbuf, sizeof(errbuf), err);
-        g_ErrorMessage = std::string("Failed to open file for writing: ") + errbuf;
-        curl_easy_cleanup(curl);
-        return false;
-    }
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallbackFile);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-    
-    g_DownloadProgress = 0.0f;
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, nullptr);
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-    
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64)");
-    
-    // don't fail immediately on HTTP errors - we'll handle them properly
-    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 0L);
-    
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L);
-    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 500L);  // 500 bytes/sec minimum
-    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 20L);
-    
-    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
-    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
-    
-    // HTTP headers
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Accept: */*");
-    headers = curl_slist_append(headers, "Cache-Control: no-cache");
-    headers = curl_slist_append(headers, "Connection: keep-alive");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    
-    CURLcode res = curl_easy_perform(curl);
-    
-    // get http codes
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    fclose(fp);
-    
-    if (res != CURLE_OK || (http_code >= 400 && http_code < 600)) {
-        std::string errorDetails = res != CURLE_OK ? 
-            std::string("CURL error: ") + curl_easy_strerror(res) :
-            std::string("HTTP error: ") + std::to_string(http_code);
-            
-        g_ErrorMessage = std::string("Download failed: ") + errorDetails;
-        std::filesystem::remove(outputPath);
-        return false;
-    }
-    
-    // verify file has content and integrity
-    try {
-        uintmax_t fileSize = std::filesystem::file_size(outputPath);
-        if (fileSize == 0) {
-            g_ErrorMessage = "Downloaded file is empty. The download may have been blocked or failed.";
-            std::filesystem::remove(outputPath);
-            return false;
-        }
-        const uintmax_t minExpectedSize = 1024;
-        if (fileSize < minExpectedSize) {
-            g_ErrorMessage = "Downloaded file is too small and may be corrupted.";
-            std::filesystem::remove(outputPath);
-            return false;
-        }
-    } catch (const std::exception& e) {
-        g_ErrorMessage = std::string("File size error: ") + e.what();
-        std::filesystem::remove(outputPath);
-        return false;
-    }
-    
-    return true;
-}
-
-bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath) {
-    int err = 0;
-    zip* archive = zip_open(zipPath.c_str(), 0, &err);
-    
-    if (!archive) {
-        g_ErrorMessage = "Failed to open ZIP archive";
-        return false;
-    }
-    
-    try {
-        zip_int64_t num_entries = zip_get_num_entries(archive, 0);
-        
-        for (zip_uint64_t i = 0; i < num_entries; ++i) {
-            const char* name = zip_get_name(archive, i, 0);
-            if (!name) continue;
-            
-            std::string fullOutputPath = extractPath + "\\" + std::string(name);
-            std::filesystem::path outputPath(fullOutputPath);
-            
-            if (name[strlen(name) - 1] == '/') {
-                std::filesystem::create_directories(outputPath);
-            } else {
-                std::filesystem::create_directories(outputPath.parent_path());
-                
-                zip_file* zf = zip_fopen_index(archive, i, 0);
-                if (!zf) continue;
-                
-                FILE* fout = nullptr;
-                errno_t err = fopen_s(&fout, fullOutputPath.c_str(), "wb");
-                if (err == 0 && fout) {
-                    char buffer[8192]; // Larger buffer for better performance
-                    zip_int64_t bytesRead = 0;
-                    while ((bytesRead = zip_fread(zf, buffer, sizeof(buffer))) > 0) {
-                        fwrite(buffer, 1, static_cast<size_t>(bytesRead), fout);
-                    }
-                    fclose(fout);
-                }
-                zip_fclose(zf);
-            }
-        }
-        
-        zip_close(archive);
-        return true;
-    } catch (const std::exception& e) {
-        if (archive) zip_close(archive);
-        g_ErrorMessage = std::string("ZIP extraction error: ") + e.what();
-        return false;
-    }
-}
-
-// create hidden folder
-std::string CreateHiddenFolder() {
-    char appDataPath[MAX_PATH] = {0};
-    if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
-        g_ErrorMessage = "Failed to get AppData path";
-        return "";
-    }
-    
-    std::string folderPath = std::string(appDataPath) + "\\VelocityData";
-    
-    try {
-        std::filesystem::create_directories(folderPath);
-        SetFileAttributesA(folderPath.c_str(), FILE_ATTRIBUTE_HIDDEN);
-    } catch (const std::exception& e) {
-        g_ErrorMessage = std::string("Failed to create hidden folder: ") + e.what();
-        return "";
-    }
-    
-    return folderPath;
-}
-
-// save key
-bool SaveKeyToFile(const std::string& key) {
-    try {
-        std::string keyFilePath = std::filesystem::current_path().string() + "\\key.txt";
-        std::ofstream keyFile(keyFilePath);
-        
-        if (!keyFile.is_open()) {
-            g_ErrorMessage = "Failed to open key file for writing";
-            return false;
-        }
-        
-        keyFile << key;
-        keyFile.close();
-        
-        return true;
-    } catch (const std::exception& e) {
-        g_ErrorMessage = std::string("Failed to save key: ") + e.what();
-        return false;
-    }
-}
-
-// simple http get with better error handling
-std::string HttpGet(const std::wstring& host, const std::wstring& path) {
-    HINTERNET hSession = WinHttpOpen(L"VelocityLauncher/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-        WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS, 0);
-    
-    if (!hSession) {
-        g_ErrorMessage = "Failed to initialize WinHTTP session";
-        return "";
-    }
-    
-    std::string result;
-    HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-    
-    if (hConnect) {
-        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", path.c_str(),
-            nullptr, WINHTTP_NO_REFERER,
-            WINHTTP_DEFAULT_ACCEPT_TYPES,
-            WINHTTP_FLAG_SECURE);
-        
-        if (hRequest) {
-            // set timeouts
-            DWORD timeout = 30000; // 30 seconds
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
-
-            // attempt a few retries
-            const int MAX_RETRIES = 3;
-            for (int retry = 0; retry < MAX_RETRIES; retry++) {
-                if (WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                    WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
-                    WinHttpReceiveResponse(hRequest, nullptr))
-                {
-                    DWORD dwSize = 0;
-                    do {
-                        DWORD dwDownloaded = 0;
-                        if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
-                        
-                        if (dwSize > 0) {
-                            std::vector<char> buffer(dwSize + 1);
-                            ZeroMemory(buffer.data(), buffer.size());
-                            
-                            if (WinHttpReadData(hRequest, buffer.data(), dwSize, &dwDownloaded)) {
-                                result.append(buffer.data(), dwDownloaded);
-                            }
-                        }
-                    } while (dwSize > 0);
-
-                    if (!result.empty()) break;
-                }
-
-                if (retry < MAX_RETRIES - 1) Sleep(1000);
-            }
-            
-            WinHttpCloseHandle(hRequest);
-        }
-        WinHttpCloseHandle(hConnect);
-    }
-    WinHttpCloseHandle(hSession);
-    
-    return result;
-}
-
-// validate key with better error handling
-bool validateKey(const std::string& token) {
-    if (token.empty()) return false;
-    
-    try {
-        std::wstring host = L"work.ink";
-        std::wstring path = L"/_api/v2/token/isValid/";
-        path += std::wstring(token.begin(), token.end());
-        
-        std::string response = HttpGet(host, path);
-        
-        if (response.empty()) {
-            g_ErrorMessage = "No response from validation server";
-            return false;
-        }
-        
-        auto jsonData = json::parse(response);
-        return jsonData["valid"].get<bool>();
-    } catch (const json::parse_error& e) {
-        g_ErrorMessage = std::string("JSON parse error: ") + e.what();
-        return false;
-    } catch (const std::exception& e) {
-        g_ErrorMessage = std::string("Key validation error: ") + e.what();
-        return false;
-    }
-}
-
-// the function that downloads+unzips+creates key
-bool ProcessValidKey(const std::string& key) {
-    // Primary download URL
-    std::string primaryUrl = "https://cdn.discordapp.com/attachments/1364078781626581063/1364431455760945163/VelocityX.zip?ex=680e4290&is=680cf110&hm=62f3f41ec19d7a38727b955af6e2406530af367fc197e7ef10d87850adcc1496&";
-    
-    // Backup download URL - uses a different CDN or direct link if available
-    std::string backupUrl = "link here pls";
-    
-    std::string timestamp = std::to_string(time(nullptr));
-    hiddenFolderPath = CreateHiddenFolder();
-    
-    if (hiddenFolderPath.empty()) {
-        return false; // Error already set in CreateHiddenFolder
-    }
-    
-    std::string zipPath = hiddenFolderPath + "\\VelocityX_" + timestamp + ".zip";
-    std::string synapseFolder = hiddenFolderPath + "\\VelocityX\\Synapse";
-    
-    g_DownloadInProgress = true;
-    bool downloadSuccess = DownloadFileWithRetry(primaryUrl, backupUrl, zipPath);
-    
-    if (!downloadSuccess) {
-        g_DownloadInProgress = false;
-        return false;
-    }
-    
-    if (!ExtractZipFile(zipPath, hiddenFolderPath)) {
-        g_DownloadInProgress = false;
-        return false;
-    }
-    
-    try {
-        std::filesystem::remove(zipPath);
-    } catch (...) {
-        // Ignore cleanup errors
-    }
-    
-    if (!SaveKeyToFile(key)) {
-        g_DownloadInProgress = false;
-        return false;
-    }
-    
-    g_DownloadInProgress = false;
-    return true;
-}
-
-bool CheckForKeyAndLaunchSynapse() {
-    try {
-        std::string keyFilePath = std::filesystem::current_path().string() + "\\key.txt";
-        
-        if (!std::filesystem::exists(keyFilePath)) {
-            return false;
-        }
-        
-        std::ifstream keyFile(keyFilePath);
-        if (!keyFile.is_open()) {
-            return false;
-        }
-        
-        std::string key;
-        std::getline(keyFile, key);
-        keyFile.close();
-        
-        if (key.empty() || !validateKey(key)) {
-            try {
-                std::filesystem::remove(keyFilePath);
-            } catch (...) {}
-            return false;
-        }
-        
-        char appDataPath[MAX_PATH] = {0};
-        if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
-            return false;
-        }
-        
-        std::string synapsePath = std::string(appDataPath) + "\\VelocityData\\VelocityX\\Synapse\\Synapse Launcher.exe";
-        if (!std::filesystem::exists(synapsePath)) {
-            return false;
-        }
-        
-        std::string workingDirectory = std::string(appDataPath) + "\\VelocityData\\VelocityX\\Synapse";
-        
-        SHELLEXECUTEINFOA sei = { 0 };
-        sei.cbSize = sizeof(sei);
-        sei.fMask = SEE_MASK_NOASYNC;
-        sei.hwnd = NULL;
-        sei.lpVerb = "open";
-        sei.lpFile = synapsePath.c_str();
-        sei.lpParameters = NULL;
-        sei.lpDirectory = workingDirectory.c_str();
-        sei.nShow = SW_SHOWNORMAL;
-        
-        if (ShellExecuteExA(&sei)) {
-            exit(0);
-            return true;
-        }
-        
-        return false;
-    } catch (const std::exception&) {
-        return false;
-    }
-}
-
-// thread-safe function to process keys
-void ProcessKeyAsync(const std::string& key) {
-    g_DownloadComplete = false;
-    g_DownloadSuccess = false;
-    g_ErrorMessage.clear();
-    
-    std::thread([key]() {
-        g_DownloadSuccess = ProcessValidKey(key);
-        g_DownloadComplete = true;
-    }).detach();
-}
-
-void GetDesktopResolution() {
-    g_ScreenWidth = GetSystemMetrics(SM_CXSCREEN);
-    g_ScreenHeight = GetSystemMetrics(SM_CYSCREEN);
-}
-
-void KeepWindowInBounds(ImVec2& window_pos, const ImVec2& window_size) {
-    if (window_pos.x < 0) window_pos.x = 0;
-    if (window_pos.y < 0) window_pos.y = 0;
-    if (window_pos.x + window_size.x > g_ScreenWidth) window_pos.x = g_ScreenWidth - window_size.x;
-    if (window_pos.y + window_size.y > g_ScreenHeight) window_pos.y = g_ScreenHeight - window_size.y;
-}
-
-bool CreateDeviceD3D(HWND hWnd) {
-    DXGI_SWAP_CHAIN_DESC sd;
-    ZeroMemory(&sd, sizeof(sd));
-    sd.BufferCount = 2;
-    sd.BufferDesc.Width = 0;
-    sd.BufferDesc.Height = 0;
-    sd.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    sd.BufferDesc.RefreshRate.Numerator = 60;
-    sd.BufferDesc.RefreshRate.Denominator = 1;
-    sd.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-    sd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    sd.OutputWindow = hWnd;
-    sd.SampleDesc.Count = 1;
-    sd.SampleDesc.Quality = 0;
-    sd.Windowed = TRUE;
-    sd.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-
-    UINT createDeviceFlags = 0;
-    D3D_FEATURE_LEVEL featureLevel;
-    const D3D_FEATURE_LEVEL featureLevelArray[2] = { D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_10_0 };
-    HRESULT res = D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, createDeviceFlags, featureLevelArray, 2, D3D11_SDK_VERSION, &sd, &g_pSwapChain, &g_pd3dDevice, &featureLevel, &g_pd3dDeviceContext);
-    
-    if (res == DXGI_ERROR_UNSUPPORTED)
-        res = D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, createDeviceFlags, featureLevelArray, 2, D3D11_SDK_VERSION, &sd, &g_pSwapChain, &g_pd3dDevice, &featureLevel, &g_pd3dDeviceContext);
-    
-    if (res != S_OK)
-        return false;
-
-    CreateRenderTarget();
-    return true;
-}
-
-void CleanupDeviceD3D() {
-    CleanupRenderTarget();
-    if (g_pSwapChain) { g_pSwapChain->Release(); g_pSwapChain = nullptr; }
-    if (g_pd3dDeviceContext) { g_pd3dDeviceContext->Release(); g_pd3dDeviceContext = nullptr; }
-    if (g_pd3dDevice) { g_pd3dDevice->Release(); g_pd3dDevice = nullptr; }
-}
-
-void CreateRenderTarget() {
-    ID3D11Texture2D* pBackBuffer;
-    g_pSwapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer));
-    if (pBackBuffer) {
-        g_pd3dDevice->CreateRenderTargetView(pBackBuffer, nullptr, &g_mainRenderTargetView);
-        pBackBuffer->Release();
-    }
-}
-
-void CleanupRenderTarget() {
-    if (g_mainRenderTargetView) { g_mainRenderTargetView->Release(); g_mainRenderTargetView = nullptr; }
-}
-
-LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
-        return 1;
-
-    switch (msg) {
-    case WM_SIZE:
-        if (wParam == SIZE_MINIMIZED)
-            return 0;
-        g_ResizeWidth = (UINT)LOWORD(lParam);
-        g_ResizeHeight = (UINT)HIWORD(lParam);
-        return 0;
-    case WM_SYSCOMMAND:
-        if ((wParam & 0xfff0) == SC_KEYMENU)
-            return 0;
-        break;
-    case WM_DESTROY:
-        ::PostQuitMessage(0);
-        return 0;
-    }
-    return ::DefWindowProcW(hWnd, msg, wParam, lParam);
-}
-
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-    // init curl 
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    GetDesktopResolution();
-    
-    char appDataPath[MAX_PATH] = {0};
-    SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath);
-    hiddenFolderPath = std::string(appDataPath) + "\\VelocityData";
-
-    if (CheckForKeyAndLaunchSynapse()) {
-        curl_global_cleanup();
-        return 0;
-    }
-
-    WNDCLASSEXW wc = { sizeof(wc), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(nullptr), nullptr, nullptr, nullptr, nullptr, L"Velocity Custom Launcher", nullptr };
-    ::RegisterClassExW(&wc);
-    HWND hwnd = ::CreateWindowExW(WS_EX_LAYERED | WS_EX_TOPMOST, L"Velocity Custom Launcher", NULL, WS_POPUP, 100, 100, 1920, 1080, NULL, NULL, wc.hInstance, NULL);
-
-    static bool first_frame = true;
-    if (first_frame) {
-        first_frame = false;
-        SetLayeredWindowAttributes(hwnd, RGB(0, 0, 0), 0, ULW_COLORKEY);
-    }
-
-    if (!CreateDeviceD3D(hwnd)) {
-        CleanupDeviceD3D();
-        ::UnregisterClassW(wc.lpszClassName, wc.hInstance);
-        curl_global_cleanup();
-        return 1;
-    }
-
-    ::ShowWindow(hwnd, SW_SHOWDEFAULT);
-    ::UpdateWindow(hwnd);
-
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-
-    ImGuiStyle& style = ImGui::GetStyle();
-    style.WindowRounding = 8.0f;
-    style.FrameRounding = 6.0f;
-    style.GrabRounding = 6.0f;
-
-    ImVec4* colors = style.Colors;
-    colors[ImGuiCol_WindowBg] = ImVec4(0.10f, 0.12f, 0.15f, 1.0f);
-    colors[ImGuiCol_Button] = ImVec4(0.20f, 0.22f, 0.27f, 1.0f);
-    colors[ImGuiCol_ButtonHovered] = ImVec4(0.30f, 0.32f, 0.38f, 1.0f);
-    colors[ImGuiCol_ButtonActive] = ImVec4(0.25f, 0.28f, 0.35f, 1.0f);
-    colors[ImGuiCol_FrameBg] = ImVec4(0.16f, 0.18f, 0.22f, 1.0f);
-    colors[ImGuiCol_FrameBgHovered] = ImVec4(0.20f, 0.22f, 0.27f, 1.0f);
-    colors[ImGuiCol_FrameBgActive] = ImVec4(0.18f, 0.20f, 0.25f, 1.0f);
-
-    ImGui::StyleColorsDark();
-    ImGui_ImplWin32_Init(hwnd);
-    ImGui_ImplDX11_Init(g_pd3dDevice, g_pd3dDeviceContext);
-
-    ImVec4 clear_color = colors[ImGuiCol_WindowBg]; // match background
-    static char key_input[64] = "";
-    bool done = false;
-
-    ImVec2 window_size = ImVec2(440, 180);
-    ImVec2 window_pos = ImVec2((g_ScreenWidth - window_size.x) / 2, (g_ScreenHeight - window_size.y) / 2);
-    
-    static bool show_error_popup = false;
-    static bool show_success_popup = false;
-    static std::string error_message;
-    static bool is_dragging = false;
-
-    while (!done) {
-        MSG msg;
-        while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE)) {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
-            if (msg.message == WM_QUIT)
-                done = true;
-        }
-        if (done) break;
-
-        if (g_ResizeWidth != 0 && g_ResizeHeight != 0) {
-            CleanupRenderTarget();
-            g_pSwapChain->ResizeBuffers(0, g_ResizeWidth, g_ResizeHeight, DXGI_FORMAT_UNKNOWN, 0);
-            g_ResizeWidth = g_ResizeHeight = 0;
-            CreateRenderTarget();
-        }
-        
-        if (g_DownloadComplete) {
-            g_DownloadInProgress = false;
-            if (g_DownloadSuccess) {
-                show_success_popup = true;
-                // Add a small delay before exiting
-                std::thread([hwnd]() {
-                    Sleep(2000);
-                    ::PostMessage(hwnd, WM_QUIT, 0, 0);
-                }).detach();
-            } else {
-                show_error_popup = true;
-                error_message = g_ErrorMessage.empty() ? 
-                    "Download or extraction failed. Please try again." : g_ErrorMessage;
-            }
-            g_DownloadComplete = false;
-        }
-
-        ImGui_ImplDX11_NewFrame();
-        ImGui_ImplWin32_NewFrame();
-        ImGui::NewFrame();
-
-        KeepWindowInBounds(window_pos, window_size);
-
-        ImGui::SetNextWindowPos(window_pos, ImGuiCond_Always);
-        ImGui::SetNextWindowSize(window_size);
-        ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration;
-
-        ImGui::Begin("Key System", nullptr, window_flags);
-        {
-            ImGui::InvisibleButton("drag_zone", ImVec2(window_size.x, 20));
-            if (ImGui::IsItemHovered() || is_dragging) {
-                ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeAll);
-                
-                if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
-                    if (!is_dragging) {
-                        is_dragging = true;
-                        ImGui::ResetMouseDragDelta();
-                    } else {
-                        ImVec2 delta = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left);
-                        window_pos.x += delta.x;
-                        window_pos.y += delta.y;
-                        ImGui::ResetMouseDragDelta();
-                    }
-                } else {
-                    is_dragging = false;
-                }
-            }
-
-            ImGui::Spacing(); ImGui::Spacing();
-
-            float total_width = 350 + style.ItemSpacing.x + 85;
-            ImGui::SetNextItemWidth(270);
-
-            float indent_x = (ImGui::GetWindowSize().x - total_width) * 0.5f;
-            ImGui::Indent(indent_x);
-
-            ImGui::Text("Enter Key:");
-            ImGui::SameLine();
-            ImGui::SetNextItemWidth(250);
-            ImGui::InputText("##keyinput", key_input, IM_ARRAYSIZE(key_input));
-            ImGui::SameLine();
-
-            bool button_disabled = g_DownloadInProgress;
-            
-            if (button_disabled)
-                ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
-                
-            if (ImGui::Button("Confirm", ImVec2(85, 0)) && !button_disabled) {
-                if (strlen(key_input) == 0) {
-                    show_error_popup = true;
-                    error_message = "Please enter a key";
-                } else {
-                    bool valid = validateKey(key_input);
-                    if (valid) {
-                        ProcessKeyAsync(key_input);
-                    } else {
-                        show_error_popup = true;
-                        error_message = g_ErrorMessage.empty() ? 
-                            "Invalid key. Try again." : g_ErrorMessage;
-                    }
-                }
-            }
-            
-            if (button_disabled)
-                ImGui::PopStyleVar();
-                
-            ImGui::Unindent(indent_x);
-
-            // error popup
-            if (show_error_popup) {
-                ImVec2 main_window_pos = ImGui::GetWindowPos();
-                ImVec2 main_window_size = ImGui::GetWindowSize();
-                float popup_width = 300.0f;
-                ImVec2 popup_pos = ImVec2(
-                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
-                    main_window_pos.y + main_window_size.y + 10.0f
-                );
-                
-                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 80));
-
-                ImGui::SetNextWindowPos(popup_pos);
-                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
-
-                if (ImGui::Begin("##ErrorPopup", nullptr,
-                    ImGuiWindowFlags_NoTitleBar |
-                    ImGuiWindowFlags_NoResize |
-                    ImGuiWindowFlags_NoMove |
-                    ImGuiWindowFlags_NoSavedSettings |
-                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
-                    ImGui::TextWrapped("%s", error_message.c_str());
-                    ImGui::SetCursorPosX((ImGui::GetWindowWidth() - 100) * 0.5f);
-                    if (ImGui::Button("OK", ImVec2(100, 30))) {
-                        show_error_popup = false;
-                    }
-                    ImGui::End();
-                }
-            }
-            
-            // success popup
-            if (show_success_popup) {
-                ImVec2 main_window_pos = ImGui::GetWindowPos();
-                ImVec2 main_window_size = ImGui::GetWindowSize();
-                float popup_width = 300.0f;
-                ImVec2 popup_pos = ImVec2(
-                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
-                    main_window_pos.y + main_window_size.y + 10.0f
-                );
-                
-                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 80));
-
-                ImGui::SetNextWindowPos(popup_pos);
-                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
-
-                if (ImGui::Begin("##SuccessPopup", nullptr,
-                    ImGuiWindowFlags_NoTitleBar |
-                    ImGuiWindowFlags_NoResize |
-                    ImGuiWindowFlags_NoMove |
-                    ImGuiWindowFlags_NoSavedSettings |
-                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
-                    ImGui::TextWrapped("Successfully downloaded. Please re-open the launcher!\n(ily mommy lina <3)");
-                    ImGui::SetCursorPosX((ImGui::GetWindowWidth() - 100) * 0.5f);
-                    if (ImGui::Button("OK", ImVec2(100, 30))) {
-                        show_success_popup = false;
-                        ::PostMessage(hwnd, WM_QUIT, 0, 0);
-                    }
-                    ImGui::End();
-                }
-            }
-
-            // download progress display
-            if (g_DownloadInProgress) {
-                ImVec2 main_window_pos = ImGui::GetWindowPos();
-                ImVec2 main_window_size = ImGui::GetWindowSize();
-                float popup_width = 300.0f;
-                ImVec2 popup_pos = ImVec2(
-                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
-                    main_window_pos.y + main_window_size.y + 10.0f
-                );
-                
-                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 70));
-
-                ImGui::SetNextWindowPos(popup_pos);
-                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
-
-                if (ImGui::Begin("##DownloadingPopup", nullptr,
-                    ImGuiWindowFlags_NoTitleBar |
-                    ImGuiWindowFlags_NoResize |
-                    ImGuiWindowFlags_NoMove |
-                    ImGuiWindowFlags_NoSavedSettings |
-                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
-                    ImGui::TextWrapped("Downloading and extracting VelocityX. Please wait...");
-                    
-                    char buffer[32];
-                    sprintf_s(buffer, "%.0f%%", g_DownloadProgress * 100.0f);
-                    ImGui::ProgressBar(g_DownloadProgress, ImVec2(-1, 0), buffer);
-                    
-                    ImGui::End();
-                }
-            }
-
-            ImGui::Dummy(ImVec2(0.0f, 10.0f));
-            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - 100) * 0.5f);
-            if (ImGui::Button("Get Key", ImVec2(100, 0)) && !g_DownloadInProgress) {
-                OpenBrowser(L"https://workink.net/1Y5j/9qk7e7ho");
-            }
-
-            ImGui::Dummy(ImVec2(0.0f, 12.0f));
-            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - ImGui::CalcTextSize("A lifetime key can be purchased to skip this.").x) * 0.5f);
-            ImGui::Text("A lifetime key can be purchased to skip this.");
-
-            ImGui::Dummy(ImVec2(0.0f, 10.0f));
-            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - 150) * 0.5f);
-            if (ImGui::Button("Contact Reseller", ImVec2(150, 0)) && !g_DownloadInProgress) {
-                // XGs32yXdaQ
-                OpenBrowser(L"https://discord.gg/XGs32yXdaQ");
-            }
-        }
-        ImGui::End();
-
-        ImGui::Render();
-        const float clear_color_with_alpha[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-        g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView, nullptr);
-        g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView, clear_color_with_alpha);
-        ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-
-        g_pSwapChain->Present(1, 0);
-    }
-
-    ImGui_ImplDX11_Shutdown();
-    ImGui_ImplWin32_Shutdown();
-    ImGui::DestroyContext();
-
-    CleanupDeviceD3D();
-    ::DestroyWindow(hwnd);
-    ::UnregisterClassW(wc.lpszClassName, wc.hInstance);
-    
-    curl_global_cleanup();
-
-    return 0;
-}
+// Contribution: linhforreal
+#include "imgui.h"
+#include "imgui_impl_win32.h"
+#include "imgui_impl_dx11.h"
+#include <d3d11.h>
+#include <tchar.h>
+#include <Windows.h>
+#include <filesystem>
+#include <shellapi.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include <shlobj.h>
+#include "crc32.h"
+#include "download.h"
+#include "extract.h"
+#include "http.h"
+#include "inflater.h"
+#include "keycache.h"
+#include "license.h"
+#include "sha256.h"
+#include "staging.h"
+#include "store.h"
+#include <wininet.h>
+
+#pragma comment(lib, "zlib.lib")
+#pragma comment(lib, "wininet.lib")
+
+// GLOBALS...
+extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+static std::string hiddenFolderPath;
+static std::atomic<float> g_DownloadProgress = 0.0f;       // running install stage, written from transfer threads
+static std::string g_ErrorMessage;                          // install thread only once the UI is up
+static std::shared_ptr<std::atomic<bool>> g_InstallCancel; // carried by every download request of the install
+
+// segmented downloads
+static int g_DownloadSegments = 4;                   // parallel byte ranges per file, 1 = single stream
+static const curl_off_t g_MinSegmentSize = 1 << 20; // don't split below 1 MB per range
+static bool g_ResumeDownloads = true;                // keep partial files + journal for the next attempt
+static bool g_StreamingExtract = true;               // extract while downloading, no zip on disk
+static unsigned g_ExtractThreads = 0;                // zip extraction workers, 0 = one per core
+static const uint64_t g_DeltaMinSize = 1 << 20;      // manifest updates patch files this big by block
+static bool g_UseContentStore = true;                // keep extracted files in a hash store, skip/link what's unchanged
+static const int g_StallRetries = 3;                 // reconnects per range after a stall before giving up
+static double g_ExpectedBytesPerSec = 0.0;           // what the chosen mirror managed last time, 0 = unknown
+static const size_t g_KeepVersions = 2;              // replaced installs kept for rollback (--rollback)
+
+// offline license tokens - leave either empty to validate online on every start
+static const std::string g_LicensePublicKey = "";    // license server's Ed25519 public key, hex
+static const std::string g_LicenseTokenUrl = "";     // signs a token for the key appended to it
+static KeyValidationCache g_KeyCache;                // validation answers, kept in the install folder
+
+// DirectX globals...
+static ID3D11Device* g_pd3dDevice = nullptr;
+static ID3D11DeviceContext* g_pd3dDeviceContext = nullptr;
+static IDXGISwapChain* g_pSwapChain = nullptr;
+static bool g_SwapChainOccluded = false;
+static UINT g_ResizeWidth = 0, g_ResizeHeight = 0;
+static ID3D11RenderTargetView* g_mainRenderTargetView = nullptr;
+
+// Screen boundaries
+static int g_ScreenWidth = 0;
+static int g_ScreenHeight = 0;
+
+// function declarations
+bool CreateDeviceD3D(HWND hWnd);
+void CleanupDeviceD3D();
+void CreateRenderTarget();
+void CleanupRenderTarget();
+LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+bool CheckForKeyAndLaunchSynapse();
+std::string CreateHiddenFolder();
+bool DownloadFile(const std::string& url, const std::string& outputPath);
+bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath);
+bool DownloadAndExtract(const std::string& url, const std::string& extractPath, const std::string& expectedSha256 = "", curl_off_t* received = nullptr);
+bool UpdateFromManifest(const std::string& manifestUrl, const std::string& installPath);
+bool SaveKeyToFile(const std::string& key);
+bool validateKey(const std::string& token);
+void OpenBrowser(const std::wstring& url);
+
+using json = nlohmann::json;
+
+// easy url opening
+void OpenBrowser(const std::wstring& url) {
+    ShellExecuteW(nullptr, L"open", url.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
+}
+
+static void UpdateProgress(curl_off_t dltotal, curl_off_t dlnow) {
+    g_DownloadProgress = dltotal > 0 ? static_cast<float>(dlnow) / static_cast<float>(dltotal) : 0.0f;
+}
+
+// options shared by every download request (single stream, range segments, manifest)
+static HttpRequest DownloadRequest(const std::string& url) {
+    HttpRequest request;
+    request.url = url;
+    request.verifyPeer = false;
+    request.userAgent = "Mozilla/5.0 (Windows NT 10.0; Win64; x64)";
+    
+    request.timeout = 60;
+    request.connectTimeout = 15;
+    request.lowSpeedLimit = 500;  // 500 bytes/sec minimum
+    request.lowSpeedTime = 20;
+    request.maxRedirects = 10;
+    
+    // HTTP headers
+    request.headers = { "Accept: */*", "Cache-Control: no-cache", "Connection: keep-alive" };
+    request.cancel = g_InstallCancel;
+    return request;
+}
+
+// published digests may come in either case
+static bool DigestMatches(const std::string& digest, const std::string& expected) {
+    return digest.size() == expected.size() && std::equal(digest.begin(), digest.end(), expected.begin(),
+        [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+}
+
+// verify file has content and integrity. with a published digest the file has to match it,
+// actualSha256 is what the download hashed on the way in so the file is only read back without it
+static bool VerifyDownloadedFile(const std::string& outputPath, const std::string& expectedSha256 = "", const std::string& actualSha256 = "") {
+    try {
+        uintmax_t fileSize = std::filesystem::file_size(outputPath);
+        if (fileSize == 0) {
+            g_ErrorMessage = "Downloaded file is empty. The download may have been blocked or failed.";
+            std::filesystem::remove(outputPath);
+            return false;
+        }
+        const uintmax_t minExpectedSize = 1024;
+        if (fileSize < minExpectedSize) {
+            g_ErrorMessage = "Downloaded file is too small and may be corrupted.";
+            std::filesystem::remove(outputPath);
+            return false;
+        }
+    } catch (const std::exception& e) {
+        g_ErrorMessage = std::string("File size error: ") + e.what();
+        std::filesystem::remove(outputPath);
+        return false;
+    }
+    
+    if (!expectedSha256.empty()) {
+        std::string digest = !actualSha256.empty() ? actualSha256 : Sha256File(outputPath);
+        if (!DigestMatches(digest, expectedSha256)) {
+            g_ErrorMessage = "Downloaded file is corrupted (checksum mismatch).";
+            std::filesystem::remove(outputPath);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// the launcher's settings for FetchFile, read again for every file: the expected rate follows the mirror
+static DownloadOptions LauncherDownloadOptions() {
+    DownloadOptions options;
+    options.request = DownloadRequest("");
+    options.segments = g_DownloadSegments;
+    options.minSegmentSize = g_MinSegmentSize;
+    options.resume = g_ResumeDownloads;
+    options.stallRetries = g_StallRetries;
+    options.expectedBytesPerSec = g_ExpectedBytesPerSec;
+    options.progress = &g_DownloadProgress;
+    return options;
+}
+
+static bool FetchFile(const std::string& url, const std::string& outputPath, std::string* sha256 = nullptr) {
+    std::string error;
+    if (FetchFile(url, outputPath, LauncherDownloadOptions(), error, sha256)) return true;
+    g_ErrorMessage = error;
+    return false;
+}
+
+bool DownloadFile(const std::string& url, const std::string& outputPath) {
+    return FetchFile(url, outputPath) && VerifyDownloadedFile(outputPath);
+}
+
+// mirror selection. each install races the first byte from the configured mirrors, and what it
+// learns about each one goes into mirrors.json so the next run starts on the one that's been fastest
+struct MirrorScore {
+    double latencyMs = 0.0;   // first byte, moving average
+    double bytesPerSec = 0.0; // whole payload, moving average
+    int failures = 0;         // in a row
+};
+
+static const int g_MirrorStaggerMs = 250; // head start each mirror gets before the next joins the race
+
+// scores are per mirror, not per link - signed CDN links get a new query string every time
+static std::string MirrorKey(const std::string& url) {
+    return url.substr(0, url.find('?'));
+}
+
+static std::string MirrorScorePath(const std::string& folder) {
+    return folder + "\\mirrors.json";
+}
+
+static std::map<std::string, MirrorScore> LoadMirrorScores(const std::string& folder) {
+    std::map<std::string, MirrorScore> scores;
+    try {
+        std::ifstream file(MirrorScorePath(folder));
+        if (!file.is_open()) return scores;
+        
+        json data = json::parse(file);
+        for (const auto& [key, item] : data.items()) {
+            MirrorScore score;
+            score.latencyMs = item["latencyMs"].get<double>();
+            score.bytesPerSec = item["bytesPerSec"].get<double>();
+            score.failures = item["failures"].get<int>();
+            scores[key] = score;
+        }
+    } catch (...) {
+        scores.clear(); // just start over, the next race rebuilds them
+    }
+    return scores;
+}
+
+static void SaveMirrorScores(const std::string& folder, const std::map<std::string, MirrorScore>& scores) {
+    try {
+        json data = json::object();
+        for (const auto& [key, score] : scores) {
+            data[key] = { { "latencyMs", score.latencyMs }, { "bytesPerSec", score.bytesPerSec }, { "failures", score.failures } };
+        }
+        
+        // same write-then-rename as the download journal
+        std::string scorePath = MirrorScorePath(folder);
+        std::string tempPath = scorePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) return;
+            file << data.dump();
+        }
+        std::filesystem::rename(tempPath, scorePath);
+    } catch (...) {}
+}
+
+static double MovingAverage(double average, double sample) {
+    return average > 0.0 ? average * 0.7 + sample * 0.3 : sample;
+}
+
+// expected time to get the payload from a mirror, lower is better. a mirror that's never been
+// measured is assumed to do 1 MB/s, recent failures push it back behind the working ones
+static double MirrorCost(const MirrorScore& score) {
+    const double payloadBytes = 16.0 * 1024 * 1024;
+    double latencyMs = score.latencyMs > 0.0 ? score.latencyMs : 500.0;
+    double bytesPerSec = score.bytesPerSec > 0.0 ? score.bytesPerSec : 1024.0 * 1024.0;
+    return (latencyMs + payloadBytes / bytesPerSec * 1000.0) * (1 << std::min(score.failures, 4));
+}
+
+static void RecordMirrorThroughput(std::map<std::string, MirrorScore>& scores, const std::string& url, curl_off_t bytes, double seconds) {
+    MirrorScore& score = scores[MirrorKey(url)];
+    score.failures = 0;
+    if (bytes > 0 && seconds > 0.0) score.bytesPerSec = MovingAverage(score.bytesPerSec, bytes / seconds);
+}
+
+// happy-eyeballs style: the best-scored mirror asks for byte 0 first, each g_MirrorStaggerMs
+// without an answer lets the next one join, and the first to send a byte wins while the rest
+// are cancelled. returns every mirror, winner first and the others by score, so the download
+// stage still has fallbacks
+static std::vector<std::string> RaceMirrors(const std::vector<std::string>& mirrors, std::map<std::string, MirrorScore>& scores) {
+    std::vector<std::string> ordered = mirrors;
+    std::stable_sort(ordered.begin(), ordered.end(), [&scores](const std::string& a, const std::string& b) {
+        return MirrorCost(scores[MirrorKey(a)]) < MirrorCost(scores[MirrorKey(b)]);
+    });
+    if (ordered.size() < 2) return ordered;
+    
+    struct Contender {
+        std::shared_ptr<std::atomic<bool>> cancel = std::make_shared<std::atomic<bool>>(false);
+        std::future<HttpResponse> response;
+        std::chrono::steady_clock::time_point started;
+        bool finished = false;
+    };
+    std::vector<Contender> contenders(ordered.size());
+    size_t started = 0;
+    int winner = -1;
+    auto lastStart = std::chrono::steady_clock::now();
+    
+    while (winner < 0 && !(g_InstallCancel && *g_InstallCancel)) {
+        auto now = std::chrono::steady_clock::now();
+        bool waiting = false;
+        for (size_t i = 0; i < started; i++) waiting = waiting || !contenders[i].finished;
+        
+        // the next mirror joins when the leaders are slow to answer, or right away once they've all failed
+        if (started < ordered.size() && (!waiting || now - lastStart >= std::chrono::milliseconds(g_MirrorStaggerMs))) {
+            HttpRequest request = DownloadRequest(ordered[started]);
+            request.range = "0-0";
+            request.timeout = 15;
+            request.cancel = contenders[started].cancel;
+            request.onData = [](const char*, size_t) { return false; }; // the first byte is all we wanted
+            
+            contenders[started].started = now;
+            contenders[started].response = DefaultHttpClient().Send(std::move(request));
+            started++;
+            lastStart = now;
+            continue;
+        }
+        if (!waiting) break; // every mirror failed
+        
+        for (size_t i = 0; i < started && winner < 0; i++) {
+            Contender& contender = contenders[i];
+            if (contender.finished || contender.response.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+            
+            contender.finished = true;
+            HttpResponse response = contender.response.get();
+            bool answered = (response.status == 200 || response.status == 206) &&
+                (response.Ok() || response.result == CURLE_WRITE_ERROR);
+            MirrorScore& score = scores[MirrorKey(ordered[i])];
+            if (answered) {
+                winner = static_cast<int>(i);
+                score.latencyMs = MovingAverage(score.latencyMs,
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - contender.started).count());
+                score.failures = 0;
+            } else {
+                score.failures++;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    for (size_t i = 0; i < started; i++) {
+        if (!contenders[i].finished) *contenders[i].cancel = true;
+    }
+    if (winner > 0) std::rotate(ordered.begin(), ordered.begin() + winner, ordered.begin() + winner + 1);
+    return ordered;
+}
+
+// the content store lives inside the data folder, on the same volume as the staging folder and
+// the live install, so blobs can be hardlinked into either. null if it's turned off or can't be
+// opened, extraction then just writes everything
+static ContentStore* OpenContentStore(ContentStore& store) {
+    std::string error;
+    if (!g_UseContentStore || !store.Open(std::filesystem::path(hiddenFolderPath) / ".store", error)) {
+        return nullptr;
+    }
+    return &store;
+}
+
+// which CPU paths extraction runs on, for the debug log
+static void LogExtractBackends() {
+    OutputDebugStringA((std::string("extract: crc32 ") + Crc32Backend() + ", inflate " + Inflater::WholeBackend() +
+        " whole / " + Inflater::StreamBackend() + " streaming\n").c_str());
+}
+
+// download the archive as one stream and extract entries while the bytes are still arriving.
+// the zip never lands on disk, so network and disk time overlap and peak disk use is just the payload
+// with a published digest the archive is hashed on its way through the extractor as well
+bool DownloadAndExtract(const std::string& url, const std::string& extractPath, const std::string& expectedSha256, curl_off_t* received) {
+    ContentStore storage;
+    ContentStore* store = OpenContentStore(storage);
+    StreamingZipExtractor extractor(extractPath, store);
+    LogExtractBackends();
+    
+    if (received) *received = 0;
+    Sha256 hasher;
+    bool hashing = !expectedSha256.empty();
+    HttpRequest request = PayloadRequest(LauncherDownloadOptions(), url, -1);
+    std::shared_ptr<TransferWatchdog> watchdog = request.watchdog;
+    request.onData = [&extractor, &hasher, hashing, received](const char* data, size_t size) {
+        if (received) *received += size;
+        if (hashing) hasher.Update(data, size);
+        return extractor.Feed(data, size);
+    };
+    
+    g_DownloadProgress = 0.0f;
+    request.onProgress = UpdateProgress;
+    
+    HttpResponse response = DefaultHttpClient().Fetch(std::move(request));
+    
+    bool extracted = false;
+    if (response.status >= 400 && response.status < 600) {
+        g_ErrorMessage = std::string("Download failed: HTTP error: ") + std::to_string(response.status);
+    } else if (!extractor.Error().empty()) {
+        g_ErrorMessage = extractor.Error();
+    } else if (!response.Ok()) {
+        g_ErrorMessage = std::string("Download failed: ") + TransferError(response, *watchdog);
+    } else if (!extractor.Finish()) {
+        g_ErrorMessage = extractor.Error();
+    } else if (hashing && !DigestMatches(Sha256::ToHex(hasher.Final()), expectedSha256)) {
+        g_ErrorMessage = "Downloaded archive is corrupted (checksum mismatch).";
+    } else {
+        extracted = true;
+    }
+    
+    // keep what did get written for the retry, only prune after the whole archive went through
+    std::string storeError;
+    if (store) store->Commit(extracted, storeError);
+    return extracted;
+}
+
+bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath) {
+    ContentStore storage;
+    ContentStore* store = OpenContentStore(storage);
+    
+    std::string error;
+    LogExtractBackends();
+    bool extracted = ExtractZipParallel(zipPath, extractPath, g_ExtractThreads, error, store);
+    if (!extracted) {
+        g_ErrorMessage = error;
+    }
+    
+    // keep what did get written for the retry, only prune after a complete pass
+    std::string storeError;
+    if (store) store->Commit(extracted, storeError);
+    return extracted;
+}
+
+// GET a small document (update manifest etc) into memory
+static bool DownloadToString(const std::string& url, std::string& body) {
+    HttpResponse response = DefaultHttpClient().Fetch(DownloadRequest(url));
+    
+    if (!response.Ok() || response.status != 200) {
+        g_ErrorMessage = !response.Ok() ? 
+            std::string("Download failed: CURL error: ") + response.error :
+            std::string("Download failed: HTTP error: ") + std::to_string(response.status);
+        return false;
+    }
+    body = std::move(response.body);
+    return true;
+}
+
+// one payload file as published in the update manifest
+struct ManifestFile {
+    std::string path;
+    uint64_t size = 0;
+    std::string sha256;
+    std::string url;
+    std::vector<std::string> blocks; // sha256 of each blockSize chunk, lets big files be patched by range
+};
+
+// {"version": "...", "baseUrl": "...", "blockSize": 1048576,
+//  "files": [{"path": "VelocityX/Synapse/...", "size": 123, "sha256": "...", "url": "...", "blocks": ["..."]}]}
+struct UpdateManifest {
+    std::string version;
+    uint64_t blockSize = 0;
+    std::vector<ManifestFile> files;
+};
+
+static bool ParseManifest(const std::string& text, UpdateManifest& manifest) {
+    try {
+        json data = json::parse(text);
+        std::string baseUrl = data.value("baseUrl", "");
+        manifest.version = data.value("version", "");
+        manifest.blockSize = data.value("blockSize", static_cast<uint64_t>(0));
+        manifest.files.clear();
+        
+        for (const auto& item : data["files"]) {
+            ManifestFile file;
+            file.path = item["path"].get<std::string>();
+            file.size = item["size"].get<uint64_t>();
+            file.sha256 = item["sha256"].get<std::string>();
+            file.url = item.value("url", baseUrl + file.path);
+            if (item.contains("blocks")) {
+                file.blocks = item["blocks"].get<std::vector<std::string>>();
+                // local blocks are looked up by their lowercase hex digest
+                for (std::string& block : file.blocks) {
+                    std::transform(block.begin(), block.end(), block.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                }
+            }
+            
+            if (!IsSafeEntryName(file.path) || file.sha256.size() != 64) {
+                g_ErrorMessage = "Update manifest has an invalid entry: " + file.path;
+                return false;
+            }
+            // block hashes mean nothing without the size they were taken at
+            if (!file.blocks.empty() && manifest.blockSize == 0) {
+                g_ErrorMessage = "Update manifest lists blocks without a blockSize: " + file.path;
+                return false;
+            }
+            manifest.files.push_back(std::move(file));
+        }
+        return true;
+    } catch (const std::exception& e) {
+        g_ErrorMessage = std::string("Update manifest error: ") + e.what();
+        return false;
+    }
+}
+
+// rebuild a changed file from the blocks we already have locally plus ranged fetches of the rest.
+// local blocks are matched by hash wherever they sit, so whole-block moves cost nothing either
+static bool PatchFileByBlocks(const ManifestFile& file, uint64_t blockSize, const std::filesystem::path& localPath,
+    const std::filesystem::path& tempPath, uint64_t& bytesFetched) {
+    if (blockSize == 0) return false;
+    uint64_t blockCount = (file.size + blockSize - 1) / blockSize;
+    if (file.blocks.size() != blockCount) return false;
+    
+    FILE* local = nullptr;
+    FILE* out = nullptr;
+    if (fopen_s(&local, localPath.string().c_str(), "rb") != 0 || !local) return false;
+    if (fopen_s(&out, tempPath.string().c_str(), "wb") != 0 || !out) {
+        fclose(local);
+        return false;
+    }
+    
+    std::vector<char> buffer(static_cast<size_t>(blockSize));
+    std::unordered_map<std::string, uint64_t> localBlocks;
+    size_t bytesRead = 0;
+    for (uint64_t offset = 0; (bytesRead = fread(buffer.data(), 1, buffer.size(), local)) > 0; offset += bytesRead) {
+        Sha256 hasher;
+        hasher.Update(buffer.data(), bytesRead);
+        localBlocks.emplace(Sha256::ToHex(hasher.Final()), offset);
+    }
+    
+    // copy the blocks we have, collect the ones we don't into contiguous ranges
+    std::vector<std::pair<uint64_t, uint64_t>> missing;
+    bool ok = true;
+    for (uint64_t i = 0; i < blockCount && ok; ++i) {
+        uint64_t start = i * blockSize;
+        size_t length = static_cast<size_t>((std::min)(blockSize, file.size - start));
+        auto found = localBlocks.find(file.blocks[i]);
+        
+        if (found == localBlocks.end()) {
+            if (!missing.empty() && missing.back().second + 1 == start) {
+                missing.back().second = start + length - 1;
+            } else {
+                missing.emplace_back(start, start + length - 1);
+            }
+            continue;
+        }
+        
+        ok = _fseeki64(local, static_cast<long long>(found->second), SEEK_SET) == 0 &&
+            fread(buffer.data(), 1, length, local) == length &&
+            _fseeki64(out, static_cast<long long>(start), SEEK_SET) == 0 &&
+            fwrite(buffer.data(), 1, length, out) == length;
+    }
+    fclose(local);
+    
+    // one after another on the pooled connection, they all write through the same handle
+    for (const auto& range : missing) {
+        if (!ok) break;
+        
+        if (_fseeki64(out, static_cast<long long>(range.first), SEEK_SET) != 0) {
+            ok = false;
+            break;
+        }
+        
+        curl_off_t written = 0;
+        ok = FetchRange(file.url, static_cast<curl_off_t>(range.first), static_cast<curl_off_t>(range.second), out,
+            LauncherDownloadOptions(), written);
+        bytesFetched += static_cast<uint64_t>(written);
+    }
+    
+    if (fclose(out) != 0) ok = false;
+    
+    return ok;
+}
+
+// bring an existing install up to date from the server's manifest, fetching only files whose
+// content hash differs (and only the changed blocks of big ones). files dropped from the
+// manifest since the last update are removed
+bool UpdateFromManifest(const std::string& manifestUrl, const std::string& installPath) {
+    std::string manifestText;
+    UpdateManifest manifest;
+    if (!DownloadToString(manifestUrl, manifestText) || !ParseManifest(manifestText, manifest)) {
+        return false;
+    }
+    
+    std::filesystem::path root(installPath);
+    std::filesystem::path manifestPath = root / "manifest.json";
+    
+    try {
+        // work out what actually changed before touching the network again
+        std::vector<const ManifestFile*> changed;
+        uint64_t bytesPlanned = 0;
+        for (const ManifestFile& file : manifest.files) {
+            std::filesystem::path localPath = root / file.path;
+            std::error_code ec;
+            uint64_t localSize = std::filesystem::file_size(localPath, ec);
+            if (!ec && localSize == file.size && DigestMatches(Sha256File(localPath), file.sha256)) continue;
+            
+            changed.push_back(&file);
+            bytesPlanned += file.size;
+        }
+        
+        g_DownloadProgress = 0.0f;
+        uint64_t bytesDone = 0;
+        
+        for (const ManifestFile* file : changed) {
+            std::filesystem::path localPath = root / file->path;
+            std::filesystem::path tempPath = localPath;
+            tempPath += ".new";
+            std::filesystem::create_directories(localPath.parent_path());
+            
+            uint64_t bytesFetched = 0;
+            bool patched = file->size >= g_DeltaMinSize && std::filesystem::exists(localPath) &&
+                PatchFileByBlocks(*file, manifest.blockSize, localPath, tempPath, bytesFetched) &&
+                DigestMatches(Sha256File(tempPath), file->sha256);
+            
+            if (!patched) {
+                std::string digest;
+                if (!FetchFile(file->url, tempPath.string(), &digest)) {
+                    return false;
+                }
+                if (!DigestMatches(digest, file->sha256)) {
+                    std::filesystem::remove(tempPath);
+                    g_ErrorMessage = "Downloaded file failed its hash check: " + file->path;
+                    return false;
+                }
+            }
+            
+            std::filesystem::rename(tempPath, localPath);
+            bytesDone += file->size;
+            g_DownloadProgress = bytesPlanned > 0 ? static_cast<float>(bytesDone) / static_cast<float>(bytesPlanned) : 1.0f;
+        }
+        
+        // anything the previous manifest shipped that this one doesn't is stale
+        UpdateManifest previous;
+        std::ifstream previousFile(manifestPath);
+        if (previousFile.is_open()) {
+            std::string previousText((std::istreambuf_iterator<char>(previousFile)), std::istreambuf_iterator<char>());
+            previousFile.close();
+            
+            std::string currentError = g_ErrorMessage;
+            if (ParseManifest(previousText, previous)) {
+                std::unordered_set<std::string> current;
+                for (const ManifestFile& file : manifest.files) current.insert(file.path);
+                for (const ManifestFile& file : previous.files) {
+                    if (!current.count(file.path)) std::filesystem::remove(root / file.path);
+                }
+            }
+            g_ErrorMessage = currentError;
+        }
+        
+        std::ofstream out(manifestPath, std::ios::trunc);
+        out << manifestText;
+        g_DownloadProgress = 1.0f;
+        return true;
+    } catch (const std::exception& e) {
+        g_ErrorMessage = std::string("Update failed: ") + e.what();
+        return false;
+    }
+}
+
+// create hidden folder
+std::string CreateHiddenFolder() {
+    char appDataPath[MAX_PATH] = {0};
+    if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
+        g_ErrorMessage = "Failed to get AppData path";
+        return "";
+    }
+    
+    std::string folderPath = std::string(appDataPath) + "\\VelocityData";
+    
+    try {
+        std::filesystem::create_directories(folderPath);
+        SetFileAttributesA(folderPath.c_str(), FILE_ATTRIBUTE_HIDDEN);
+    } catch (const std::exception& e) {
+        g_ErrorMessage = std::string("Failed to create hidden folder: ") + e.what();
+        return "";
+    }
+    
+    return folderPath;
+}
+
+// save key
+bool SaveKeyToFile(const std::string& key) {
+    try {
+        std::string keyFilePath = std::filesystem::current_path().string() + "\\key.txt";
+        std::ofstream keyFile(keyFilePath);
+        
+        if (!keyFile.is_open()) {
+            g_ErrorMessage = "Failed to open key file for writing";
+            return false;
+        }
+        
+        keyFile << key;
+        keyFile.close();
+        
+        return true;
+    } catch (const std::exception& e) {
+        g_ErrorMessage = std::string("Failed to save key: ") + e.what();
+        return false;
+    }
+}
+
+// simple http get with better error handling. goes through the shared connection pool,
+// so validation calls after the first skip the DNS lookup and TLS handshake. setting cancel
+// aborts the request in flight and the wait between retries
+std::string HttpGet(const std::wstring& host, const std::wstring& path, std::shared_ptr<std::atomic<bool>> cancel = nullptr) {
+    std::string url = "https://" + std::string(host.begin(), host.end()) + std::string(path.begin(), path.end());
+    std::string result;
+    
+    // attempt a few retries
+    const int MAX_RETRIES = 3;
+    for (int retry = 0; retry < MAX_RETRIES; retry++) {
+        long httpCode = 0;
+        std::string error;
+        if (HttpGetString(url, result, httpCode, error, {}, cancel) && !result.empty()) break;
+        
+        result.clear();
+        for (int waited = 0; retry < MAX_RETRIES - 1 && waited < 1000; waited += 50) {
+            if (cancel && *cancel) return result;
+            Sleep(50);
+        }
+    }
+    
+    return result;
+}
+
+// the validation request itself. reports through error instead of g_ErrorMessage so it can
+// run on a worker thread while the UI reads the global
+static bool CheckKey(const std::string& token, std::shared_ptr<std::atomic<bool>> cancel, std::string& error) {
+    if (token.empty()) return false;
+    
+    try {
+        std::wstring host = L"work.ink";
+        std::wstring path = L"/_api/v2/token/isValid/";
+        path += std::wstring(token.begin(), token.end());
+        
+        std::string response = HttpGet(host, path, cancel);
+        
+        if (response.empty()) {
+            error = "No response from validation server";
+            return false;
+        }
+        
+        auto jsonData = json::parse(response);
+        return jsonData["valid"].get<bool>();
+    } catch (const json::parse_error& e) {
+        error = std::string("JSON parse error: ") + e.what();
+        return false;
+    } catch (const std::exception& e) {
+        error = std::string("Key validation error: ") + e.what();
+        return false;
+    }
+}
+
+// CheckKey behind the validation cache: a key checked recently is answered locally, one checked
+// a while ago is answered from the cache and checked again in the background
+static bool CachedCheckKey(const std::string& token, std::shared_ptr<std::atomic<bool>> cancel, std::string& error) {
+    if (token.empty()) return false;
+    
+    bool valid = false;
+    g_KeyCache.Validate(token, [cancel](const std::string& key, bool& answer, std::string& checkError) {
+        answer = CheckKey(key, cancel, checkError);
+        return checkError.empty(); // an error means no answer, only a definite one is cached
+    }, valid, error);
+    return valid;
+}
+
+// validate key with better error handling
+bool validateKey(const std::string& token) {
+    std::string error;
+    bool valid = CachedCheckKey(token, nullptr, error);
+    if (!error.empty()) g_ErrorMessage = error;
+    return valid;
+}
+
+static std::string LicenseTokenPath() {
+    return std::filesystem::current_path().string() + "\\license.token";
+}
+
+// a signed token for a key the server has just accepted, empty when tokens aren't configured or
+// the server didn't hand out one that verifies. never worth failing anything over
+static std::string FetchLicenseToken(const std::string& key, std::shared_ptr<std::atomic<bool>> cancel) {
+    if (g_LicenseTokenUrl.empty() || g_LicensePublicKey.empty()) return "";
+    
+    std::string body, error;
+    long httpCode = 0;
+    if (!HttpGetString(g_LicenseTokenUrl + key, body, httpCode, error, {}, cancel) || httpCode != 200) return "";
+    
+    std::string token;
+    try {
+        token = json::parse(body)["token"].get<std::string>();
+    } catch (const std::exception&) {
+        return "";
+    }
+    return VerifyLicenseToken(token, key, g_LicensePublicKey, time(nullptr), error) ? token : "";
+}
+
+// runs once Synapse is already starting: confirms the key online and renews its token, or drops
+// both when the server no longer takes the key. an unreachable server changes nothing, the token
+// simply runs out at its expiry
+static void RevalidateLicense(const std::string& key, bool validated) {
+    if (!validated) {
+        std::string error;
+        bool valid = CheckKey(key, nullptr, error);
+        if (!error.empty()) return;
+        
+        g_KeyCache.Store(key, valid);
+        if (!valid) {
+            std::error_code ec;
+            std::filesystem::remove(std::filesystem::current_path().string() + "\\key.txt", ec);
+            std::filesystem::remove(LicenseTokenPath(), ec);
+            return;
+        }
+    }
+    
+    std::string token = FetchLicenseToken(key, nullptr);
+    if (!token.empty()) SaveLicenseToken(LicenseTokenPath(), token);
+}
+
+// install pipeline: one worker thread runs the stages in order, each stage publishes its
+// progress and error through g_Install and the UI only ever reads a locked snapshot of it.
+// downloading and extracting overlap when the archive is streamed (or patched from a manifest),
+// the verify and extract stages are then already done when the download stage ends
+enum class InstallStage { Idle, Validate, ResolveMirror, Download, Verify, Extract, Commit, Done };
+
+struct InstallStatus {
+    InstallStage stage = InstallStage::Idle;
+    float progress = -1.0f; // of the running stage, < 0 while it has nothing to report
+    bool running = false;
+    bool cancelling = false;
+    bool success = false;
+    std::string error;      // from the stage that failed, empty when cancelled
+};
+
+static std::mutex g_InstallLock;
+static InstallStatus g_Install;
+static std::future<bool> g_InstallResult;
+
+// enter a stage. false once the install has been cancelled, the stage is then skipped
+static bool BeginStage(InstallStage stage) {
+    g_DownloadProgress = -1.0f;
+    g_ErrorMessage.clear();
+    
+    std::lock_guard<std::mutex> guard(g_InstallLock);
+    g_Install.stage = stage;
+    return !(g_InstallCancel && *g_InstallCancel);
+}
+
+static bool FailStage(const std::string& fallback) {
+    std::lock_guard<std::mutex> guard(g_InstallLock);
+    if (!(g_InstallCancel && *g_InstallCancel)) {
+        g_Install.error = g_ErrorMessage.empty() ? fallback : g_ErrorMessage;
+    }
+    return false;
+}
+
+// http(s) links only, a placeholder in the mirror list is skipped instead of failing the install
+static bool IsMirrorUrl(const std::string& url) {
+    return url.rfind("https://", 0) == 0 || url.rfind("http://", 0) == 0;
+}
+
+// validate, resolve mirror, download, verify, extract, commit. runs on the install thread
+static bool RunInstall(const std::string& key) {
+    // Primary download URL
+    std::string primaryUrl = "https://cdn.discordapp.com/attachments/1364078781626581063/1364431455760945163/VelocityX.zip?ex=680e4290&is=680cf110&hm=62f3f41ec19d7a38727b955af6e2406530af367fc197e7ef10d87850adcc1496&";
+    
+    // Backup download URL - uses a different CDN or direct link if available
+    std::string backupUrl = "link here pls";
+    
+    // Update manifest (file list + content hashes) - leave empty to always fetch the full archive
+    std::string manifestUrl = "";
+    
+    // Published SHA-256 of the archive - leave empty to only run the size checks
+    std::string payloadSha256 = "";
+    
+    if (!BeginStage(InstallStage::Validate)) return false;
+    std::string error;
+    if (!CachedCheckKey(key, g_InstallCancel, error)) {
+        g_ErrorMessage = error;
+        return FailStage("Invalid key. Try again.");
+    }
+    std::string licenseToken = FetchLicenseToken(key, g_InstallCancel); // saved with the key once installed
+    
+    if (!BeginStage(InstallStage::ResolveMirror)) return false;
+    std::vector<std::string> mirrors;
+    for (const std::string& url : { primaryUrl, backupUrl }) {
+        if (IsMirrorUrl(url)) mirrors.push_back(url);
+    }
+    if (mirrors.empty()) {
+        return FailStage("No download source is configured.");
+    }
+    
+    hiddenFolderPath = CreateHiddenFolder();
+    if (hiddenFolderPath.empty()) {
+        return FailStage("Failed to create the install folder."); // usually set in CreateHiddenFolder
+    }
+    
+    // a full download is extracted into staging and only replaces the live tree in the commit stage
+    StagedInstall staging(hiddenFolderPath, "VelocityX", g_KeepVersions);
+    std::string stagingPath = staging.StagingRoot().string();
+    if (!staging.Prepare(error)) {
+        g_ErrorMessage = error;
+        return FailStage("Failed to prepare the install folder.");
+    }
+    
+    std::map<std::string, MirrorScore> scores = LoadMirrorScores(hiddenFolderPath);
+    mirrors = RaceMirrors(mirrors, scores);
+    
+    // fixed name so an interrupted download is found and resumed next time
+    std::string zipPath = hiddenFolderPath + "\\VelocityX.zip";
+    std::string synapseFolder = hiddenFolderPath + "\\VelocityX\\Synapse";
+    
+    if (!BeginStage(InstallStage::Download)) {
+        SaveMirrorScores(hiddenFolderPath, scores);
+        return false;
+    }
+    
+    // an existing install only needs the files that changed since it was extracted
+    bool installed = !manifestUrl.empty() && std::filesystem::exists(synapseFolder) &&
+        UpdateFromManifest(manifestUrl, hiddenFolderPath);
+    bool staged = false;
+    
+    // extract straight off the wire unless an interrupted zip download is waiting to be resumed
+    if (!installed && !*g_InstallCancel && g_StreamingExtract && !std::filesystem::exists(DownloadJournalPath(zipPath))) {
+        curl_off_t received = 0;
+        auto start = std::chrono::steady_clock::now();
+        g_ExpectedBytesPerSec = scores[MirrorKey(mirrors.front())].bytesPerSec;
+        installed = staged = DownloadAndExtract(mirrors.front(), stagingPath, payloadSha256, &received);
+        if (installed) {
+            RecordMirrorThroughput(scores, mirrors.front(), received,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    SaveMirrorScores(hiddenFolderPath, scores);
+    
+    if (!installed) {
+        bool downloaded = false;
+        std::string digest;
+        for (size_t i = 0; i < mirrors.size() && !downloaded && !*g_InstallCancel; i++) {
+            // a resumed download only moves part of the file, its speed would be inflated
+            bool resuming = std::filesystem::exists(DownloadJournalPath(zipPath));
+            auto start = std::chrono::steady_clock::now();
+            g_ExpectedBytesPerSec = scores[MirrorKey(mirrors[i])].bytesPerSec;
+            downloaded = FetchFile(mirrors[i], zipPath, payloadSha256.empty() ? nullptr : &digest);
+            if (!downloaded) {
+                if (!*g_InstallCancel) scores[MirrorKey(mirrors[i])].failures++;
+            } else if (!resuming) {
+                std::error_code ec;
+                curl_off_t size = static_cast<curl_off_t>(std::filesystem::file_size(zipPath, ec));
+                RecordMirrorThroughput(scores, mirrors[i], ec ? 0 : size,
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+        SaveMirrorScores(hiddenFolderPath, scores);
+        if (!downloaded) {
+            return FailStage("Download failed. Please try again.");
+        }
+        
+        if (!BeginStage(InstallStage::Verify)) return false;
+        if (!VerifyDownloadedFile(zipPath, payloadSha256, digest)) {
+            return FailStage("Downloaded file failed verification.");
+        }
+        
+        if (!BeginStage(InstallStage::Extract)) return false;
+        if (!ExtractZipFile(zipPath, stagingPath)) {
+            return FailStage("Extraction failed. Please try again.");
+        }
+        staged = true;
+        
+        try {
+            std::filesystem::remove(zipPath);
+        } catch (...) {
+            // Ignore cleanup errors
+        }
+    }
+    
+    if (!BeginStage(InstallStage::Commit)) return false;
+    if (staged && !staging.Commit(g_ExtractThreads, error)) {
+        g_ErrorMessage = error;
+        return FailStage("Failed to install the new version.");
+    }
+    if (!SaveKeyToFile(key)) {
+        return FailStage("Failed to save key.");
+    }
+    if (!licenseToken.empty()) SaveLicenseToken(LicenseTokenPath(), licenseToken);
+    return true;
+}
+
+// start an install on its own thread, the frame loop follows it with GetInstallStatus
+void StartInstall(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> guard(g_InstallLock);
+        g_Install = InstallStatus();
+        g_Install.running = true;
+    }
+    g_InstallCancel = std::make_shared<std::atomic<bool>>(false);
+    
+    std::promise<bool> promise;
+    g_InstallResult = promise.get_future();
+    std::thread([key, promise = std::move(promise)]() mutable {
+        bool success = RunInstall(key);
+        {
+            std::lock_guard<std::mutex> guard(g_InstallLock);
+            g_Install.stage = InstallStage::Done;
+            g_Install.success = success;
+            g_Install.running = false;
+        }
+        promise.set_value(success);
+    }).detach();
+}
+
+InstallStatus GetInstallStatus() {
+    std::lock_guard<std::mutex> guard(g_InstallLock);
+    InstallStatus status = g_Install;
+    if (status.running) status.progress = g_DownloadProgress;
+    return status;
+}
+
+// true once, on the first frame after the install thread finished
+bool PollInstall(InstallStatus& result) {
+    if (!g_InstallResult.valid() || g_InstallResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    g_InstallResult.get();
+    result = GetInstallStatus();
+    return true;
+}
+
+// network transfers abort within about a second and the remaining stages are skipped. a stage
+// that's already writing files (extract, commit) finishes first so the install isn't left half done
+void CancelInstall() {
+    if (g_InstallCancel) *g_InstallCancel = true;
+    std::lock_guard<std::mutex> guard(g_InstallLock);
+    if (g_Install.running) g_Install.cancelling = true;
+}
+
+bool CheckForKeyAndLaunchSynapse() {
+    try {
+        std::string keyFilePath = std::filesystem::current_path().string() + "\\key.txt";
+        
+        if (!std::filesystem::exists(keyFilePath)) {
+            return false;
+        }
+        
+        std::ifstream keyFile(keyFilePath);
+        if (!keyFile.is_open()) {
+            return false;
+        }
+        
+        std::string key;
+        std::getline(keyFile, key);
+        keyFile.close();
+        
+        // a token from an earlier validation skips the round trip, the online check then runs
+        // after the launch instead of in front of it
+        std::string tokenError;
+        bool offline = !key.empty() && VerifyLicenseToken(LoadLicenseToken(LicenseTokenPath()), key, g_LicensePublicKey, time(nullptr), tokenError);
+        if (!offline && (key.empty() || !validateKey(key))) {
+            try {
+                std::filesystem::remove(keyFilePath);
+                std::filesystem::remove(LicenseTokenPath());
+            } catch (...) {}
+            return false;
+        }
+        
+        char appDataPath[MAX_PATH] = {0};
+        if (FAILED(SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
+            return false;
+        }
+        
+        std::string synapsePath = std::string(appDataPath) + "\\VelocityData\\VelocityX\\Synapse\\Synapse Launcher.exe";
+        if (!std::filesystem::exists(synapsePath)) {
+            return false;
+        }
+        
+        std::string workingDirectory = std::string(appDataPath) + "\\VelocityData\\VelocityX\\Synapse";
+        
+        SHELLEXECUTEINFOA sei = { 0 };
+        sei.cbSize = sizeof(sei);
+        sei.fMask = SEE_MASK_NOASYNC;
+        sei.hwnd = NULL;
+        sei.lpVerb = "open";
+        sei.lpFile = synapsePath.c_str();
+        sei.lpParameters = NULL;
+        sei.lpDirectory = workingDirectory.c_str();
+        sei.nShow = SW_SHOWNORMAL;
+        
+        if (ShellExecuteExA(&sei)) {
+            RevalidateLicense(key, !offline);
+            g_KeyCache.WaitForRevalidation();
+            OutputDebugStringA(g_KeyCache.Report().c_str());
+            exit(0);
+            return true;
+        }
+        
+        return false;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+void GetDesktopResolution() {
+    g_ScreenWidth = GetSystemMetrics(SM_CXSCREEN);
+    g_ScreenHeight = GetSystemMetrics(SM_CYSCREEN);
+}
+
+void KeepWindowInBounds(ImVec2& window_pos, const ImVec2& window_size) {
+    if (window_pos.x < 0) window_pos.x = 0;
+    if (window_pos.y < 0) window_pos.y = 0;
+    if (window_pos.x + window_size.x > g_ScreenWidth) window_pos.x = g_ScreenWidth - window_size.x;
+    if (window_pos.y + window_size.y > g_ScreenHeight) window_pos.y = g_ScreenHeight - window_size.y;
+}
+
+bool CreateDeviceD3D(HWND hWnd) {
+    DXGI_SWAP_CHAIN_DESC sd;
+    ZeroMemory(&sd, sizeof(sd));
+    sd.BufferCount = 2;
+    sd.BufferDesc.Width = 0;
+    sd.BufferDesc.Height = 0;
+    sd.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    sd.BufferDesc.RefreshRate.Numerator = 60;
+    sd.BufferDesc.RefreshRate.Denominator = 1;
+    sd.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+    sd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    sd.OutputWindow = hWnd;
+    sd.SampleDesc.Count = 1;
+    sd.SampleDesc.Quality = 0;
+    sd.Windowed = TRUE;
+    sd.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+
+    UINT createDeviceFlags = 0;
+    D3D_FEATURE_LEVEL featureLevel;
+    const D3D_FEATURE_LEVEL featureLevelArray[2] = { D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_10_0 };
+    HRESULT res = D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, createDeviceFlags, featureLevelArray, 2, D3D11_SDK_VERSION, &sd, &g_pSwapChain, &g_pd3dDevice, &featureLevel, &g_pd3dDeviceContext);
+    
+    if (res == DXGI_ERROR_UNSUPPORTED)
+        res = D3D11CreateDeviceAndSwapChain(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, createDeviceFlags, featureLevelArray, 2, D3D11_SDK_VERSION, &sd, &g_pSwapChain, &g_pd3dDevice, &featureLevel, &g_pd3dDeviceContext);
+    
+    if (res != S_OK)
+        return false;
+
+    CreateRenderTarget();
+    return true;
+}
+
+void CleanupDeviceD3D() {
+    CleanupRenderTarget();
+    if (g_pSwapChain) { g_pSwapChain->Release(); g_pSwapChain = nullptr; }
+    if (g_pd3dDeviceContext) { g_pd3dDeviceContext->Release(); g_pd3dDeviceContext = nullptr; }
+    if (g_pd3dDevice) { g_pd3dDevice->Release(); g_pd3dDevice = nullptr; }
+}
+
+void CreateRenderTarget() {
+    ID3D11Texture2D* pBackBuffer;
+    g_pSwapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer));
+    if (pBackBuffer) {
+        g_pd3dDevice->CreateRenderTargetView(pBackBuffer, nullptr, &g_mainRenderTargetView);
+        pBackBuffer->Release();
+    }
+}
+
+void CleanupRenderTarget() {
+    if (g_mainRenderTargetView) { g_mainRenderTargetView->Release(); g_mainRenderTargetView = nullptr; }
+}
+
+LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
+        return 1;
+
+    switch (msg) {
+    case WM_SIZE:
+        if (wParam == SIZE_MINIMIZED)
+            return 0;
+        g_ResizeWidth = (UINT)LOWORD(lParam);
+        g_ResizeHeight = (UINT)HIWORD(lParam);
+        return 0;
+    case WM_SYSCOMMAND:
+        if ((wParam & 0xfff0) == SC_KEYMENU)
+            return 0;
+        break;
+    case WM_DESTROY:
+        ::PostQuitMessage(0);
+        return 0;
+    }
+    return ::DefWindowProcW(hWnd, msg, wParam, lParam);
+}
+
+// log what the connection pool saved (handshakes, per-request latency) and release it with curl
+static void ShutdownNetwork() {
+    g_KeyCache.WaitForRevalidation();
+    OutputDebugStringA(g_KeyCache.Report().c_str());
+    OutputDebugStringA(HttpPoolReport().c_str());
+    HttpPoolShutdown();
+    curl_global_cleanup();
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    // init curl 
+    curl_global_init(CURL_GLOBAL_ALL);
+    
+    GetDesktopResolution();
+    
+    char appDataPath[MAX_PATH] = {0};
+    SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath);
+    hiddenFolderPath = std::string(appDataPath) + "\\VelocityData";
+    g_KeyCache.Open(hiddenFolderPath + "\\validation.cache");
+
+    // finish or undo a commit that a crash interrupted, and go back a version when asked to
+    StagedInstall installed(hiddenFolderPath, "VelocityX", g_KeepVersions);
+    std::string installError;
+    bool recovered = installed.Recover(installError);
+    if (recovered && lpCmdLine && strstr(lpCmdLine, "--rollback")) recovered = installed.Rollback(installError);
+    if (!recovered) OutputDebugStringA((installError + "\n").c_str());
+
+    if (CheckForKeyAndLaunchSynapse()) {
+        ShutdownNetwork();
+        return 0;
+    }
+
+    WNDCLASSEXW wc = { sizeof(wc), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(nullptr), nullptr, nullptr, nullptr, nullptr, L"Velocity Custom Launcher", nullptr };
+    ::RegisterClassExW(&wc);
+    HWND hwnd = ::CreateWindowExW(WS_EX_LAYERED | WS_EX_TOPMOST, L"Velocity Custom Launcher", NULL, WS_POPUP, 100, 100, 1920, 1080, NULL, NULL, wc.hInstance, NULL);
+
+    static bool first_frame = true;
+    if (first_frame) {
+        first_frame = false;
+        SetLayeredWindowAttributes(hwnd, RGB(0, 0, 0), 0, ULW_COLORKEY);
+    }
+
+    if (!CreateDeviceD3D(hwnd)) {
+        CleanupDeviceD3D();
+        ::UnregisterClassW(wc.lpszClassName, wc.hInstance);
+        ShutdownNetwork();
+        return 1;
+    }
+
+    ::ShowWindow(hwnd, SW_SHOWDEFAULT);
+    ::UpdateWindow(hwnd);
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+
+    ImGuiStyle& style = ImGui::GetStyle();
+    style.WindowRounding = 8.0f;
+    style.FrameRounding = 6.0f;
+    style.GrabRounding = 6.0f;
+
+    ImVec4* colors = style.Colors;
+    colors[ImGuiCol_WindowBg] = ImVec4(0.10f, 0.12f, 0.15f, 1.0f);
+    colors[ImGuiCol_Button] = ImVec4(0.20f, 0.22f, 0.27f, 1.0f);
+    colors[ImGuiCol_ButtonHovered] = ImVec4(0.30f, 0.32f, 0.38f, 1.0f);
+    colors[ImGuiCol_ButtonActive] = ImVec4(0.25f, 0.28f, 0.35f, 1.0f);
+    colors[ImGuiCol_FrameBg] = ImVec4(0.16f, 0.18f, 0.22f, 1.0f);
+    colors[ImGuiCol_FrameBgHovered] = ImVec4(0.20f, 0.22f, 0.27f, 1.0f);
+    colors[ImGuiCol_FrameBgActive] = ImVec4(0.18f, 0.20f, 0.25f, 1.0f);
+
+    ImGui::StyleColorsDark();
+    ImGui_ImplWin32_Init(hwnd);
+    ImGui_ImplDX11_Init(g_pd3dDevice, g_pd3dDeviceContext);
+
+    ImVec4 clear_color = colors[ImGuiCol_WindowBg]; // match background
+    static char key_input[64] = "";
+    bool done = false;
+
+    ImVec2 window_size = ImVec2(440, 180);
+    ImVec2 window_pos = ImVec2((g_ScreenWidth - window_size.x) / 2, (g_ScreenHeight - window_size.y) / 2);
+    
+    static bool show_error_popup = false;
+    static bool show_success_popup = false;
+    static std::string error_message;
+    static bool is_dragging = false;
+
+    while (!done) {
+        MSG msg;
+        while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE)) {
+            ::TranslateMessage(&msg);
+            ::DispatchMessage(&msg);
+            if (msg.message == WM_QUIT)
+                done = true;
+        }
+        if (done) break;
+
+        if (g_ResizeWidth != 0 && g_ResizeHeight != 0) {
+            CleanupRenderTarget();
+            g_pSwapChain->ResizeBuffers(0, g_ResizeWidth, g_ResizeHeight, DXGI_FORMAT_UNKNOWN, 0);
+            g_ResizeWidth = g_ResizeHeight = 0;
+            CreateRenderTarget();
+        }
+        
+        InstallStatus finished;
+        if (PollInstall(finished)) {
+            if (finished.success) {
+                show_success_popup = true;
+                // Add a small delay before exiting
+                std::thread([hwnd]() {
+                    Sleep(2000);
+                    ::PostMessage(hwnd, WM_QUIT, 0, 0);
+                }).detach();
+            } else if (!finished.error.empty()) {
+                show_error_popup = true;
+                error_message = finished.error;
+            }
+        }
+        
+        InstallStatus install = GetInstallStatus();
+
+        ImGui_ImplDX11_NewFrame();
+        ImGui_ImplWin32_NewFrame();
+        ImGui::NewFrame();
+
+        KeepWindowInBounds(window_pos, window_size);
+
+        ImGui::SetNextWindowPos(window_pos, ImGuiCond_Always);
+        ImGui::SetNextWindowSize(window_size);
+        ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration;
+
+        ImGui::Begin("Key System", nullptr, window_flags);
+        {
+            ImGui::InvisibleButton("drag_zone", ImVec2(window_size.x, 20));
+            if (ImGui::IsItemHovered() || is_dragging) {
+                ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeAll);
+                
+                if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+                    if (!is_dragging) {
+                        is_dragging = true;
+                        ImGui::ResetMouseDragDelta();
+                    } else {
+                        ImVec2 delta = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left);
+                        window_pos.x += delta.x;
+                        window_pos.y += delta.y;
+                        ImGui::ResetMouseDragDelta();
+                    }
+                } else {
+                    is_dragging = false;
+                }
+            }
+
+            ImGui::Spacing(); ImGui::Spacing();
+
+            float total_width = 350 + style.ItemSpacing.x + 85;
+            ImGui::SetNextItemWidth(270);
+
+            float indent_x = (ImGui::GetWindowSize().x - total_width) * 0.5f;
+            ImGui::Indent(indent_x);
+
+            ImGui::Text("Enter Key:");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(250);
+            ImGui::InputText("##keyinput", key_input, IM_ARRAYSIZE(key_input));
+            ImGui::SameLine();
+
+            bool button_disabled = install.cancelling;
+            
+            if (button_disabled)
+                ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+                
+            // while an install runs the button cancels it
+            if (install.running) {
+                if (ImGui::Button("Cancel", ImVec2(85, 0)) && !button_disabled) {
+                    CancelInstall();
+                }
+            } else if (ImGui::Button("Confirm", ImVec2(85, 0))) {
+                if (strlen(key_input) == 0) {
+                    show_error_popup = true;
+                    error_message = "Please enter a key";
+                } else {
+                    show_error_popup = false;
+                    StartInstall(key_input);
+                }
+            }
+            
+            if (button_disabled)
+                ImGui::PopStyleVar();
+                
+            ImGui::Unindent(indent_x);
+
+            // error popup
+            if (show_error_popup) {
+                ImVec2 main_window_pos = ImGui::GetWindowPos();
+                ImVec2 main_window_size = ImGui::GetWindowSize();
+                float popup_width = 300.0f;
+                ImVec2 popup_pos = ImVec2(
+                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
+                    main_window_pos.y + main_window_size.y + 10.0f
+                );
+                
+                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 80));
+
+                ImGui::SetNextWindowPos(popup_pos);
+                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
+
+                if (ImGui::Begin("##ErrorPopup", nullptr,
+                    ImGuiWindowFlags_NoTitleBar |
+                    ImGuiWindowFlags_NoResize |
+                    ImGuiWindowFlags_NoMove |
+                    ImGuiWindowFlags_NoSavedSettings |
+                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
+                    ImGui::TextWrapped("%s", error_message.c_str());
+                    ImGui::SetCursorPosX((ImGui::GetWindowWidth() - 100) * 0.5f);
+                    if (ImGui::Button("OK", ImVec2(100, 30))) {
+                        show_error_popup = false;
+                    }
+                    ImGui::End();
+                }
+            }
+            
+            // success popup
+            if (show_success_popup) {
+                ImVec2 main_window_pos = ImGui::GetWindowPos();
+                ImVec2 main_window_size = ImGui::GetWindowSize();
+                float popup_width = 300.0f;
+                ImVec2 popup_pos = ImVec2(
+                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
+                    main_window_pos.y + main_window_size.y + 10.0f
+                );
+                
+                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 80));
+
+                ImGui::SetNextWindowPos(popup_pos);
+                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
+
+                if (ImGui::Begin("##SuccessPopup", nullptr,
+                    ImGuiWindowFlags_NoTitleBar |
+                    ImGuiWindowFlags_NoResize |
+                    ImGuiWindowFlags_NoMove |
+                    ImGuiWindowFlags_NoSavedSettings |
+                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
+                    ImGui::TextWrapped("Successfully downloaded. Please re-open the launcher!\n(ily mommy lina <3)");
+                    ImGui::SetCursorPosX((ImGui::GetWindowWidth() - 100) * 0.5f);
+                    if (ImGui::Button("OK", ImVec2(100, 30))) {
+                        show_success_popup = false;
+                        ::PostMessage(hwnd, WM_QUIT, 0, 0);
+                    }
+                    ImGui::End();
+                }
+            }
+
+            // validation state
+            if (install.running && install.stage == InstallStage::Validate) {
+                ImVec2 main_window_pos = ImGui::GetWindowPos();
+                ImVec2 main_window_size = ImGui::GetWindowSize();
+                float popup_width = 300.0f;
+                ImVec2 popup_pos = ImVec2(
+                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
+                    main_window_pos.y + main_window_size.y + 10.0f
+                );
+                
+                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 50));
+
+                ImGui::SetNextWindowPos(popup_pos);
+                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
+
+                if (ImGui::Begin("##ValidatingPopup", nullptr,
+                    ImGuiWindowFlags_NoTitleBar |
+                    ImGuiWindowFlags_NoResize |
+                    ImGuiWindowFlags_NoMove |
+                    ImGuiWindowFlags_NoSavedSettings |
+                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
+                    static const char* dots[] = { "", ".", "..", "..." };
+                    ImGui::Text("%s%s", install.cancelling ? "Cancelling" : "Validating key",
+                        dots[static_cast<int>(ImGui::GetTime() * 3.0) % 4]);
+                    ImGui::End();
+                }
+            }
+
+            // install progress display, one line per stage
+            if (install.running && install.stage != InstallStage::Validate) {
+                ImVec2 main_window_pos = ImGui::GetWindowPos();
+                ImVec2 main_window_size = ImGui::GetWindowSize();
+                float popup_width = 300.0f;
+                ImVec2 popup_pos = ImVec2(
+                    main_window_pos.x + (main_window_size.x - popup_width) * 0.5f,
+                    main_window_pos.y + main_window_size.y + 10.0f
+                );
+                
+                KeepWindowInBounds(popup_pos, ImVec2(popup_width, 70));
+
+                ImGui::SetNextWindowPos(popup_pos);
+                ImGui::SetNextWindowSize(ImVec2(popup_width, 0), ImGuiCond_Always);
+
+                if (ImGui::Begin("##DownloadingPopup", nullptr,
+                    ImGuiWindowFlags_NoTitleBar |
+                    ImGuiWindowFlags_NoResize |
+                    ImGuiWindowFlags_NoMove |
+                    ImGuiWindowFlags_NoSavedSettings |
+                    ImGuiWindowFlags_NoBringToFrontOnFocus)) {
+                    const char* text = "Preparing VelocityX. Please wait...";
+                    switch (install.stage) {
+                    case InstallStage::ResolveMirror: text = "Finding a download source..."; break;
+                    case InstallStage::Download: text = "Downloading VelocityX. Please wait..."; break;
+                    case InstallStage::Verify: text = "Verifying the download..."; break;
+                    case InstallStage::Extract: text = "Extracting VelocityX. Please wait..."; break;
+                    case InstallStage::Commit: text = "Finishing up..."; break;
+                    default: break;
+                    }
+                    ImGui::TextWrapped("%s", install.cancelling ? "Cancelling..." : text);
+                    
+                    if (install.progress >= 0.0f) {
+                        char buffer[32];
+                        sprintf_s(buffer, "%.0f%%", install.progress * 100.0f);
+                        ImGui::ProgressBar(install.progress, ImVec2(-1, 0), buffer);
+                    }
+                    
+                    ImGui::End();
+                }
+            }
+
+            ImGui::Dummy(ImVec2(0.0f, 10.0f));
+            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - 100) * 0.5f);
+            if (ImGui::Button("Get Key", ImVec2(100, 0)) && !install.running) {
+                OpenBrowser(L"https://workink.net/1Y5j/9qk7e7ho");
+            }
+
+            ImGui::Dummy(ImVec2(0.0f, 12.0f));
+            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - ImGui::CalcTextSize("A lifetime key can be purchased to skip this.").x) * 0.5f);
+            ImGui::Text("A lifetime key can be purchased to skip this.");
+
+            ImGui::Dummy(ImVec2(0.0f, 10.0f));
+            ImGui::SetCursorPosX((ImGui::GetWindowSize().x - 150) * 0.5f);
+            if (ImGui::Button("Contact Reseller", ImVec2(150, 0)) && !install.running) {
+                // XGs32yXdaQ
+                OpenBrowser(L"https://discord.gg/XGs32yXdaQ");
+            }
+        }
+        ImGui::End();
+
+        ImGui::Render();
+        const float clear_color_with_alpha[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView, nullptr);
+        g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView, clear_color_with_alpha);
+        ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+
+        g_pSwapChain->Present(1, 0);
+    }
+
+    ImGui_ImplDX11_Shutdown();
+    ImGui_ImplWin32_Shutdown();
+    ImGui::DestroyContext();
+
+    CleanupDeviceD3D();
+    ::DestroyWindow(hwnd);
+    ::UnregisterClassW(wc.lpszClassName, wc.hInstance);
+    
+    ShutdownNetwork();
+
+    return 0;
+}
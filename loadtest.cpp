@@ -0,0 +1,268 @@
+// load test for key validation and activation: N simulated launchers run CheckKeyActivation, the
+// code the launcher ships, against local stand-ins for work.ink, ipify and the key registry, then
+// latency percentiles, throughput and every way an activation ended are printed.
+//   loadtest [--launchers N] [--activations M] [--keys K] [--invalid <rate>] [--clients C]
+//            [--retries R] [--retry-delay <ms>] [--store <file>] [--fault <spec>]...
+// a fault spec is <validate|ip|registry>:<slow|5xx|conflict>=<rate>[:<ms>], e.g.
+//   --fault validate:slow=0.05:800 --fault registry:5xx=0.01 --fault registry:conflict=0.02
+// slow holds the answer back (500 ms unless given), 5xx answers 503, conflict answers 409 as if
+// another machine had the key. with fewer keys than activations, launchers share keys and the
+// registry sees real conflicts. a launcher retries an activation that got no answer like the
+// launcher's HttpGet does: --retries more times, --retry-delay apart. all launchers share one
+// HttpClient like the launcher's default one, --clients spreads them over C clients to measure
+// what separate multi handles (each with its own connections) change
+#include "activation.h"
+#include "registry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct FaultPlan {
+    double slowRate = 0.0;
+    int slowMs = 500;
+    double errorRate = 0.0;
+    double conflictRate = 0.0;
+};
+
+// a stand-in endpoint: handler plus injected faults, and what it did
+struct StandIn {
+    explicit StandIn(const char* name) : name(name) {}
+
+    const char* name;
+    FaultPlan faults;
+    HttpServer server;
+    std::atomic<uint64_t> requests = 0;
+    std::atomic<uint64_t> slowed = 0;
+    std::atomic<uint64_t> errors = 0;
+    std::atomic<uint64_t> conflicts = 0;
+
+    bool Start(HttpServer::Handler handler, std::string& error) {
+        // the handler runs on the server's one thread, so one generator is enough
+        auto random = std::make_shared<std::mt19937>(std::random_device()());
+        return server.Start("127.0.0.1", 0, [this, handler, random](const HttpServerRequest& request) {
+            ++requests;
+            std::uniform_real_distribution<double> roll(0.0, 1.0);
+            HttpServerResponse response;
+            if (roll(*random) < faults.errorRate) {
+                ++errors;
+                response = { 503, "Injected failure\n" };
+            } else if (roll(*random) < faults.conflictRate) {
+                ++conflicts;
+                response = { 409, "203.0.113.7" };
+            } else {
+                response = handler(request);
+            }
+            if (roll(*random) < faults.slowRate) {
+                ++slowed;
+                response.delayMs = faults.slowMs;
+            }
+            return response;
+        }, error);
+    }
+
+    std::string Url() const { return "http://127.0.0.1:" + std::to_string(server.Port()); }
+};
+
+// what one launcher thread saw, merged at the end
+struct LauncherTally {
+    std::vector<double> latencyMs; // per activation, retries included
+    std::map<std::string, uint64_t> outcomes;
+    uint64_t attempts = 0;
+};
+
+static bool ParseFault(const char* spec, StandIn* standIns[3]) {
+    std::string text = spec;
+    size_t colon = text.find(':');
+    size_t equals = text.find('=');
+    if (colon == std::string::npos || equals == std::string::npos || equals < colon) return false;
+    std::string endpoint = text.substr(0, colon);
+    std::string kind = text.substr(colon + 1, equals - colon - 1);
+    std::string value = text.substr(equals + 1);
+
+    StandIn* standIn = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        if (endpoint == standIns[i]->name) standIn = standIns[i];
+    }
+    if (!standIn) return false;
+
+    size_t msColon = value.find(':');
+    double rate = atof(value.substr(0, msColon).c_str());
+    if (kind == "slow") {
+        standIn->faults.slowRate = rate;
+        if (msColon != std::string::npos) standIn->faults.slowMs = atoi(value.c_str() + msColon + 1);
+    } else if (kind == "5xx") {
+        standIn->faults.errorRate = rate;
+    } else if (kind == "conflict" && standIn == standIns[2]) {
+        standIn->faults.conflictRate = rate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static double Percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    return sorted[(std::min)(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+// the outcome an activation ended with, short enough to group by
+static std::string Outcome(bool answered, bool valid, const std::string& error) {
+    if (answered && valid) return "activated";
+    if (answered && error.compare(0, 5, "HWID/") == 0) return "conflict (key bound elsewhere)";
+    if (answered) return "rejected: " + error;
+    return "no answer: " + error;
+}
+
+int main(int argc, char** argv) {
+    int launchers = 200;
+    int activations = 5000;
+    int keys = 0; // 0: one key per activation
+    double invalidRate = 0.0;
+    int clientCount = 1;
+    int retries = 3;
+    int retryDelayMs = 1000;
+    std::string store;
+
+    StandIn validate("validate");
+    StandIn ip("ip");
+    StandIn registryStandIn("registry");
+    StandIn* standIns[3] = { &validate, &ip, &registryStandIn };
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--launchers") && hasValue) {
+            launchers = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--activations") && hasValue) {
+            activations = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--keys") && hasValue) {
+            keys = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--invalid") && hasValue) {
+            invalidRate = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--clients") && hasValue) {
+            clientCount = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--retries") && hasValue) {
+            retries = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--retry-delay") && hasValue) {
+            retryDelayMs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--store") && hasValue) {
+            store = argv[++i];
+        } else if (!strcmp(argv[i], "--fault") && hasValue && ParseFault(argv[i + 1], standIns)) {
+            ++i;
+        } else {
+            fprintf(stderr, "usage: %s [--launchers N] [--activations M] [--keys K] [--invalid <rate>] [--clients C]\n"
+                "    [--retries R] [--retry-delay <ms>] [--store <file>] [--fault <validate|ip|registry>:<slow|5xx|conflict>=<rate>[:<ms>]]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (launchers < 1 || activations < 1 || clientCount < 1) {
+        fprintf(stderr, "launchers, activations and clients must be positive\n");
+        return 2;
+    }
+    if (keys <= 0) keys = activations;
+
+    KeyRegistry registry;
+    std::string error;
+    bool started = registry.Open(store, error) &&
+        validate.Start([](const HttpServerRequest& request) -> HttpServerResponse {
+            // keys starting with "bad-" are the ones work.ink doesn't know
+            bool valid = request.path.find("/bad-") == std::string::npos;
+            return { 200, valid ? "{\"valid\":true}" : "{\"valid\":false}", "application/json" };
+        }, error) &&
+        ip.Start([](const HttpServerRequest& request) -> HttpServerResponse {
+            // each simulated launcher asks as its own machine: /?as=<ip>
+            size_t as = request.path.find("as=");
+            std::string address = as == std::string::npos ? "127.0.0.1" : request.path.substr(as + 3);
+            return { 200, "{\"ip\":\"" + address + "\"}", "application/json" };
+        }, error) &&
+        registryStandIn.Start(KeyRegistryHandler(registry), error);
+    if (!started) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<HttpClient>> clients;
+    for (int i = 0; i < clientCount; ++i) clients.push_back(std::make_unique<HttpClient>());
+
+    std::atomic<int> next = 0;
+    std::vector<LauncherTally> tallies(launchers);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (int l = 0; l < launchers; ++l) {
+        threads.emplace_back([&, l]() {
+            LauncherTally& tally = tallies[l];
+            HttpClient& client = *clients[l % clientCount];
+            ActivationEndpoints endpoints;
+            endpoints.validateUrl = validate.Url() + "/_api/v2/token/isValid/";
+            endpoints.ipUrl = ip.Url() + "/?format=json&as=10." + std::to_string(l >> 16 & 255) + "." +
+                std::to_string(l >> 8 & 255) + "." + std::to_string(l & 255);
+            endpoints.registryUrl = registryStandIn.Url();
+            std::mt19937 random(static_cast<unsigned>(l));
+            std::uniform_real_distribution<double> roll(0.0, 1.0);
+
+            for (int index; (index = next++) < activations;) {
+                std::string key = (roll(random) < invalidRate ? "bad-" : "key-") + std::to_string(index % keys);
+                Clock::time_point began = Clock::now();
+                bool answered = false;
+                bool valid = false;
+                std::string keyError;
+                for (int attempt = 0; attempt <= retries; ++attempt) {
+                    if (attempt > 0) std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMs));
+                    ++tally.attempts;
+                    keyError.clear();
+                    HttpRequestGroup group(client);
+                    answered = CheckKeyActivation(group, endpoints, key, valid, keyError);
+                    if (answered) break;
+                }
+                tally.latencyMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - began).count());
+                ++tally.outcomes[Outcome(answered, valid, keyError)];
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LauncherTally total;
+    for (LauncherTally& tally : tallies) {
+        total.latencyMs.insert(total.latencyMs.end(), tally.latencyMs.begin(), tally.latencyMs.end());
+        for (const auto& outcome : tally.outcomes) total.outcomes[outcome.first] += outcome.second;
+        total.attempts += tally.attempts;
+    }
+    std::sort(total.latencyMs.begin(), total.latencyMs.end());
+    std::vector<std::pair<std::string, uint64_t>> outcomes(total.outcomes.begin(), total.outcomes.end());
+    std::sort(outcomes.begin(), outcomes.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    printf("%d activations by %d launchers on %d clients over %d keys in %.2f s: %.0f/s\n", activations, launchers, clientCount, keys,
+        seconds, activations / seconds);
+    printf("latency ms: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", Percentile(total.latencyMs, 0.50),
+        Percentile(total.latencyMs, 0.90), Percentile(total.latencyMs, 0.99), total.latencyMs.back());
+    printf("attempts: %llu (%.2f per activation)\n", static_cast<unsigned long long>(total.attempts), static_cast<double>(total.attempts) / activations);
+    printf("outcomes:\n");
+    for (const auto& outcome : outcomes) {
+        printf("  %7llu  %5.1f%%  %s\n", static_cast<unsigned long long>(outcome.second), 100.0 * outcome.second / activations, outcome.first.c_str());
+    }
+    printf("stand-ins:\n");
+    for (StandIn* standIn : standIns) {
+        printf("  %-8s %7llu requests, %llu slowed, %llu 5xx, %llu conflicts\n", standIn->name,
+            static_cast<unsigned long long>(standIn->requests.load()), static_cast<unsigned long long>(standIn->slowed.load()),
+            static_cast<unsigned long long>(standIn->errors.load()), static_cast<unsigned long long>(standIn->conflicts.load()));
+    }
+    printf("registry: %zu keys bound\n", registry.Size());
+
+    // the servers' handlers reference the registry and stand-ins, stop them before those go
+    for (StandIn* standIn : standIns) standIn->server.Stop();
+    clients.clear();
+    HttpPoolShutdown();
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "loopback.h"
+#include <algorithm>
+#include <cstdlib>
+
+// "bytes=first-last", "bytes=first-" or "bytes=-suffix" against a file of size bytes. false when
+// the header isn't one range of that form, unsatisfiable set when it is but lies past the end
+static bool ParseRange(const std::string& header, uint64_t size, uint64_t& first, uint64_t& last, bool& unsatisfiable) {
+    unsatisfiable = false;
+    if (header.compare(0, 6, "bytes=") != 0) return false;
+    std::string spec = header.substr(6);
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos || spec.find(',') != std::string::npos) return false;
+    std::string from = spec.substr(0, dash);
+    std::string to = spec.substr(dash + 1);
+    if (from.find_first_not_of("0123456789") != std::string::npos || to.find_first_not_of("0123456789") != std::string::npos) return false;
+    if (from.empty() && to.empty()) return false;
+
+    if (from.empty()) {
+        uint64_t suffix = std::strtoull(to.c_str(), nullptr, 10);
+        if (suffix == 0 || size == 0) {
+            unsatisfiable = true;
+            return true;
+        }
+        first = suffix < size ? size - suffix : 0;
+        last = size - 1;
+        return true;
+    }
+    first = std::strtoull(from.c_str(), nullptr, 10);
+    uint64_t end = to.empty() ? UINT64_MAX : static_cast<uint64_t>(std::strtoull(to.c_str(), nullptr, 10));
+    if (end < first) return false; // malformed, the whole file is the answer
+    if (first >= size) {
+        unsatisfiable = true;
+        return true;
+    }
+    last = (std::min)(end, size - 1);
+    return true;
+}
+
+bool LoopbackServer::Start(std::string& error) {
+    return server.Start("127.0.0.1", 0, [this](const HttpServerRequest& request) { return Answer(request); }, error);
+}
+
+void LoopbackServer::Serve(const std::string& path, std::string body, const std::string& contentType) {
+    std::lock_guard<std::mutex> guard(lock);
+    files[path] = { std::make_shared<const std::string>(std::move(body)), contentType, "\"v" + std::to_string(++version) + "\"" };
+}
+
+std::string LoopbackServer::Stored(const std::string& path) const {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = files.find(path);
+    return found == files.end() ? "" : *found->second.body;
+}
+
+HttpServerResponse LoopbackServer::Answer(const HttpServerRequest& request) {
+    ++requests;
+    std::string path = request.path.substr(0, request.path.find('?'));
+
+    if (request.method == "PUT") {
+        Serve(path, request.body, "application/octet-stream");
+        return { 201, "" };
+    }
+    if (request.method != "GET" && request.method != "HEAD") return { 405, "Method not allowed\n" };
+
+    File file;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = files.find(path);
+        if (found == files.end()) return { 404, "Not found\n" };
+        file = found->second;
+    }
+
+    HttpServerResponse response;
+    response.contentType = file.contentType;
+    response.bytesPerSec = bytesPerSec;
+    response.headers = { "ETag: " + file.etag };
+    if (ranges) response.headers.push_back("Accept-Ranges: bytes");
+
+    // If-Range with a stale validator gets the whole new file, not a slice of it
+    auto range = request.headers.find("range");
+    auto ifRange = request.headers.find("if-range");
+    bool useRange = ranges && range != request.headers.end() && (ifRange == request.headers.end() || ifRange->second == file.etag);
+
+    uint64_t size = file.body->size();
+    uint64_t first = 0, last = 0;
+    bool unsatisfiable = false;
+    if (useRange && ParseRange(range->second, size, first, last, unsatisfiable)) {
+        if (unsatisfiable) {
+            response.status = 416;
+            response.headers.push_back("Content-Range: bytes */" + std::to_string(size));
+            return response;
+        }
+        ++rangeRequests;
+        response.status = 206;
+        response.headers.push_back("Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size));
+        response.body = file.body->substr(static_cast<size_t>(first), static_cast<size_t>(last - first + 1));
+    } else {
+        response.body = *file.body;
+    }
+    if (request.method == "GET") {
+        bodyBytes += response.body.size();
+        int64_t after = stallAfter;
+        if (after >= 0 && static_cast<uint64_t>(after) < response.body.size() && stallAfter.compare_exchange_strong(after, -1)) {
+            response.stallAfter = static_cast<size_t>(after);
+            response.stallMs = stallMs;
+            ++stalls;
+        }
+    }
+    return response;
+}
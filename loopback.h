@@ -0,0 +1,62 @@
+#pragma once
+#include "httpserver.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// a stand-in for the servers the launcher talks to, on 127.0.0.1 with everything in memory, so
+// the network core can be tested and benchmarked with no outside services. files are served the
+// way a CDN serves them: GET, HEAD, one byte range per request, an ETag and If-Range. a PUT
+// stores its body at the path and is answered 201, a GET of that path returns it afterwards
+class LoopbackServer {
+public:
+    LoopbackServer() = default;
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    bool Start(std::string& error);
+    void Stop() { server.Stop(); }
+
+    // serve body at path from now on, with a new ETag. path without the query string
+    void Serve(const std::string& path, std::string body, const std::string& contentType = "application/octet-stream");
+
+    // the body stored at path, empty when there is none
+    std::string Stored(const std::string& path) const;
+
+    // http://127.0.0.1:<port> followed by path
+    std::string Url(const std::string& path = "") const { return "http://127.0.0.1:" + std::to_string(server.Port()) + path; }
+
+    // false answers a Range with the whole file and a 200, like a server without range support
+    std::atomic<bool> ranges = true;
+
+    // cap on each answer's send rate, like a CDN edge that limits every connection. 0 = none
+    std::atomic<int> bytesPerSec = 0;
+
+    // the next GET answer with more than stallAfter body bytes hangs for stallMs after sending
+    // them, once, like a connection that dies mid-transfer without closing. -1 = none
+    std::atomic<int64_t> stallAfter = -1;
+    std::atomic<int> stallMs = 0;
+
+    std::atomic<uint64_t> requests = 0;
+    std::atomic<uint64_t> rangeRequests = 0; // answered 206
+    std::atomic<uint64_t> bodyBytes = 0;     // response bodies, HEAD excluded
+    std::atomic<uint64_t> stalls = 0;
+
+private:
+    struct File {
+        std::shared_ptr<const std::string> body;
+        std::string contentType;
+        std::string etag;
+    };
+
+    HttpServerResponse Answer(const HttpServerRequest& request);
+
+    mutable std::mutex lock;
+    std::map<std::string, File> files;
+    uint64_t version = 0; // for ETags
+    HttpServer server;
+};
@@ -6,19 +6,23 @@
 #include <Windows.h>
 #include <filesystem>
 #include <shellapi.h>
-#include <winhttp.h>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <curl/curl.h>
-#include "base64.h"
+#include "http.h"
+#include "activation.h"
+#include "crc32.h"
+#include "extract.h"
+#include "inflater.h"
+#include "keycache.h"
+#include "license.h"
 #include <nlohmann/json.hpp>
 #include <shlobj.h>
 #include <zip.h>
 #include <wininet.h>
 
-#pragma comment(lib, "winhttp.lib")
 #pragma comment(lib, "zip.lib")
 #pragma comment(lib, "wininet.lib")
 
@@ -31,6 +35,12 @@ static std::atomic<bool> g_DownloadComplete = false;
 static std::atomic<bool> g_DownloadSuccess = false;
 static std::string g_ErrorMessage;
 
+// offline license tokens - leave either empty to validate online on every start
+static const std::string g_LicensePublicKey = ""; // license server's Ed25519 public key, hex
+static const std::string g_LicenseTokenUrl = "";  // signs a token for the key appended to it
+static KeyValidationCache g_KeyCache;             // validation answers, kept in the install folder
+static const std::string g_KeyRegistryUrl = "";   // key registry service (keyregistry.cpp), no trailing slash
+
 // DirectX globals...
 static ID3D11Device* g_pd3dDevice = nullptr;
 static ID3D11DeviceContext* g_pd3dDeviceContext = nullptr;
@@ -59,22 +69,11 @@ inline void OpenBrowser(const std::wstring& url) {
     ShellExecuteW(nullptr, L"open", url.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
 }
 
-static size_t WriteCallbackFile(void* ptr, size_t size, size_t nmemb, FILE* stream) {
-    return fwrite(ptr, size, nmemb, stream);
-}
-
-static int ProgressCallback(void*, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t) {
+static void UpdateProgress(curl_off_t dltotal, curl_off_t dlnow) {
     g_DownloadProgress = dltotal > 0 ? static_cast<float>(dlnow) / static_cast<float>(dltotal) : 0.0f;
-    return 0;
 }
 
 bool DownloadFile(const std::string& url, const std::string& outputPath) {
-    std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl(curl_easy_init(), curl_easy_cleanup);
-    if (!curl) {
-        g_ErrorMessage = "Failed to initialize CURL";
-        return false;
-    }
-
     try {
         std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path());
     }
@@ -91,35 +90,30 @@ bool DownloadFile(const std::string& url, const std::string& outputPath) {
 
     std::unique_ptr<FILE, decltype(&fclose)> file_guard(fp, fclose);
 
-    curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, WriteCallbackFile);
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, fp);
+    HttpRequest request;
+    request.url = url;
+    request.onData = [fp](const char* data, size_t size) { return fwrite(data, 1, size, fp) == size; };
 
     g_DownloadProgress = 0.0f;
-    curl_easy_setopt(curl.get(), CURLOPT_XFERINFOFUNCTION, ProgressCallback);
-    curl_easy_setopt(curl.get(), CURLOPT_XFERINFODATA, nullptr);
-    curl_easy_setopt(curl.get(), CURLOPT_NOPROGRESS, 0L);
-
-    curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYPEER, 0L);
-    curl_easy_setopt(curl.get(), CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64)");
-    curl_easy_setopt(curl.get(), CURLOPT_FAILONERROR, 1L);
-    curl_easy_setopt(curl.get(), CURLOPT_TIMEOUT, 300L);
-    curl_easy_setopt(curl.get(), CURLOPT_CONNECTTIMEOUT, 30L);
-    curl_easy_setopt(curl.get(), CURLOPT_LOW_SPEED_LIMIT, 1000L); // Abort if less than 1KB/sec for 30 sec
-    curl_easy_setopt(curl.get(), CURLOPT_LOW_SPEED_TIME, 30L);
+    request.onProgress = UpdateProgress;
+
+    request.verifyPeer = false;
+    request.userAgent = "Mozilla/5.0 (Windows NT 10.0; Win64; x64)";
+    request.timeout = 300;
+    request.connectTimeout = 30;
+    request.lowSpeedLimit = 1000; // Abort if less than 1KB/sec for 30 sec
+    request.lowSpeedTime = 30;
 
     // HTTP headers
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Accept: */*");
-    headers = curl_slist_append(headers, "Cache-Control: no-cache");
-    curl_easy_setopt(curl.get(), CURLOPT_HTTPHEADER, headers);
+    request.headers = { "Accept: */*", "Cache-Control: no-cache" };
 
-    CURLcode res = curl_easy_perform(curl.get());
-    curl_slist_free_all(headers);
+    HttpResponse response = DefaultHttpClient().Fetch(std::move(request));
+    file_guard.reset();
 
-    if (res != CURLE_OK) {
-        g_ErrorMessage = std::string("Download failed: ") + curl_easy_strerror(res);
+    // FAILONERROR used to turn HTTP errors into a failed transfer
+    if (!response.Ok() || response.status >= 400) {
+        g_ErrorMessage = std::string("Download failed: ") +
+            (!response.Ok() ? response.error : "HTTP error " + std::to_string(response.status));
         std::filesystem::remove(outputPath);
         return false;
     }
@@ -141,7 +135,70 @@ bool DownloadFile(const std::string& url, const std::string& outputPath) {
     return true;
 }
 
+// a deflated entry read raw and inflated here instead of by libzip, whole through libdeflate when
+// it's small enough, streamed through zlib (zlib-ng in compat builds) otherwise. false if the
+// deflate stream is bad, writeOk goes false if the output file couldn't take it
+static bool InflateZipEntry(zip_file* zf, const zip_stat_t& st, Inflater& inflater, std::vector<unsigned char>& packed,
+    std::vector<unsigned char>& unpacked, OutputFile& output, uint32_t& crc, zip_uint64_t& written, bool& writeOk) {
+    size_t room = 0;
+    if (Inflater::PrefersWhole(st.size)) {
+        packed.resize(static_cast<size_t>(st.comp_size));
+        if (zip_fread(zf, packed.data(), st.comp_size) != static_cast<zip_int64_t>(st.comp_size)) return false;
+
+        unsigned char* target = output.Space(room);
+        if (!target) {
+            writeOk = false;
+            return true;
+        }
+        bool inPlace = st.size <= room;
+        if (!inPlace) {
+            unpacked.resize(static_cast<size_t>(st.size));
+            target = unpacked.data();
+        }
+        if (inflater.Whole(packed.data(), packed.size(), target, static_cast<size_t>(st.size)) != InflateResult::Done) return false;
+        if (inPlace) {
+            output.Produced(static_cast<size_t>(st.size));
+        } else {
+            writeOk = output.Write(target, static_cast<size_t>(st.size));
+        }
+        crc = Crc32Update(crc, target, static_cast<size_t>(st.size));
+        written = st.size;
+        return true;
+    }
+
+    if (!inflater.Begin()) return false;
+    packed.resize(256 * 1024);
+    size_t have = 0;
+    size_t offset = 0;
+    InflateResult result = InflateResult::More;
+    while (result == InflateResult::More) {
+        if (offset == have) {
+            zip_int64_t bytesRead = zip_fread(zf, packed.data(), packed.size());
+            if (bytesRead < 0) return false;
+            have = static_cast<size_t>(bytesRead);
+            offset = 0;
+        }
+        unsigned char* space = output.Space(room);
+        if (!space) {
+            writeOk = false;
+            return true;
+        }
+        size_t consumed = 0;
+        size_t produced = 0;
+        result = inflater.Step(packed.data() + offset, have - offset, consumed, space, room, produced);
+        offset += consumed;
+        output.Produced(produced);
+        crc = Crc32Update(crc, space, produced);
+        written += produced;
+        if (result == InflateResult::More && consumed == 0 && produced == 0) return false; // archive ended mid-stream
+    }
+    return result == InflateResult::Done;
+}
+
 bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath) {
+    OutputDebugStringA((std::string("extract: crc32 ") + Crc32Backend() + ", inflate " + Inflater::WholeBackend() +
+        " whole / " + Inflater::StreamBackend() + " streaming\n").c_str());
+
     int err = 0;
     zip* archive = zip_open(zipPath.c_str(), 0, &err);
 
@@ -152,6 +209,11 @@ bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath)
 
     try {
         zip_int64_t num_entries = zip_get_num_entries(archive, 0);
+        DirectoryCache directories(extractPath); // one mkdir per folder, not a stat of every parent per entry
+        OutputFile output;                       // 1 MB buffer reused by every entry
+        Inflater inflater;                       // and the decoder, with its scratch buffers
+        std::vector<unsigned char> packed, unpacked;
+        std::error_code ec;
 
         for (zip_uint64_t i = 0; i < num_entries; ++i) {
             const char* name = zip_get_name(archive, i, 0);
@@ -161,24 +223,72 @@ bool ExtractZipFile(const std::string& zipPath, const std::string& extractPath)
             std::filesystem::path outputPath(fullOutputPath);
 
             if (name[strlen(name) - 1] == '/') {
-                std::filesystem::create_directories(outputPath);
+                if (!directories.Ensure(outputPath.parent_path(), ec)) throw std::filesystem::filesystem_error("create_directory", outputPath, ec);
             }
             else {
-                std::filesystem::create_directories(outputPath.parent_path());
+                if (!directories.Ensure(outputPath.parent_path(), ec)) throw std::filesystem::filesystem_error("create_directory", outputPath, ec);
+
+                zip_stat_t st;
+                zip_stat_init(&st);
+                // plain deflate is read raw and decoded by our own backends, anything else is left to libzip
+                bool statOk = zip_stat_index(archive, i, 0, &st) == 0;
+                zip_uint64_t rawFields = ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD | ZIP_STAT_ENCRYPTION_METHOD;
+                bool raw = statOk && (st.valid & rawFields) == rawFields && st.comp_method == ZIP_CM_DEFLATE && st.encryption_method == ZIP_EM_NONE;
+                zip_file* zf = statOk ? zip_fopen_index(archive, i, raw ? ZIP_FL_COMPRESSED : 0) : nullptr;
+                if (!zf) {
+                    zip_close(archive);
+                    g_ErrorMessage = std::string("Failed to read ZIP entry: ") + name;
+                    return false;
+                }
 
-                zip_file* zf = zip_fopen_index(archive, i, 0);
-                if (!zf) continue;
+                if (!output.Open(outputPath, (st.valid & ZIP_STAT_SIZE) ? static_cast<int64_t>(st.size) : -1)) {
+                    zip_fclose(zf);
+                    zip_close(archive);
+                    g_ErrorMessage = "Failed to open file for writing: " + fullOutputPath;
+                    return false;
+                }
 
-                FILE* fout = nullptr;
-                if (fopen_s(&fout, fullOutputPath.c_str(), "wb") == 0 && fout) {
-                    char buffer[8192]; // Larger buffer for better performance
-                    zip_int64_t bytesRead = 0;
-                    while ((bytesRead = zip_fread(zf, buffer, sizeof(buffer))) > 0) {
-                        fwrite(buffer, 1, static_cast<size_t>(bytesRead), fout);
+                // read straight into the output buffer. crc and length of what reaches the disk
+                // are checked against the central directory below
+                zip_int64_t bytesRead = 0;
+                uint32_t crc = 0;
+                zip_uint64_t written = 0;
+                bool writeOk = true;
+                if (raw) {
+                    if (!InflateZipEntry(zf, st, inflater, packed, unpacked, output, crc, written, writeOk)) bytesRead = -1;
+                }
+                else {
+                    for (;;) {
+                        size_t room = 0;
+                        unsigned char* space = output.Space(room);
+                        if (!space) {
+                            writeOk = false;
+                            break;
+                        }
+                        bytesRead = zip_fread(zf, space, room);
+                        if (bytesRead <= 0) break;
+                        output.Produced(static_cast<size_t>(bytesRead));
+                        crc = Crc32Update(crc, space, static_cast<size_t>(bytesRead));
+                        written += static_cast<zip_uint64_t>(bytesRead);
                     }
-                    fclose(fout);
                 }
+                writeOk = output.Close() && writeOk;
                 zip_fclose(zf);
+
+                std::string entryError;
+                if (!writeOk) {
+                    entryError = "Failed writing " + fullOutputPath + " (disk full?)";
+                } else if (bytesRead < 0) {
+                    entryError = std::string("Corrupt ZIP entry: ") + name;
+                } else if (((st.valid & ZIP_STAT_SIZE) && written != st.size) || ((st.valid & ZIP_STAT_CRC) && crc != st.crc)) {
+                    entryError = std::string("Corrupt ZIP entry: CRC mismatch in ") + name;
+                }
+                if (!entryError.empty()) {
+                    std::filesystem::remove(outputPath, ec);
+                    zip_close(archive);
+                    g_ErrorMessage = entryError;
+                    return false;
+                }
             }
         }
 
@@ -233,241 +343,73 @@ bool SaveKeyToFile(const std::string& key) {
     }
 }
 
-// simple http get with better error handling
+// simple http get with better error handling, on the shared connection pool so the
+// validation, IP lookup and GitHub calls reuse each other's connections
 std::string HttpGet(const std::wstring& host, const std::wstring& path) {
-    HINTERNET hSession = WinHttpOpen(L"VelocityLauncher/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-
-    if (!hSession) {
-        g_ErrorMessage = "Failed to initialize WinHTTP session";
-        return "";
-    }
-
+    std::string url = "https://" + std::string(host.begin(), host.end()) + std::string(path.begin(), path.end());
     std::string result;
-    HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-
-    if (hConnect) {
-        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", path.c_str(),
-            nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
-
-        if (hRequest) {
-            // set timeouts
-            DWORD timeout = 30000; // 30 seconds
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
-
-            if (WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                WINHTTP_NO_REQUEST_DATA, 0, 0, 0) && WinHttpReceiveResponse(hRequest, nullptr)) {
-                DWORD dwSize = 0;
-                do {
-                    DWORD dwDownloaded = 0;
-                    if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
-
-                    if (dwSize > 0) {
-                        std::vector<char> buffer(dwSize + 1);
-                        ZeroMemory(buffer.data(), buffer.size());
-
-                        if (WinHttpReadData(hRequest, buffer.data(), dwSize, &dwDownloaded))
-                            result.append(buffer.data(), dwDownloaded);
-                    }
-                } while (dwSize > 0);
-            }
-            WinHttpCloseHandle(hRequest);
-        }
-        WinHttpCloseHandle(hConnect);
-    }
-    WinHttpCloseHandle(hSession);
+    long httpCode = 0;
+    std::string error;
+
+    if (!HttpGetString(url, result, httpCode, error))
+        result.clear();
 
     return result;
 }
 
+// CheckKeyActivation against the production services, the breakdown of its requests goes to the
+// debug log. the validation cache may run it on a background thread
+static bool CheckKeyOnline(const std::string& token, bool& valid, std::string& error) {
+    ActivationEndpoints endpoints;
+    endpoints.registryUrl = g_KeyRegistryUrl;
+
+    HttpRequestGroup group;
+    bool answered = CheckKeyActivation(group, endpoints, token, valid, error);
+    OutputDebugStringA(("key validation:\n" + group.Report()).c_str());
+    return answered;
+}
+
+// validateKey through the validation cache: a key checked recently isn't sent out again
 bool validateKey(const std::string& token) {
     if (token.empty()) {
         g_ErrorMessage = "Empty key";
         return false;
     }
 
-    try {
-        std::wstring host = L"work.ink";
-        std::wstring path = L"/_api/v2/token/isValid/" + std::wstring(token.begin(), token.end());
-        std::string response = HttpGet(host, path);
-
-        if (response.empty()) {
-            g_ErrorMessage = "Work.ink validation failed";
-            return false;
-        }
-
-        auto workInkJson = json::parse(response);
-        if (!workInkJson["valid"].get<bool>()) {
-            g_ErrorMessage = "Invalid key";
-            return false;
-        }
-
-        // get current IP
-        std::string ipResponse = HttpGet(L"api.ipify.org", L"/?format=json");
-        if (ipResponse.empty()) {
-            g_ErrorMessage = "Failed to get IP address";
-            return false;
-        }
-
-        std::string currentIP;
-        try {
-            currentIP = json::parse(ipResponse)["ip"].get<std::string>();
-        }
-        catch (...) {
-            g_ErrorMessage = "Failed to parse IP address";
-            return false;
-        }
-
-        // fetch existing keys from GitHub
-        std::string githubUrl = "";
-        std::string tokenHeader = "Authorization: Bearer";
-
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-            g_ErrorMessage = "CURL initialization failed";
-            return false;
-        }
-
-        std::string jsonStr;
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, tokenHeader.c_str());
-        headers = curl_slist_append(headers, "User-Agent: VelocityUploader");
-        curl_easy_setopt(curl, CURLOPT_URL, githubUrl.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, +[](char* ptr, size_t size, size_t nmemb, std::string* data) {
-            data->append(ptr, size * nmemb); return size * nmemb;
-            });
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &jsonStr);
-        CURLcode res = curl_easy_perform(curl);
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-
-        if (res != CURLE_OK || jsonStr.empty()) {
-            g_ErrorMessage = "Failed to fetch keys from GitHub";
-            return false;
-        }
-
-        // parse GitHub response
-        json ghJson;
-        try {
-            ghJson = json::parse(jsonStr);
-        }
-        catch (const std::exception& e) {
-            g_ErrorMessage = "Failed to parse GitHub response";
-            return false;
-        }
-
-        std::string sha = ghJson["sha"];
-        std::string downloadUrl = ghJson["download_url"];
-
-        std::string contentRaw = HttpGet(L"raw.githubusercontent.com",
-            std::wstring(downloadUrl.begin() + 8, downloadUrl.end()));
-
-        if (contentRaw.empty()) {
-            g_ErrorMessage = "Failed to get keys content from GitHub";
-            return false;
-        }
-
-        json keysJson;
-        try {
-            keysJson = json::parse(contentRaw);
-        }
-        catch (const std::exception& e) {
-            keysJson = json::object();
-        }
-
-        bool keyExists = keysJson.contains(token);
-
-        if (keyExists) {
-            std::string savedIP = keysJson[token].get<std::string>();
-
-            // If IP mismatch, reject the key - NEVER override an existing IP
-            if (savedIP != currentIP) {
-                g_ErrorMessage = "HWID/IP Mismatch: This key is already registered to a different IP address";
-                return false;
-            }
-            return true;
-        }
-        
-        keysJson[token] = currentIP;
-
-        std::string updatedContent = keysJson.dump();
-        std::string encoded;
-        try {
-            encoded = base64_encode(updatedContent);
-        }
-        catch (const std::exception& e) {
-            g_ErrorMessage = "Encoding failed";
-            return false;
-        }
-
-        json payload = {
-            {"message", "Add key " + token},
-            {"content", encoded},
-            {"sha", sha}
-        };
-
-        std::string uploadJson = payload.dump();
-
-        CURL* pushCurl = curl_easy_init();
-        if (!pushCurl) {
-            g_ErrorMessage = "Failed to initialize CURL for upload";
-            return false;
-        }
-
-        std::string result;
-        struct curl_slist* pushHeaders = NULL;
-        pushHeaders = curl_slist_append(pushHeaders, tokenHeader.c_str());
-        pushHeaders = curl_slist_append(pushHeaders, "User-Agent: VelocityUploader");
-        pushHeaders = curl_slist_append(pushHeaders, "Content-Type: application/json");
-
-        curl_easy_setopt(pushCurl, CURLOPT_URL, githubUrl.c_str());
-        curl_easy_setopt(pushCurl, CURLOPT_CUSTOMREQUEST, "PUT");
-        curl_easy_setopt(pushCurl, CURLOPT_HTTPHEADER, pushHeaders);
-        curl_easy_setopt(pushCurl, CURLOPT_POSTFIELDS, uploadJson.c_str());
-        curl_easy_setopt(pushCurl, CURLOPT_WRITEFUNCTION, +[](char* ptr, size_t size, size_t nmemb, std::string* data) {
-            data->append(ptr, size * nmemb); return size * nmemb;
-            });
-        curl_easy_setopt(pushCurl, CURLOPT_WRITEDATA, &result);
-
-        CURLcode pushRes = curl_easy_perform(pushCurl);
-        curl_slist_free_all(pushHeaders);
-        curl_easy_cleanup(pushCurl);
-
-        if (pushRes != CURLE_OK) {
-            g_ErrorMessage = "Failed to register key";
-            return false;
-        }
-
-        if (!result.empty()) {
-            try {
-                auto resultJson = json::parse(result);
-                if (resultJson.contains("message") &&
-                    resultJson["message"].get<std::string>() != "OK" &&
-                    !resultJson.contains("content")) {
-                    g_ErrorMessage = "GitHub error: " + resultJson["message"].get<std::string>();
-                    return false;
-                }
-            }
-            catch (...) {}
-        }
-
-        return true;
-    }
-    catch (const json::exception& e) {
-        g_ErrorMessage = std::string("JSON error: ") + e.what();
+    bool valid = false;
+    std::string error;
+    if (!g_KeyCache.Validate(token, CheckKeyOnline, valid, error)) {
+        g_ErrorMessage = error;
         return false;
     }
-    catch (const std::exception& e) {
-        g_ErrorMessage = std::string("Validation error: ") + e.what();
+    if (!valid) {
+        g_ErrorMessage = error.empty() ? "Invalid key" : error;
         return false;
     }
-    catch (...) {
-        g_ErrorMessage = "Unknown validation error";
-        return false;
+    return true;
+}
+
+static std::string LicenseTokenPath() {
+    return std::filesystem::current_path().string() + "\\license.token";
+}
+
+// store a signed token for a key that just passed validateKey, so the next start can skip it.
+// nothing happens when tokens aren't configured or the server's token doesn't verify
+static void RenewLicenseToken(const std::string& key) {
+    if (g_LicenseTokenUrl.empty() || g_LicensePublicKey.empty())
+        return;
+
+    std::string body, error;
+    long httpCode = 0;
+    if (!HttpGetString(g_LicenseTokenUrl + key, body, httpCode, error) || httpCode != 200)
+        return;
+
+    try {
+        std::string token = json::parse(body)["token"].get<std::string>();
+        if (VerifyLicenseToken(token, key, g_LicensePublicKey, time(nullptr), error))
+            SaveLicenseToken(LicenseTokenPath(), token);
     }
+    catch (const std::exception&) {}
 }
 
 // the function that downloads+unzips+creates key
@@ -488,6 +430,7 @@ bool ProcessValidKey(const std::string& key) {
         g_DownloadInProgress = false;
         return false;
     }
+    RenewLicenseToken(key);
 
     try {
         std::filesystem::remove(zipPath);
@@ -521,10 +464,16 @@ bool CheckForKeyAndLaunchSynapse() {
             return false;
         }
 
+        // a token from an earlier validation skips the work.ink, IP and GitHub round trips,
+        // the full check then runs after the launch instead of in front of it
+        std::string tokenError;
+        bool offline = VerifyLicenseToken(LoadLicenseToken(LicenseTokenPath()), key, g_LicensePublicKey, time(nullptr), tokenError);
+
         // IMPORTANT: Validate the key against the GitHub repo
-        if (!validateKey(key)) {
+        if (!offline && !validateKey(key)) {
             try {
                 std::filesystem::remove(keyFilePath);
+                std::filesystem::remove(LicenseTokenPath());
             }
             catch (...) {}
             return false;
@@ -548,6 +497,16 @@ bool CheckForKeyAndLaunchSynapse() {
         sei.nShow = SW_SHOWNORMAL;
 
         if (ShellExecuteExA(&sei)) {
+            // Synapse is starting. a token that no longer passes the full check is dropped, whatever
+            // the reason, so the next start validates online again and deals with the key then
+            if (!offline || validateKey(key))
+                RenewLicenseToken(key);
+            else {
+                std::error_code ec;
+                std::filesystem::remove(LicenseTokenPath(), ec);
+            }
+            g_KeyCache.WaitForRevalidation();
+            OutputDebugStringA(g_KeyCache.Report().c_str());
             exit(0);
             return true;
         }
@@ -639,6 +598,15 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     return ::DefWindowProcW(hWnd, msg, wParam, lParam);
 }
 
+// log what the connection pool saved (handshakes, per-request latency) and release it with curl
+static void ShutdownNetwork() {
+    g_KeyCache.WaitForRevalidation();
+    OutputDebugStringA(g_KeyCache.Report().c_str());
+    OutputDebugStringA(HttpPoolReport().c_str());
+    HttpPoolShutdown();
+    curl_global_cleanup();
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     // init curl
     curl_global_init(CURL_GLOBAL_ALL);
@@ -646,9 +614,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     char appDataPath[MAX_PATH] = { 0 };
     SHGetFolderPathA(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath);
     hiddenFolderPath = std::string(appDataPath) + "\\VelocityData";
+    g_KeyCache.Open(hiddenFolderPath + "\\validation.cache");
 
     if (CheckForKeyAndLaunchSynapse()) {
-        curl_global_cleanup();
+        ShutdownNetwork();
         return 0;
     }
 
@@ -660,7 +629,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     if (!CreateDeviceD3D(hwnd)) {
         CleanupDeviceD3D();
         UnregisterClassW(wc.lpszClassName, wc.hInstance);
-        curl_global_cleanup();
+        ShutdownNetwork();
         return 1;
     }
 
@@ -868,7 +837,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     CleanupDeviceD3D();
     DestroyWindow(hwnd);
     UnregisterClassW(wc.lpszClassName, wc.hInstance);
-    curl_global_cleanup();
+    ShutdownNetwork();
 
     return 0;
 }
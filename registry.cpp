@@ -0,0 +1,202 @@
+#include "registry.h"
+#include "crc32.h"
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// file: "KRG1" + 4 reserved bytes, then one fixed-size record per binding, all little-endian:
+// sha256, bound at (int64), binding length, binding, padding, crc32 of everything before it
+static const char kMagic[4] = { 'K', 'R', 'G', '1' };
+static const size_t kHeaderSize = 8;
+static const size_t kRecordSize = 112;
+static const size_t kCrcOffset = kRecordSize - 4;
+static const char* kKeysPrefix = "/v1/keys/";
+
+static uint64_t ReadLE(const unsigned char* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = bytes; i-- > 0;) value = (value << 8) | p[i];
+    return value;
+}
+
+static void WriteLE(unsigned char* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i, value >>= 8) p[i] = static_cast<unsigned char>(value);
+}
+
+// 64 hex digits to the raw 32 bytes
+static bool ParseKeyHash(const std::string& hex, std::string& hash) {
+    if (hex.size() != 64) return false;
+    hash.resize(32);
+    for (size_t i = 0; i < 32; ++i) {
+        int value = 0;
+        for (size_t j = 2 * i; j < 2 * i + 2; ++j) {
+            char c = hex[j];
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0) return false;
+            value = value * 16 + digit;
+        }
+        hash[i] = static_cast<char>(value);
+    }
+    return true;
+}
+
+static bool ValidBinding(const std::string& binding) {
+    if (binding.empty() || binding.size() > KeyRegistry::kMaxBinding) return false;
+    for (char c : binding) {
+        if (c < 0x21 || c > 0x7e) return false;
+    }
+    return true;
+}
+
+const char* BindResultName(BindResult result) {
+    switch (result) {
+    case BindResult::Bound: return "bound";
+    case BindResult::AlreadyBound: return "already bound";
+    case BindResult::Conflict: return "conflict";
+    case BindResult::Rejected: return "rejected";
+    default: return "failed";
+    }
+}
+
+KeyRegistry::~KeyRegistry() {
+    if (log) std::fclose(log);
+}
+
+bool KeyRegistry::Open(const std::filesystem::path& path, std::string& error) {
+    if (path.empty()) return true;
+
+    std::vector<unsigned char> data;
+    if (std::FILE* file = std::fopen(path.string().c_str(), "rb")) {
+        unsigned char buffer[64 * 1024];
+        size_t got;
+        while ((got = std::fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + got);
+        std::fclose(file);
+    }
+
+    size_t valid = 0; // bytes of the file that are a header and whole records
+    if (data.size() >= kHeaderSize) {
+        if (memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+            error = "Not a key registry: " + path.string();
+            return false;
+        }
+        valid = kHeaderSize;
+        for (; valid + kRecordSize <= data.size(); valid += kRecordSize) {
+            const unsigned char* record = data.data() + valid;
+            size_t length = record[40];
+            if (length == 0 || length > kMaxBinding || ReadLE(record + kCrcOffset, 4) != Crc32Update(0, record, kCrcOffset)) break;
+            std::string hash(reinterpret_cast<const char*>(record), 32);
+            Shard& shard = shards[static_cast<unsigned char>(hash[0]) % kShards];
+            if (shard.bindings.emplace(std::move(hash), std::string(reinterpret_cast<const char*>(record) + 41, length)).second) ++size;
+        }
+    }
+
+    std::error_code ec;
+    if (valid == 0) std::filesystem::create_directories(path.parent_path(), ec);
+    if (valid != data.size()) {
+        std::filesystem::resize_file(path, valid, ec); // a write cut short by a crash
+        if (ec) {
+            error = "Failed to repair " + path.string() + ": " + ec.message();
+            return false;
+        }
+    }
+
+    log = std::fopen(path.string().c_str(), "ab");
+    if (!log) {
+        error = "Failed to open " + path.string();
+        return false;
+    }
+    if (valid == 0) {
+        unsigned char header[kHeaderSize] = {};
+        memcpy(header, kMagic, sizeof(kMagic));
+        if (std::fwrite(header, 1, sizeof(header), log) != sizeof(header) || std::fflush(log) != 0) {
+            error = "Failed to write " + path.string();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KeyRegistry::Lookup(const std::string& keyHash, std::string& binding) const {
+    std::string hash;
+    if (!ParseKeyHash(keyHash, hash)) return false;
+    const Shard& shard = shards[static_cast<unsigned char>(hash[0]) % kShards];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.bindings.find(hash);
+    if (found == shard.bindings.end()) return false;
+    binding = found->second;
+    return true;
+}
+
+BindResult KeyRegistry::Bind(const std::string& keyHash, const std::string& binding, std::string& current, std::string& error) {
+    std::string hash;
+    if (!ParseKeyHash(keyHash, hash)) {
+        error = "Malformed key hash";
+        return BindResult::Rejected;
+    }
+    if (!ValidBinding(binding)) {
+        error = "Malformed binding";
+        return BindResult::Rejected;
+    }
+
+    // the shard stays locked until the record is written, two activations of one key can't both win
+    Shard& shard = shards[static_cast<unsigned char>(hash[0]) % kShards];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.bindings.find(hash);
+    if (found != shard.bindings.end()) {
+        current = found->second;
+        return current == binding ? BindResult::AlreadyBound : BindResult::Conflict;
+    }
+    if (!Append(hash, binding, error)) return BindResult::Failed;
+    shard.bindings.emplace(std::move(hash), binding);
+    ++size;
+    current = binding;
+    return BindResult::Bound;
+}
+
+// flushed to the OS before the bind is acknowledged: the binding survives the service dying,
+// only a crash of the machine itself can take the last few
+bool KeyRegistry::Append(const std::string& hash, const std::string& binding, std::string& error) {
+    if (!log) return true;
+
+    unsigned char record[kRecordSize] = {};
+    memcpy(record, hash.data(), 32);
+    WriteLE(record + 32, static_cast<uint64_t>(time(nullptr)), 8);
+    record[40] = static_cast<unsigned char>(binding.size());
+    memcpy(record + 41, binding.data(), binding.size());
+    WriteLE(record + kCrcOffset, Crc32Update(0, record, kCrcOffset), 4);
+
+    std::lock_guard<std::mutex> guard(logLock);
+    if (std::fwrite(record, 1, sizeof(record), log) != sizeof(record) || std::fflush(log) != 0) {
+        error = "Failed to write the registry";
+        return false;
+    }
+    return true;
+}
+
+HttpServer::Handler KeyRegistryHandler(KeyRegistry& registry) {
+    return [&registry](const HttpServerRequest& request) -> HttpServerResponse {
+        if (request.path == "/health") return { 200, "ok " + std::to_string(registry.Size()) + "\n" };
+        if (request.path.compare(0, strlen(kKeysPrefix), kKeysPrefix) != 0) return { 404, "Not found\n" };
+        std::string keyHash = request.path.substr(strlen(kKeysPrefix));
+
+        if (request.method == "GET") {
+            std::string binding;
+            if (!registry.Lookup(keyHash, binding)) return { 404, "Not bound\n" };
+            return { 200, binding };
+        }
+        if (request.method == "PUT") {
+            std::string current, error;
+            switch (registry.Bind(keyHash, request.body, current, error)) {
+            case BindResult::Bound: return { 201, current };
+            case BindResult::AlreadyBound: return { 200, current };
+            case BindResult::Conflict: return { 409, current };
+            case BindResult::Rejected: return { 400, error + "\n" };
+            default: return { 503, error + "\n" };
+            }
+        }
+        return { 405, "Method not allowed\n" };
+    };
+}
+
+bool LocalKeyRegistry::Start(std::string& error) {
+    return server.Start("127.0.0.1", 0, KeyRegistryHandler(registry), error);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "httpserver.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class BindResult {
+    Bound,        // the key had no binding, now it has this one
+    AlreadyBound, // the key was bound to this same value before
+    Conflict,     // the key is bound to something else, current says what
+    Rejected,     // malformed key hash or binding
+    Failed        // no answer: store or network trouble, error says why
+};
+
+const char* BindResultName(BindResult result);
+
+// which machine each key is activated on, for the key registry service. keys are only ever seen
+// as their sha256, so neither memory nor the file holds one. every lookup and bind is one hash
+// lookup in a sharded in-memory index, a new binding is also one record appended to the log file
+// the index is rebuilt from at Open. a binding is never changed once made
+class KeyRegistry {
+public:
+    static const size_t kMaxBinding = 64; // an IP or a HWID, printable ASCII
+
+    KeyRegistry() = default;
+    ~KeyRegistry();
+
+    KeyRegistry(const KeyRegistry&) = delete;
+    KeyRegistry& operator=(const KeyRegistry&) = delete;
+
+    // load the log at path and append to it from now on. a torn last record is cut off. an empty
+    // path keeps everything in memory, for local stand-ins
+    bool Open(const std::filesystem::path& path, std::string& error);
+
+    // keyHash is the hex sha256 of the key, as LicenseKeyHash gives it
+    bool Lookup(const std::string& keyHash, std::string& binding) const;
+
+    // compare-and-set: bind the key to binding unless it's bound to something else already
+    BindResult Bind(const std::string& keyHash, const std::string& binding, std::string& current, std::string& error);
+
+    size_t Size() const { return size; }
+
+private:
+    static const size_t kShards = 64;
+
+    struct Shard {
+        mutable std::mutex lock;
+        std::unordered_map<std::string, std::string> bindings; // raw 32-byte sha256 -> binding
+    };
+
+    bool Append(const std::string& hash, const std::string& binding, std::string& error);
+
+    std::array<Shard, kShards> shards;
+    std::FILE* log = nullptr;
+    std::mutex logLock;
+    std::atomic<size_t> size = 0;
+};
+
+// the registry's HTTP interface, plain text both ways:
+//   GET /v1/keys/<hex sha256>  200 with the binding, 404 when there is none
+//   PUT /v1/keys/<hex sha256>  binding as the body. 201 bound, 200 already bound to it,
+//                              409 bound to something else, the body is the binding in all three
+//   GET /health                200 "ok <keys>"
+HttpServer::Handler KeyRegistryHandler(KeyRegistry& registry);
+
+// the whole service in this process on 127.0.0.1, any free port, store in memory: what the
+// launcher and the load tests talk to during development
+class LocalKeyRegistry {
+public:
+    bool Start(std::string& error);
+    void Stop() { server.Stop(); }
+
+    std::string Url() const { return "http://127.0.0.1:" + std::to_string(server.Port()); }
+
+    KeyRegistry registry;
+
+private:
+    HttpServer server;
+};
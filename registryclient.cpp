@@ -0,0 +1,47 @@
+#include "registryclient.h"
+#include "sha256.h"
+
+KeyRegistryClient::KeyRegistryClient(std::string baseUrl, HttpClient& client)
+    : baseUrl(std::move(baseUrl)), client(client) {
+}
+
+BindResult KeyRegistryClient::Bind(const std::string& key, const std::string& binding, std::string& current, std::string& error) {
+    return ParseBind(client.Fetch(BindRequest(key, binding)), current, error);
+}
+
+HttpRequest KeyRegistryClient::BindRequest(const std::string& key, const std::string& binding) const {
+    Sha256 hasher;
+    hasher.Update(key.data(), key.size());
+
+    HttpRequest request;
+    request.method = "PUT";
+    request.url = baseUrl + "/v1/keys/" + Sha256::ToHex(hasher.Final());
+    request.headers = { "Content-Type: text/plain" };
+    request.body = binding;
+    request.timeout = 10;
+    return request;
+}
+
+BindResult KeyRegistryClient::ParseBind(const HttpResponse& response, std::string& current, std::string& error) {
+    if (!response.Ok()) {
+        error = "Key registry unreachable: " + response.error;
+        return BindResult::Failed;
+    }
+    switch (response.status) {
+    case 201:
+        current = response.body;
+        return BindResult::Bound;
+    case 200:
+        current = response.body;
+        return BindResult::AlreadyBound;
+    case 409:
+        current = response.body;
+        return BindResult::Conflict;
+    case 400:
+        error = "Key registry rejected the request: " + response.body;
+        return BindResult::Rejected;
+    default:
+        error = "Key registry answered HTTP " + std::to_string(response.status);
+        return BindResult::Failed;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "http.h"
+#include "registry.h"
+#include <string>
+
+// what the launcher uses to activate a key with the key registry service (registry.h) in place of
+// rewriting a JSON file on GitHub. the key itself never leaves the machine, only its sha256
+class KeyRegistryClient {
+public:
+    // baseUrl without a trailing slash, "https://registry.example" or LocalKeyRegistry::Url()
+    explicit KeyRegistryClient(std::string baseUrl, HttpClient& client = DefaultHttpClient());
+
+    // bind key to binding (the machine's IP or HWID) unless it's bound elsewhere already
+    BindResult Bind(const std::string& key, const std::string& binding, std::string& current, std::string& error);
+
+    // the same in two halves, for sending it as part of an HttpRequestGroup
+    HttpRequest BindRequest(const std::string& key, const std::string& binding) const;
+    static BindResult ParseBind(const HttpResponse& response, std::string& current, std::string& error);
+
+private:
+    std::string baseUrl;
+    HttpClient& client;
+};
@@ -0,0 +1,256 @@
+#include "sha256.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SHA256_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// gcc and clang only emit SHA/SSE4.1 instructions in functions that ask for them, MSVC always does
+#if defined(SHA256_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define SHA256_TARGET
+#endif
+
+static const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t RotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static inline uint32_t ReadBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// plain C++, for any CPU
+static void CompressPortable(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    for (; count > 0; --count, blocks += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = ReadBE32(blocks + i * 4);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            uint32_t choice = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + choice + kRoundConstants[i] + w[i];
+            uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + majority;
+
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA256_X86
+// SHA extensions (Intel since Goldmont / Ice Lake, AMD since Zen): two rounds per sha256rnds2 and
+// the message schedule in sha256msg1/msg2, several times the portable speed. the state is kept
+// in the ABEF/CDGH register layout the instructions want and converted back after the last block
+SHA256_TARGET static void CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (; count > 0; --count, blocks += 64) {
+        __m128i abefStart = abef;
+        __m128i cdghStart = cdgh;
+        __m128i w[4];
+
+        // 16 groups of 4 rounds, w holds the last four groups of the message schedule
+        for (int group = 0; group < 16; ++group) {
+            if (group < 4) {
+                w[group] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + group * 16)), byteSwap);
+            }
+            __m128i message = _mm_add_epi32(w[group & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(kRoundConstants + group * 4)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0E));
+
+            // group n = group + 1 from groups n-4 .. n-1
+            if (group >= 3 && group < 15) {
+                __m128i next = _mm_sha256msg1_epu32(w[(group + 1) & 3], w[(group + 2) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[group & 3], w[(group + 3) & 3], 4));
+                w[(group + 1) & 3] = _mm_sha256msg2_epu32(next, w[group & 3]);
+            }
+        }
+
+        abef = _mm_add_epi32(abef, abefStart);
+        cdgh = _mm_add_epi32(cdgh, cdghStart);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+static bool CpuHasShaNi() {
+    int leaf1[4] = {};
+    int leaf7[4] = {};
+#ifdef _MSC_VER
+    __cpuid(leaf1, 1);
+    __cpuidex(leaf7, 7, 0);
+#else
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    leaf1[2] = static_cast<int>(c);
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    leaf7[1] = static_cast<int>(b);
+#endif
+    bool ssse3 = (leaf1[2] & (1 << 9)) != 0;
+    bool sse41 = (leaf1[2] & (1 << 19)) != 0;
+    bool sha = (leaf7[1] & (1 << 29)) != 0;
+    return ssse3 && sse41 && sha;
+}
+#endif
+
+using CompressFunction = void (*)(uint32_t state[8], const uint8_t* blocks, size_t count);
+
+static CompressFunction CompressFor(Sha256::Backend backend) {
+#ifdef SHA256_X86
+    if (backend == Sha256::Backend::ShaNi) return CompressShaNi;
+#endif
+    return CompressPortable;
+}
+
+Sha256::Backend Sha256::Fastest() {
+#ifdef SHA256_X86
+    static const bool shaNi = CpuHasShaNi();
+    if (shaNi) return Backend::ShaNi;
+#endif
+    return Backend::Portable;
+}
+
+bool Sha256::Supported(Backend backend) {
+    return backend == Backend::Portable || Fastest() == Backend::ShaNi;
+}
+
+const char* Sha256::BackendName(Backend backend) {
+    return backend == Backend::ShaNi ? "sha-ni" : "portable";
+}
+
+Sha256::Sha256() : Sha256(Fastest()) {}
+
+Sha256::Sha256(Backend backend) : backend(Supported(backend) ? backend : Backend::Portable) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(state, initial, sizeof(state));
+}
+
+void Sha256::Compress(const uint8_t* blocks, size_t count) {
+    CompressFor(backend)(state, blocks, count);
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    totalSize += size;
+
+    if (bufferSize > 0) {
+        size_t take = 64 - bufferSize < size ? 64 - bufferSize : size;
+        memcpy(buffer + bufferSize, bytes, take);
+        bufferSize += take;
+        bytes += take;
+        size -= take;
+        if (bufferSize < 64) return;
+        Compress(buffer, 1);
+        bufferSize = 0;
+    }
+
+    // whole blocks straight from the caller's memory
+    size_t blocks = size / 64;
+    if (blocks > 0) {
+        Compress(bytes, blocks);
+        bytes += blocks * 64;
+        size -= blocks * 64;
+    }
+
+    memcpy(buffer, bytes, size);
+    bufferSize = size;
+}
+
+Sha256::Digest Sha256::Final() {
+    uint64_t bitLength = totalSize * 8;
+    uint8_t padding[72] = { 0x80 };
+    size_t padLength = (bufferSize < 56 ? 56 : 120) - bufferSize;
+    for (int i = 0; i < 8; ++i) {
+        padding[padLength + i] = static_cast<uint8_t>(bitLength >> (56 - 8 * i));
+    }
+    Update(padding, padLength + 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+std::string Sha256::ToHex(const Digest& digest) {
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(64);
+    for (uint8_t byte : digest) {
+        hex.push_back(hexDigits[byte >> 4]);
+        hex.push_back(hexDigits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+std::string Sha256File(const std::filesystem::path& path) {
+#ifdef _WIN32
+    FILE* fp = nullptr;
+    if (_wfopen_s(&fp, path.c_str(), L"rb") != 0) fp = nullptr;
+#else
+    FILE* fp = fopen(path.c_str(), "rb");
+#endif
+    if (!fp) return "";
+
+    Sha256 hasher;
+    std::vector<uint8_t> chunk(256 * 1024);
+    size_t bytesRead = 0;
+    while ((bytesRead = fread(chunk.data(), 1, chunk.size(), fp)) > 0) {
+        hasher.Update(chunk.data(), bytesRead);
+    }
+    bool readError = ferror(fp) != 0;
+    fclose(fp);
+
+    return readError ? "" : Sha256::ToHex(hasher.Final());
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// incremental SHA-256, feed bytes with Update as they arrive and read the digest once with Final.
+// runs on the CPU's SHA extensions when it has them, portable code otherwise
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    enum class Backend { Portable, ShaNi };
+
+    Sha256(); // fastest backend this CPU supports
+    explicit Sha256(Backend backend); // falls back to Portable if the CPU can't run it
+
+    static Backend Fastest();
+    static bool Supported(Backend backend);
+    static const char* BackendName(Backend backend);
+
+    void Update(const void* data, size_t size);
+    Digest Final();
+
+    static std::string ToHex(const Digest& digest);
+
+private:
+    void Compress(const uint8_t* blocks, size_t count);
+
+    Backend backend;
+    uint32_t state[8];
+    uint8_t buffer[64];
+    size_t bufferSize = 0;
+    uint64_t totalSize = 0;
+};
+
+// lowercase hex digest of a whole file, empty string if it can't be read
+std::string Sha256File(const std::filesystem::path& path);
@@ -0,0 +1,254 @@
+#include "staging.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const size_t kSyncBatch = 64; // files a sync worker claims at a time
+static const char* kReadyMarker = ".ready"; // in the staging folder once the staged tree is on disk
+
+static bool SyncPath(const std::filesystem::path& path, bool directory) {
+#ifdef _WIN32
+    // NTFS journals directory changes itself, only file data needs flushing
+    if (directory) return true;
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    bool flushed = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+    return flushed;
+#else
+    int fd = open(path.c_str(), (directory ? O_DIRECTORY : 0) | O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool flushed = fsync(fd) == 0;
+    close(fd);
+    return flushed;
+#endif
+}
+
+bool SyncDirectoryTree(const std::filesystem::path& root, unsigned threadCount, std::string& error) {
+    std::vector<std::filesystem::path> files;
+    std::vector<std::filesystem::path> directories{ root };
+    try {
+        for (const auto& item : std::filesystem::recursive_directory_iterator(root)) {
+            if (item.is_regular_file()) {
+                files.push_back(item.path());
+            } else if (item.is_directory()) {
+                directories.push_back(item.path());
+            }
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Failed to scan staged install: ") + e.what();
+        return false;
+    }
+
+    // all the flushes go out together, so the disk can take the dirty pages in whatever order suits it
+    if (threadCount == 0) threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    size_t batches = (files.size() + kSyncBatch - 1) / kSyncBatch;
+    threadCount = static_cast<unsigned>((std::min)(static_cast<size_t>(threadCount), (std::max)(batches, static_cast<size_t>(1))));
+
+    std::atomic<size_t> next = 0;
+    std::atomic<bool> failed = false;
+    std::mutex errorLock;
+    auto worker = [&]() {
+        for (;;) {
+            size_t first = next.fetch_add(kSyncBatch);
+            if (first >= files.size() || failed) return;
+            size_t last = (std::min)(first + kSyncBatch, files.size());
+            for (size_t i = first; i < last; ++i) {
+                if (SyncPath(files[i], false)) continue;
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!failed.exchange(true)) error = "Failed to flush " + files[i].string();
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (failed) return false;
+
+    // the entries naming those files
+    for (const std::filesystem::path& directory : directories) {
+        if (!SyncPath(directory, true)) {
+            error = "Failed to flush " + directory.string();
+            return false;
+        }
+    }
+    return true;
+}
+
+StagedInstall::StagedInstall(const std::filesystem::path& root, const std::string& name, size_t keepVersions)
+    : root(root), live(root / name), staging(root / ".staging"), versions(root / ".versions"), name(name), keepVersions(keepVersions) {
+}
+
+// kept versions are numbered folders, higher is newer
+static bool VersionNumber(const std::filesystem::path& path, unsigned long long& number) {
+    std::string text = path.filename().string();
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    number = std::stoull(text);
+    return true;
+}
+
+std::filesystem::path StagedInstall::NewestVersion() const {
+    std::filesystem::path newest;
+    unsigned long long newestNumber = 0;
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(versions, ec)) {
+        unsigned long long number = 0;
+        if (item.is_directory() && VersionNumber(item.path(), number) && (newest.empty() || number > newestNumber)) {
+            newest = item.path();
+            newestNumber = number;
+        }
+    }
+    return newest;
+}
+
+void StagedInstall::PruneVersions() {
+    std::vector<std::pair<unsigned long long, std::filesystem::path>> kept;
+    std::error_code ec;
+    for (const auto& item : std::filesystem::directory_iterator(versions, ec)) {
+        unsigned long long number = 0;
+        if (item.is_directory() && VersionNumber(item.path(), number)) kept.emplace_back(number, item.path());
+    }
+    if (kept.size() <= keepVersions) return;
+
+    std::sort(kept.begin(), kept.end());
+    for (size_t i = 0; i + keepVersions < kept.size(); ++i) {
+        std::filesystem::remove_all(kept[i].second, ec);
+    }
+}
+
+bool StagedInstall::Recover(std::string& error) {
+    std::error_code ec;
+    if (std::filesystem::exists(live, ec)) return true;
+
+    try {
+        // the old tree already moved aside but the new one didn't make it in: it's complete if the marker is there
+        std::filesystem::path staged = staging / name;
+        if (std::filesystem::exists(staging / kReadyMarker) && std::filesystem::is_directory(staged)) {
+            std::filesystem::rename(staged, live);
+            std::filesystem::remove_all(staging, ec);
+            return true;
+        }
+
+        std::filesystem::path newest = NewestVersion();
+        if (!newest.empty()) {
+            std::filesystem::rename(newest, live);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error = std::string("Failed to recover the previous install: ") + e.what();
+        return false;
+    }
+}
+
+bool StagedInstall::Prepare(std::string& error) {
+    if (!Recover(error)) return false;
+
+    try {
+        std::filesystem::remove_all(staging);
+        std::filesystem::create_directories(staging);
+        return true;
+    } catch (const std::exception& e) {
+        error = std::string("Failed to prepare staging folder: ") + e.what();
+        return false;
+    }
+}
+
+bool StagedInstall::Commit(unsigned threadCount, std::string& error) {
+    std::filesystem::path staged = staging / name;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(staged, ec)) {
+        error = "Staged install is incomplete: " + name + " is missing";
+        return false;
+    }
+
+    // nothing gets renamed until every byte of the new tree is on disk, then the marker says so
+    if (!SyncDirectoryTree(staged, threadCount, error)) return false;
+    {
+        std::ofstream marker(staging / kReadyMarker, std::ios::trunc);
+        if (!marker) {
+            error = "Failed to mark staged install ready";
+            return false;
+        }
+    }
+    SyncPath(staging / kReadyMarker, false);
+    SyncPath(staging, true);
+
+    std::filesystem::path previous;
+    try {
+        if (std::filesystem::exists(live)) {
+            std::filesystem::path newest = NewestVersion();
+            unsigned long long number = 0;
+            if (!newest.empty()) VersionNumber(newest, number);
+            previous = versions / std::to_string(number + 1);
+            std::filesystem::create_directories(versions);
+            std::filesystem::rename(live, previous);
+        }
+    } catch (const std::exception& e) {
+        // usually a file in the live tree is still open, nothing has moved yet
+        std::filesystem::remove(staging / kReadyMarker, ec);
+        error = std::string("Failed to replace the current install (is it still running?): ") + e.what();
+        return false;
+    }
+
+    try {
+        std::filesystem::rename(staged, live);
+    } catch (const std::exception& e) {
+        if (!previous.empty()) std::filesystem::rename(previous, live, ec);
+        std::filesystem::remove(staging / kReadyMarker, ec);
+        error = std::string("Failed to swap in the new install: ") + e.what();
+        return false;
+    }
+    SyncPath(root, true);
+
+    std::filesystem::remove_all(staging, ec);
+    PruneVersions();
+    return true;
+}
+
+bool StagedInstall::Rollback(std::string& error) {
+    std::filesystem::path newest = NewestVersion();
+    if (newest.empty()) {
+        error = "No previous install to roll back to";
+        return false;
+    }
+
+    std::filesystem::path discarded = root / ".discarded";
+    std::error_code ec;
+    std::filesystem::remove_all(discarded, ec);
+    try {
+        if (std::filesystem::exists(live)) std::filesystem::rename(live, discarded);
+    } catch (const std::exception& e) {
+        error = std::string("Failed to move the current install aside (is it still running?): ") + e.what();
+        return false;
+    }
+
+    try {
+        std::filesystem::rename(newest, live);
+    } catch (const std::exception& e) {
+        std::filesystem::rename(discarded, live, ec);
+        error = std::string("Failed to restore the previous install: ") + e.what();
+        return false;
+    }
+    SyncPath(root, true);
+
+    std::filesystem::remove_all(discarded, ec);
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+// installs a new version without ever exposing a half-written tree. it's extracted under a
+// staging folder beside the live one, flushed to disk, then swapped in with two renames on the
+// same volume. the version it replaces is kept for rollback. a crash between the two renames is
+// repaired by Recover, so the live folder is always either the old tree or the complete new one
+class StagedInstall {
+public:
+    // the live tree is root/name, the staging folder and kept versions sit next to it under root
+    StagedInstall(const std::filesystem::path& root, const std::string& name, size_t keepVersions = 2);
+
+    // repair an interrupted commit, drop whatever an earlier attempt left in staging, start an empty one
+    bool Prepare(std::string& error);
+
+    // extract here, the new tree is expected at StagingRoot() / name
+    const std::filesystem::path& StagingRoot() const { return staging; }
+
+    // flush every staged file to disk, move the live tree to the kept versions and the staged one into its place
+    bool Commit(unsigned threadCount, std::string& error);
+
+    // make the newest kept version live again, the current tree is deleted
+    bool Rollback(std::string& error);
+
+    // live tree missing after a crash mid-commit: finish the commit if the staged tree had been
+    // flushed, otherwise bring back the newest kept version
+    bool Recover(std::string& error);
+
+private:
+    std::filesystem::path NewestVersion() const;
+    void PruneVersions();
+
+    std::filesystem::path root;
+    std::filesystem::path live;
+    std::filesystem::path staging;
+    std::filesystem::path versions;
+    std::string name;
+    size_t keepVersions;
+};
+
+// flush every file under root to disk, threadCount workers taking files in batches (0 = one per core).
+// the writes themselves stay unordered, this is the one barrier before a commit
+bool SyncDirectoryTree(const std::filesystem::path& root, unsigned threadCount, std::string& error);
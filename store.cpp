@@ -0,0 +1,238 @@
+#include "store.h"
+#include <fstream>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static int64_t ModifiedTime(const std::filesystem::path& path, std::error_code& ec) {
+    return static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+}
+
+// hardlink when the volume allows it, a plain copy otherwise (FAT, network shares)
+static bool LinkOrCopy(const std::filesystem::path& from, const std::filesystem::path& to) {
+    std::error_code ec;
+    std::filesystem::remove(to, ec);
+    std::filesystem::create_hard_link(from, to, ec);
+    if (!ec) return true;
+    ec.clear();
+    return std::filesystem::copy_file(from, to, ec) && !ec;
+}
+
+bool ContentStore::Open(const std::filesystem::path& storeRoot, std::string& error) {
+    root = storeRoot;
+    files.clear();
+    objects.clear();
+    objectsByContent.clear();
+    seen.clear();
+
+    std::error_code ec;
+    std::filesystem::create_directories(root / "objects", ec);
+    if (ec) {
+        error = "Failed to create content store: " + ec.message();
+        return false;
+    }
+
+    std::ifstream indexFile(root / "index.json");
+    if (!indexFile.is_open()) return true; // first install, empty store
+
+    try {
+        json data = json::parse(indexFile);
+        for (const auto& [sha256, item] : data["objects"].items()) {
+            ObjectRecord object;
+            object.size = item["size"].get<uint64_t>();
+            object.crc32 = item["crc32"].get<uint32_t>();
+            object.mtime = item["mtime"].get<int64_t>();
+            objectsByContent.emplace(std::make_pair(object.crc32, object.size), sha256);
+            objects.emplace(sha256, object);
+        }
+        for (const auto& [name, item] : data["files"].items()) {
+            FileRecord file;
+            file.size = item["size"].get<uint64_t>();
+            file.crc32 = item["crc32"].get<uint32_t>();
+            file.mtime = item["mtime"].get<int64_t>();
+            file.sha256 = item["sha256"].get<std::string>();
+            files.emplace(name, std::move(file));
+        }
+    } catch (const std::exception&) {
+        // a damaged index only costs us the shortcuts, the blobs get rebuilt as files are extracted
+        files.clear();
+        objects.clear();
+        objectsByContent.clear();
+    }
+    return true;
+}
+
+std::filesystem::path ContentStore::ObjectPath(const std::string& sha256) const {
+    return root / "objects" / sha256.substr(0, 2) / sha256;
+}
+
+bool ContentStore::ObjectIntact(const std::string& sha256, const ObjectRecord& object) const {
+    std::error_code ec;
+    std::filesystem::path path = ObjectPath(sha256);
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec || size != object.size) return false;
+    int64_t mtime = ModifiedTime(path, ec);
+    return !ec && mtime == object.mtime;
+}
+
+bool ContentStore::Candidate(const std::string& name, uint32_t crc32, uint64_t size) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = files.find(name);
+    if (found != files.end() && found->second.crc32 == crc32 && found->second.size == size) return true;
+    return objectsByContent.count({ crc32, size }) > 0;
+}
+
+bool ContentStore::Unchanged(const std::string& name, uint32_t crc32, uint64_t size, const std::string& sha256, const std::filesystem::path& outputPath) {
+    int64_t recordedTime = 0;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = files.find(name);
+        if (found == files.end() || found->second.crc32 != crc32 || found->second.size != size || found->second.sha256 != sha256) return false;
+        recordedTime = found->second.mtime;
+    }
+
+    std::error_code ec;
+    if (std::filesystem::file_size(outputPath, ec) != size || ec) return false;
+    if (ModifiedTime(outputPath, ec) != recordedTime || ec) return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    seen.insert(name);
+    return true;
+}
+
+bool ContentStore::LinkFromStore(const std::string& name, uint32_t crc32, uint64_t size, const std::string& sha256, const std::filesystem::path& outputPath) {
+    ObjectRecord object;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = objects.find(sha256);
+        if (found == objects.end() || found->second.crc32 != crc32 || found->second.size != size) return false;
+        object = found->second;
+    }
+
+    if (!ObjectIntact(sha256, object) || !LinkOrCopy(ObjectPath(sha256), outputPath)) return false;
+
+    std::error_code ec;
+    FileRecord file;
+    file.size = size;
+    file.crc32 = crc32;
+    file.mtime = ModifiedTime(outputPath, ec);
+    file.sha256 = sha256;
+
+    std::lock_guard<std::mutex> guard(lock);
+    files[name] = std::move(file);
+    seen.insert(name);
+    return true;
+}
+
+void ContentStore::Adopt(const std::string& name, uint32_t crc32, uint64_t size, const std::filesystem::path& outputPath, const std::string& sha256) {
+    bool haveObject = false;
+    ObjectRecord existing;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = objects.find(sha256);
+        if (found != objects.end()) {
+            existing = found->second;
+            haveObject = true;
+        }
+    }
+    haveObject = haveObject && ObjectIntact(sha256, existing);
+
+    std::error_code ec;
+    if (!haveObject) {
+        std::filesystem::path objectPath = ObjectPath(sha256);
+        std::filesystem::create_directories(objectPath.parent_path(), ec);
+        if (ec || !LinkOrCopy(outputPath, objectPath)) return; // no blob, just don't index it
+
+        ObjectRecord object;
+        object.size = size;
+        object.crc32 = crc32;
+        object.mtime = ModifiedTime(objectPath, ec);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (objects.emplace(sha256, object).second) objectsByContent.emplace(std::make_pair(crc32, size), sha256);
+        else objects[sha256] = object;
+    }
+
+    FileRecord file;
+    file.size = size;
+    file.crc32 = crc32;
+    file.mtime = ModifiedTime(outputPath, ec);
+    file.sha256 = sha256;
+
+    std::lock_guard<std::mutex> guard(lock);
+    files[name] = std::move(file);
+    seen.insert(name);
+}
+
+bool ContentStore::Commit(bool prune, std::string& error) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    try {
+        if (prune) {
+            std::unordered_set<std::string> referenced;
+            for (auto it = files.begin(); it != files.end();) {
+                if (!seen.count(it->first)) {
+                    it = files.erase(it);
+                } else {
+                    referenced.insert(it->second.sha256);
+                    ++it;
+                }
+            }
+
+            for (auto it = objects.begin(); it != objects.end();) {
+                if (referenced.count(it->first)) {
+                    ++it;
+                    continue;
+                }
+                auto range = objectsByContent.equal_range({ it->second.crc32, it->second.size });
+                for (auto byContent = range.first; byContent != range.second; ++byContent) {
+                    if (byContent->second == it->first) {
+                        objectsByContent.erase(byContent);
+                        break;
+                    }
+                }
+                it = objects.erase(it);
+            }
+
+            // sweep the objects folder itself so blobs left by an interrupted run go too
+            std::vector<std::filesystem::path> stale;
+            std::error_code ec;
+            for (const auto& bucket : std::filesystem::directory_iterator(root / "objects", ec)) {
+                for (const auto& blob : std::filesystem::directory_iterator(bucket.path(), ec)) {
+                    if (!objects.count(blob.path().filename().string())) stale.push_back(blob.path());
+                }
+            }
+            for (const std::filesystem::path& blob : stale) {
+                std::filesystem::remove(blob, ec);
+            }
+        }
+
+        json data;
+        data["objects"] = json::object();
+        data["files"] = json::object();
+        for (const auto& [sha256, object] : objects) {
+            data["objects"][sha256] = { { "size", object.size }, { "crc32", object.crc32 }, { "mtime", object.mtime } };
+        }
+        for (const auto& [name, file] : files) {
+            data["files"][name] = { { "size", file.size }, { "crc32", file.crc32 }, { "mtime", file.mtime }, { "sha256", file.sha256 } };
+        }
+
+        // same write-then-rename as the download journal, a crash never leaves half an index
+        std::filesystem::path indexPath = root / "index.json";
+        std::filesystem::path tempPath = root / "index.json.tmp";
+        {
+            std::ofstream out(tempPath, std::ios::trunc);
+            out << data.dump();
+            if (!out) {
+                error = "Failed writing content store index";
+                return false;
+            }
+        }
+        std::filesystem::rename(tempPath, indexPath);
+        return true;
+    } catch (const std::exception& e) {
+        error = std::string("Content store error: ") + e.what();
+        return false;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// content-addressed copy of every extracted file, kept next to the install so reinstalls and
+// repairs only write content that isn't there yet. blobs live under objects/<sha256> and are
+// hardlinked into the install, index.json maps each installed path to what was put there.
+// an entry's crc32 and size only say the store might hold it, its sha256 decides: crc32 is
+// easy to collide. safe to call from several extraction workers at once
+class ContentStore {
+public:
+    bool Open(const std::filesystem::path& root, std::string& error);
+
+    // a recorded file or a blob has this crc32 and size, so the entry is worth hashing for
+    // Unchanged and LinkFromStore. false means neither can succeed
+    bool Candidate(const std::string& name, uint32_t crc32, uint64_t size);
+
+    // the file at outputPath is still exactly what the entry would extract to (one lookup + one stat)
+    bool Unchanged(const std::string& name, uint32_t crc32, uint64_t size, const std::string& sha256, const std::filesystem::path& outputPath);
+
+    // put the stored blob with this sha256 at outputPath, false if the store doesn't have it
+    bool LinkFromStore(const std::string& name, uint32_t crc32, uint64_t size, const std::string& sha256, const std::filesystem::path& outputPath);
+
+    // record a freshly extracted file and keep its content as a blob
+    void Adopt(const std::string& name, uint32_t crc32, uint64_t size, const std::filesystem::path& outputPath, const std::string& sha256);
+
+    // write the index. after a complete extraction pass prune = true forgets paths that weren't
+    // seen and deletes every blob nothing references any more
+    bool Commit(bool prune, std::string& error);
+
+private:
+    struct FileRecord {
+        uint64_t size = 0;
+        uint32_t crc32 = 0;
+        int64_t mtime = 0;
+        std::string sha256;
+    };
+
+    struct ObjectRecord {
+        uint64_t size = 0;
+        uint32_t crc32 = 0;
+        int64_t mtime = 0; // a hardlinked copy edited in place changes this, so it won't be handed out again
+    };
+
+    std::filesystem::path ObjectPath(const std::string& sha256) const;
+    bool ObjectIntact(const std::string& sha256, const ObjectRecord& object) const;
+
+    std::filesystem::path root;
+    std::unordered_map<std::string, FileRecord> files;
+    std::unordered_map<std::string, ObjectRecord> objects;
+    std::multimap<std::pair<uint32_t, uint64_t>, std::string> objectsByContent; // (crc32, size) -> sha256 of each blob with it
+    std::unordered_set<std::string> seen;
+    std::mutex lock;
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+// the tests are plain executables run by ctest: a failed CHECK prints where and what, and main
+// returns CheckResult(), non-zero once anything failed
+inline int g_CheckFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++g_CheckFailures; \
+        } \
+    } while (0)
+
+// a check whose failure makes the rest of the test meaningless
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+inline int CheckResult() {
+    if (g_CheckFailures) std::fprintf(stderr, "%d check(s) failed\n", g_CheckFailures);
+    return g_CheckFailures ? 1 : 0;
+}
+
+// a fresh directory under the system temp folder, removed again with everything in it
+struct TestDirectory {
+    std::filesystem::path path;
+
+    explicit TestDirectory(const std::string& name) {
+        path = std::filesystem::temp_directory_path() / (name + "." + std::to_string(std::random_device()()));
+        std::filesystem::create_directories(path);
+    }
+
+    ~TestDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    TestDirectory(const TestDirectory&) = delete;
+    TestDirectory& operator=(const TestDirectory&) = delete;
+};
+
+// size bytes that look random and are the same for the same seed
+inline std::string TestPayload(size_t size, uint32_t seed = 1) {
+    std::string data(size, '\0');
+    uint32_t x = seed;
+    for (char& c : data) {
+        x = x * 1103515245 + 12345;
+        c = static_cast<char>(x >> 24);
+    }
+    return data;
+}
+
+inline std::string ReadTestFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
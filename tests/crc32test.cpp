@@ -0,0 +1,54 @@
+// Crc32Update against zlib's crc32 on whatever path this CPU takes: every length across the
+// 64-byte folding edges, unaligned starts, and the data fed in pieces that split the folds
+#include "check.h"
+#include "crc32.h"
+#include <zlib.h>
+#include <algorithm>
+#include <vector>
+
+static uint32_t ZlibCrc(const char* data, size_t size) {
+    return static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size)));
+}
+
+// data fed in pieces of the sizes in pattern, over and over
+static uint32_t CrcInPieces(const char* data, size_t size, const std::vector<size_t>& pattern) {
+    uint32_t crc = 0;
+    size_t pos = 0;
+    for (size_t i = 0; pos < size; ++i) {
+        size_t piece = (std::min)(pattern[i % pattern.size()], size - pos);
+        crc = Crc32Update(crc, data + pos, piece);
+        pos += piece;
+    }
+    return crc;
+}
+
+int main() {
+    printf("backend: %s\n", Crc32Backend());
+
+    CHECK(Crc32Update(0, "", 0) == 0);
+    CHECK(Crc32Update(0, "123456789", 9) == 0xCBF43926); // the check value
+    CHECK(Crc32Update(0xCBF43926, "", 0) == 0xCBF43926);
+
+    std::string data = TestPayload(1024 * 1024 + 77, 3);
+    std::vector<size_t> lengths;
+    for (size_t length = 0; length <= 520; ++length) lengths.push_back(length);
+    for (size_t length : { 1023, 1024, 1025, 4095, 4096, 4097, 65535, 65536, 65537, 1024 * 1024 + 77 }) lengths.push_back(length);
+
+    for (size_t offset : { 0, 1, 3, 8, 15 }) {
+        for (size_t length : lengths) {
+            if (offset + length > data.size()) continue;
+            const char* start = data.data() + offset;
+            uint32_t expected = ZlibCrc(start, length);
+            CHECK(Crc32Update(0, start, length) == expected);
+            CHECK(CrcInPieces(start, length, { 63, 1, 130, 7, 64 }) == expected);
+        }
+    }
+
+    // long runs of one byte, what stored zero-filled assets look like
+    for (char fill : { '\0', '\xFF' }) {
+        std::string run(300 * 1024, fill);
+        CHECK(Crc32Update(0, run.data(), run.size()) == ZlibCrc(run.data(), run.size()));
+    }
+
+    return CheckResult();
+}
@@ -0,0 +1,123 @@
+// FetchFile against the loopback server: segmented into ranges, one stream when the server has no
+// range support, resumed from its journal after an interrupted attempt, restarted when the file
+// changed in between, and FetchRange on its own
+#include "check.h"
+#include "download.h"
+#include "loopback.h"
+#include "sha256.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+
+static std::string Digest(const std::string& data) {
+    Sha256 hasher;
+    hasher.Update(data.data(), data.size());
+    return Sha256::ToHex(hasher.Final());
+}
+
+static int Run() {
+    LoopbackServer server;
+    std::string error;
+    REQUIRE(server.Start(error));
+    TestDirectory dir("downloadtest");
+    HttpClient client;
+
+    DownloadOptions options;
+    options.client = &client;
+    options.segments = 4;
+    std::atomic<float> progress = 0.0f;
+    options.progress = &progress;
+
+    // 5 MB and a bit: four ranges, the last one takes the remainder
+    std::string payload = TestPayload(5 * 1024 * 1024 + 333);
+    server.Serve("/payload.zip", payload);
+    std::string output = (dir.path / "payload.zip").string();
+    std::string sha256;
+    CHECK(FetchFile(server.Url("/payload.zip"), output, options, error, &sha256));
+    CHECK(ReadTestFile(output) == payload);
+    CHECK(sha256 == Digest(payload));
+    CHECK(server.rangeRequests == 5); // the probe and four ranges
+    CHECK(progress == 1.0f);
+    CHECK(!std::filesystem::exists(DownloadJournalPath(output)));
+
+    // below the minimum segment size the file is still one range, so it can resume
+    uint64_t before = server.rangeRequests;
+    server.Serve("/small.json", "{\"files\":[]}", "application/json");
+    std::string small = (dir.path / "small.json").string();
+    CHECK(FetchFile(server.Url("/small.json"), small, options, error));
+    CHECK(ReadTestFile(small) == "{\"files\":[]}");
+    CHECK(server.rangeRequests - before == 2);
+
+    // no range support: the probe gets a 200 and the file comes in one stream
+    server.ranges = false;
+    std::string single = (dir.path / "single.zip").string();
+    sha256.clear();
+    CHECK(FetchFile(server.Url("/payload.zip"), single, options, error, &sha256));
+    CHECK(ReadTestFile(single) == payload);
+    CHECK(sha256 == Digest(payload));
+    server.ranges = true;
+
+    // a missing file fails with the status in the message
+    CHECK(!FetchFile(server.Url("/missing.zip"), (dir.path / "missing.zip").string(), options, error));
+    CHECK(error.find("404") != std::string::npos);
+
+    // interrupted part way through: the partial file and its journal stay ...
+    server.bytesPerSec = 1024 * 1024;
+    DownloadOptions interrupted = options;
+    interrupted.request.cancel = std::make_shared<std::atomic<bool>>(false);
+    std::thread canceller([cancel = interrupted.request.cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        *cancel = true;
+    });
+    std::string resumed = (dir.path / "resumed.zip").string();
+    CHECK(!FetchFile(server.Url("/payload.zip"), resumed, interrupted, error));
+    canceller.join();
+    CHECK(std::filesystem::exists(DownloadJournalPath(resumed)));
+
+    // ... and the next attempt only fetches what's missing
+    server.bytesPerSec = 0;
+    uint64_t sent = server.bodyBytes;
+    sha256.clear();
+    CHECK(FetchFile(server.Url("/payload.zip"), resumed, options, error, &sha256));
+    CHECK(ReadTestFile(resumed) == payload);
+    CHECK(sha256 == Digest(payload));
+    CHECK(server.bodyBytes - sent < payload.size() - 1024 * 1024);
+    CHECK(!std::filesystem::exists(DownloadJournalPath(resumed)));
+
+    // the file changed between attempts: its new ETag throws the journal away
+    server.bytesPerSec = 1024 * 1024;
+    interrupted.request.cancel = std::make_shared<std::atomic<bool>>(false);
+    std::thread second([cancel = interrupted.request.cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        *cancel = true;
+    });
+    std::string changed = (dir.path / "changed.zip").string();
+    CHECK(!FetchFile(server.Url("/payload.zip"), changed, interrupted, error));
+    second.join();
+    server.bytesPerSec = 0;
+    std::string update = TestPayload(payload.size(), 2);
+    server.Serve("/payload.zip", update);
+    CHECK(FetchFile(server.Url("/payload.zip"), changed, options, error));
+    CHECK(ReadTestFile(changed) == update);
+
+    // one range into an open file, at its position
+    std::string patched = (dir.path / "patched.bin").string();
+    { std::ofstream create(patched, std::ios::binary); create << std::string(100, '-'); }
+    FILE* fp = std::fopen(patched.c_str(), "r+b");
+    REQUIRE(fp);
+    curl_off_t written = 0;
+    std::fseek(fp, 10, SEEK_SET);
+    CHECK(FetchRange(server.Url("/payload.zip"), 1000, 1049, fp, options, written));
+    std::fclose(fp);
+    CHECK(written == 50);
+    CHECK(ReadTestFile(patched) == std::string(10, '-') + update.substr(1000, 50) + std::string(40, '-'));
+
+    server.Stop();
+    return CheckResult();
+}
+
+int main() {
+    int result = Run();
+    HttpPoolShutdown();
+    return result;
+}
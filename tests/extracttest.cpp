@@ -0,0 +1,113 @@
+// ExtractZipParallel on generated archives: the tree comes out the same on one worker and on many,
+// a name listed twice is written once with the last entry's data, and a corrupt entry, an unsafe
+// name or a file that isn't a zip fail with an error
+#include "check.h"
+#include "extract.h"
+#include "zipwriter.h"
+#include <map>
+
+static void WriteTestFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+static bool TreeMatches(const std::filesystem::path& root, const std::map<std::string, std::string>& files) {
+    for (const auto& file : files) {
+        if (ReadTestFile(root / file.first) != file.second) {
+            fprintf(stderr, "mismatch in %s\n", file.first.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    TestDirectory dir("extracttest");
+
+    // a few hundred small files in nested folders and two big ones, stored and deflated
+    std::map<std::string, std::string> files;
+    ZipWriter zip;
+    zip.AddDirectory("assets/");
+    zip.AddDirectory("assets/empty/");
+    for (int i = 0; i < 300; ++i) {
+        std::string name = "assets/" + std::to_string(i % 7) + "/file" + std::to_string(i) + ".txt";
+        files[name] = std::string(static_cast<size_t>(i * 13), static_cast<char>('a' + i % 26)) + TestPayload(i % 50, i);
+    }
+    files["bin/VelocityX.exe"] = TestPayload(3 * 1024 * 1024, 7);
+    files["bin/resources.pak"] = std::string(5 * 1024 * 1024, 'p');
+    int i = 0;
+    for (const auto& file : files) {
+        ZipWriter::EntryOptions options;
+        options.deflate = i++ % 4 != 0;
+        zip.Add(file.first, file.second, options);
+    }
+    std::filesystem::path archive = dir.path / "release.zip";
+    WriteTestFile(archive, zip.Finish());
+
+    std::string error;
+    for (unsigned threads : { 1u, 4u, 0u }) {
+        std::filesystem::path out = dir.path / ("out" + std::to_string(threads));
+        CHECK(ExtractZipParallel(archive.string(), out.string(), threads, error));
+        CHECK(error.empty());
+        CHECK(TreeMatches(out, files));
+        CHECK(std::filesystem::is_directory(out / "assets" / "empty"));
+    }
+
+    // the small files through io_uring where the kernel takes it, the same tree either way
+    {
+        std::filesystem::path out = dir.path / "uring";
+        CHECK(ExtractZipParallel(archive.string(), out.string(), 2, error, nullptr, ExtractIo::IoUring));
+        CHECK(error.empty());
+        CHECK(TreeMatches(out, files));
+    }
+
+    // the same name twice, and once more spelled with a redundant "./": the last one wins
+    {
+        ZipWriter duplicates;
+        duplicates.Add("config.json", "{\"version\":1}");
+        duplicates.Add("other.txt", "other");
+        duplicates.Add("config.json", "{\"version\":2}");
+        duplicates.Add("./config.json", "{\"version\":3}");
+        std::filesystem::path path = dir.path / "duplicates.zip";
+        WriteTestFile(path, duplicates.Finish());
+        std::filesystem::path out = dir.path / "duplicates";
+        CHECK(ExtractZipParallel(path.string(), out.string(), 4, error));
+        CHECK(ReadTestFile(out / "config.json") == "{\"version\":3}");
+        CHECK(ReadTestFile(out / "other.txt") == "other");
+    }
+
+    // a flipped byte in deflated data is a failed inflate or a crc mismatch, either way an error
+    {
+        ZipWriter corrupt;
+        corrupt.Add("data.bin", TestPayload(20000, 9));
+        std::string bytes = corrupt.Finish();
+        bytes[30 + 8 + 5000] ^= 0x01;
+        std::filesystem::path path = dir.path / "corrupt.zip";
+        WriteTestFile(path, bytes);
+        error.clear();
+        CHECK(!ExtractZipParallel(path.string(), (dir.path / "corrupt").string(), 2, error));
+        CHECK(!error.empty());
+    }
+
+    {
+        ZipWriter unsafe;
+        unsafe.Add("ok.txt", "fine");
+        unsafe.Add("../../escape.txt", "nope");
+        std::filesystem::path path = dir.path / "unsafe.zip";
+        WriteTestFile(path, unsafe.Finish());
+        error.clear();
+        CHECK(!ExtractZipParallel(path.string(), (dir.path / "unsafe").string(), 2, error));
+        CHECK(!error.empty());
+        CHECK(!std::filesystem::exists(dir.path / "escape.txt"));
+    }
+
+    {
+        std::filesystem::path path = dir.path / "notazip.zip";
+        WriteTestFile(path, std::string(4096, 'x'));
+        error.clear();
+        CHECK(!ExtractZipParallel(path.string(), (dir.path / "notazip").string(), 2, error));
+        CHECK(!error.empty());
+    }
+
+    return CheckResult();
+}
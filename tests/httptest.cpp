@@ -0,0 +1,118 @@
+// the portable HTTP client against the loopback server: every kind of request the launcher makes
+// (GET JSON, ranged GET, HEAD, PUT), each checked for status, headers and body
+#include "check.h"
+#include "http.h"
+#include "loopback.h"
+#include <nlohmann/json.hpp>
+#include <future>
+#include <string>
+#include <vector>
+
+static HttpRequest Get(const std::string& url) {
+    HttpRequest request;
+    request.url = url;
+    return request;
+}
+
+static int Run() {
+    LoopbackServer server;
+    std::string error;
+    REQUIRE(server.Start(error));
+
+    std::string payload = TestPayload(3 * 1024 * 1024 + 17);
+    server.Serve("/payload.zip", payload);
+    server.Serve("/api/key", "{\"valid\":true,\"expires\":1700000000}", "application/json");
+    HttpClient client;
+
+    // GET JSON, parsed straight out of the response
+    HttpResponse json = client.Fetch(Get(server.Url("/api/key?token=abc")));
+    CHECK(json.Ok() && json.status == 200);
+    CHECK(json.Header("Content-Type") == "application/json");
+    nlohmann::json parsed = nlohmann::json::parse(json.Body(), nullptr, false);
+    CHECK(!parsed.is_discarded() && parsed["valid"] == true);
+
+    // HttpGetString on the default client
+    std::string body;
+    long status = 0;
+    CHECK(HttpGetString(server.Url("/api/key"), body, status, error) && status == 200 && body == json.body);
+
+    // whole file, then ranges at the start, the middle, the end and past it
+    HttpResponse whole = client.Fetch(Get(server.Url("/payload.zip")));
+    CHECK(whole.status == 200 && whole.body == payload);
+    CHECK(whole.Header("Accept-Ranges") == "bytes" && !whole.Header("ETag").empty());
+
+    HttpRequest first = Get(server.Url("/payload.zip"));
+    first.range = "0-0";
+    HttpResponse probe = client.Fetch(first);
+    CHECK(probe.status == 206 && probe.body == payload.substr(0, 1));
+    CHECK(probe.Header("Content-Range") == "bytes 0-0/" + std::to_string(payload.size()));
+
+    HttpRequest middle = Get(server.Url("/payload.zip"));
+    middle.range = "1000000-1999999";
+    HttpResponse slice = client.Fetch(middle);
+    CHECK(slice.status == 206 && slice.body == payload.substr(1000000, 1000000));
+
+    HttpRequest tail = Get(server.Url("/payload.zip"));
+    tail.range = "3000000-";
+    HttpResponse end = client.Fetch(tail);
+    CHECK(end.status == 206 && end.body == payload.substr(3000000));
+
+    HttpRequest past = Get(server.Url("/payload.zip"));
+    past.range = std::to_string(payload.size()) + "-";
+    CHECK(client.Fetch(past).status == 416);
+
+    // a stale If-Range validator gets the whole file instead of a slice of a different one
+    HttpRequest stale = Get(server.Url("/payload.zip"));
+    stale.range = "10-19";
+    stale.headers.push_back("If-Range: \"not-the-etag\"");
+    HttpResponse full = client.Fetch(stale);
+    CHECK(full.status == 200 && full.body.size() == payload.size());
+
+    HttpRequest current = Get(server.Url("/payload.zip"));
+    current.range = "10-19";
+    current.headers.push_back("If-Range: " + whole.Header("ETag"));
+    CHECK(client.Fetch(current).body == payload.substr(10, 10));
+
+    // a server without range support answers 200 with everything
+    server.ranges = false;
+    HttpResponse ignored = client.Fetch(first);
+    CHECK(ignored.status == 200 && ignored.body.size() == payload.size());
+    server.ranges = true;
+
+    // HEAD: the length the GET would have, no body
+    HttpRequest head = Get(server.Url("/payload.zip"));
+    head.method = "HEAD";
+    HttpResponse headers = client.Fetch(head);
+    CHECK(headers.Ok() && headers.status == 200 && headers.body.empty());
+    CHECK(headers.Header("Content-Length") == std::to_string(payload.size()));
+
+    // PUT, then read it back
+    HttpRequest put = Get(server.Url("/v1/keys/abc"));
+    put.method = "PUT";
+    put.body = "203.0.113.7";
+    CHECK(client.Fetch(put).status == 201);
+    CHECK(server.Stored("/v1/keys/abc") == "203.0.113.7");
+    CHECK(client.Fetch(Get(server.Url("/v1/keys/abc"))).body == "203.0.113.7");
+
+    CHECK(client.Fetch(Get(server.Url("/missing"))).status == 404);
+
+    // many requests at once on one client, all answered and in one piece
+    std::vector<std::future<HttpResponse>> pending;
+    for (int i = 0; i < 64; ++i) {
+        HttpRequest request = Get(server.Url("/payload.zip"));
+        request.range = std::to_string(i * 4096) + "-" + std::to_string(i * 4096 + 4095);
+        pending.push_back(client.Send(request));
+    }
+    for (int i = 0; i < 64; ++i) {
+        CHECK(pending[i].get().body == payload.substr(i * 4096, 4096));
+    }
+
+    server.Stop();
+    return CheckResult();
+}
+
+int main() {
+    int result = Run();
+    HttpPoolShutdown(); // the clients are gone, the pool goes last
+    return result;
+}
@@ -0,0 +1,82 @@
+// Inflater on both paths against zlib's deflate: Whole at the exact size, the wrong size either
+// way, cut-short and invalid streams; Step with tiny and uneven buffers on both sides, reused
+// across entries the way an extraction worker reuses it
+#include "check.h"
+#include "inflater.h"
+#include "zipwriter.h"
+#include <algorithm>
+#include <vector>
+
+static const unsigned char* Bytes(const std::string& data) {
+    return reinterpret_cast<const unsigned char*>(data.data());
+}
+
+// inflate compressed through Step, the input handed over inChunk bytes at a time and the output
+// taken outChunk bytes at a time. false unless it ends in Done
+static bool StepAll(Inflater& inflater, const std::string& compressed, size_t inChunk, size_t outChunk, std::string& out) {
+    out.clear();
+    if (!inflater.Begin()) return false;
+    std::vector<unsigned char> buffer(outChunk);
+    size_t pos = 0;
+    size_t available = 0; // how much of compressed has been handed over so far
+    for (int idle = 0; idle < 3;) {
+        available = (std::min)(compressed.size(), (std::max)(available, pos + inChunk));
+        size_t consumed = 0;
+        size_t produced = 0;
+        InflateResult result = inflater.Step(Bytes(compressed) + pos, available - pos, consumed, buffer.data(), buffer.size(), produced);
+        pos += consumed;
+        out.append(reinterpret_cast<const char*>(buffer.data()), produced);
+        if (result == InflateResult::Done) return true;
+        if (result != InflateResult::More) return false;
+        idle = consumed == 0 && produced == 0 && available == compressed.size() ? idle + 1 : 0;
+    }
+    return false; // all input in and nothing moves: cut short
+}
+
+int main() {
+    printf("whole: %s, stream: %s\n", Inflater::WholeBackend(), Inflater::StreamBackend());
+
+    std::string text;
+    for (int line = 0; text.size() < 3 * 1024 * 1024; ++line) text += "local value_" + std::to_string(line % 977) + " = nil\n";
+    std::vector<std::string> samples = { "", "x", TestPayload(100 * 1024, 1), text, std::string(5 * 1024 * 1024, '\0') };
+
+    Inflater inflater;
+    for (const std::string& sample : samples) {
+        for (int level : { 1, 6, 9 }) {
+            std::string compressed = ZipWriter::Deflate(sample, level);
+
+            std::vector<unsigned char> out(sample.size() + 1);
+            CHECK(inflater.Whole(Bytes(compressed), compressed.size(), out.data(), sample.size()) == InflateResult::Done);
+            CHECK(std::equal(sample.begin(), sample.end(), out.begin(), [](char a, unsigned char b) { return static_cast<unsigned char>(a) == b; }));
+            CHECK(inflater.Whole(Bytes(compressed), compressed.size(), out.data(), sample.size() + 1) == InflateResult::WrongSize);
+            if (!sample.empty()) {
+                CHECK(inflater.Whole(Bytes(compressed), compressed.size(), out.data(), sample.size() - 1) == InflateResult::WrongSize);
+                CHECK(inflater.Whole(Bytes(compressed), compressed.size() / 2, out.data(), sample.size()) != InflateResult::Done);
+            }
+
+            std::string streamed;
+            CHECK(StepAll(inflater, compressed, 1 << 20, 64 * 1024, streamed) && streamed == sample);
+            if (sample.size() <= 100 * 1024) {
+                CHECK(StepAll(inflater, compressed, 1, 1, streamed) && streamed == sample);
+                CHECK(StepAll(inflater, compressed, 7, 4093, streamed) && streamed == sample);
+            }
+            if (compressed.size() > 2) {
+                CHECK(!StepAll(inflater, compressed.substr(0, compressed.size() / 2), 4096, 4096, streamed));
+            }
+        }
+    }
+
+    // a final block of the reserved type 3 is never valid deflate
+    std::string invalid(65, '\x55');
+    invalid[0] = '\x07';
+    unsigned char out[256];
+    CHECK(inflater.Whole(Bytes(invalid), invalid.size(), out, sizeof(out)) == InflateResult::Corrupt);
+    std::string streamed;
+    CHECK(!StepAll(inflater, invalid, 64, 256, streamed));
+
+    // and the inflater still works after a failure
+    std::string compressed = ZipWriter::Deflate(text);
+    CHECK(StepAll(inflater, compressed, 4096, 4096, streamed) && streamed == text);
+
+    return CheckResult();
+}
@@ -0,0 +1,119 @@
+// VerifyLicenseToken against tokens signed here with a fixed Ed25519 keypair: a good one, one for
+// another key or signed by another server, expired, issued just ahead of a slow clock and too far
+// ahead, a tampered signature or field, and text that isn't a token at all
+#include "check.h"
+#include "license.h"
+#include <sodium.h>
+#include <array>
+#include <vector>
+
+struct Signer {
+    std::array<unsigned char, crypto_sign_PUBLICKEYBYTES> publicKey;
+    std::array<unsigned char, crypto_sign_SECRETKEYBYTES> secretKey;
+
+    explicit Signer(unsigned char seedByte) {
+        std::array<unsigned char, crypto_sign_SEEDBYTES> seed;
+        for (size_t i = 0; i < seed.size(); ++i) seed[i] = static_cast<unsigned char>(seedByte + i);
+        crypto_sign_seed_keypair(publicKey.data(), secretKey.data(), seed.data());
+    }
+
+    std::string PublicKeyHex() const { return Hex(publicKey.data(), publicKey.size()); }
+
+    std::string Sign(const std::string& key, int64_t issuedAt, int64_t expiresAt) const {
+        LicenseToken token;
+        token.keyHash = LicenseKeyHash(key);
+        token.issuedAt = issuedAt;
+        token.expiresAt = expiresAt;
+        std::string message = token.SignedPart();
+        std::array<unsigned char, crypto_sign_BYTES> signature;
+        crypto_sign_detached(signature.data(), nullptr, reinterpret_cast<const unsigned char*>(message.data()), message.size(), secretKey.data());
+        return message + "." + Hex(signature.data(), signature.size());
+    }
+
+    static std::string Hex(const unsigned char* data, size_t size) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (size_t i = 0; i < size; ++i) {
+            hex += digits[data[i] >> 4];
+            hex += digits[data[i] & 15];
+        }
+        return hex;
+    }
+};
+
+// "ok" when the token verifies, the error otherwise
+static std::string Verify(const std::string& text, const std::string& key, const std::string& publicKey, int64_t now) {
+    std::string error;
+    return VerifyLicenseToken(text, key, publicKey, now, error) ? "ok" : error;
+}
+
+int main() {
+    REQUIRE(sodium_init() >= 0);
+    const std::string key = "VX-8F2K-Q7ZD";
+    const int64_t now = 1760000000;
+    const int64_t day = 24 * 60 * 60;
+    Signer server(1);
+    Signer other(101);
+    std::string publicKey = server.PublicKeyHex();
+
+    // good, and still good up to the last second of its lifetime
+    std::string good = server.Sign(key, now - day, now + 30 * day);
+    CHECK(Verify(good, key, publicKey, now) == "ok");
+    CHECK(Verify(good, key, publicKey, now + 30 * day - 1) == "ok");
+    LicenseToken parsed;
+    CHECK(ParseLicenseToken(good, parsed) && parsed.keyHash == LicenseKeyHash(key) && parsed.issuedAt == now - day && parsed.expiresAt == now + 30 * day);
+
+    // for another key, signed by another server, or checked against the wrong public key
+    CHECK(Verify(good, "VX-0000-0000", publicKey, now) == "License token belongs to a different key");
+    CHECK(Verify(other.Sign(key, now - day, now + 30 * day), key, publicKey, now) == "License token signature is invalid");
+    CHECK(Verify(good, key, other.PublicKeyHex(), now) == "License token signature is invalid");
+    CHECK(Verify(good, key, "", now) == "No license public key configured");
+    CHECK(Verify(good, key, publicKey.substr(2), now) == "No license public key configured");
+
+    // expired: from expiresAt on
+    CHECK(Verify(good, key, publicKey, now + 30 * day) == "License token expired");
+    CHECK(Verify(server.Sign(key, now - 2 * day, now - day), key, publicKey, now) == "License token expired");
+
+    // a clock up to five minutes behind the server's still takes a fresh token, further behind doesn't
+    CHECK(Verify(server.Sign(key, now + 60, now + day), key, publicKey, now) == "ok");
+    CHECK(Verify(server.Sign(key, now + 5 * 60, now + day), key, publicKey, now) == "ok");
+    CHECK(Verify(server.Sign(key, now + 5 * 60 + 1, now + day), key, publicKey, now) == "License token is not valid yet, check the system clock");
+
+    // tampered: one signature digit, or a field the signature covers
+    std::string flipped = good;
+    flipped.back() = flipped.back() == '0' ? '1' : '0';
+    CHECK(Verify(flipped, key, publicKey, now) == "License token signature is invalid");
+    std::string extended = good;
+    size_t expires = extended.find(std::to_string(now + 30 * day));
+    REQUIRE(expires != std::string::npos);
+    extended.replace(expires, std::to_string(now + 30 * day).size(), std::to_string(now + 3650 * day));
+    CHECK(Verify(extended, key, publicKey, now) == "License token signature is invalid");
+
+    // malformed
+    std::string signedPart = good.substr(0, good.rfind('.'));
+    std::string signature = good.substr(good.rfind('.') + 1);
+    for (const std::string& text : {
+             std::string(),
+             std::string("not a token"),
+             signedPart,
+             good + ".00",
+             "v2" + good.substr(2),
+             "v1.abc." + std::to_string(now) + "." + std::to_string(now + day) + "." + signature,
+             "v1." + LicenseKeyHash(key) + ".-5." + std::to_string(now + day) + "." + signature,
+             "v1." + LicenseKeyHash(key) + ".." + std::to_string(now + day) + "." + signature,
+             signedPart + "." + signature.substr(2),
+             signedPart + "." + std::string(signature.size(), 'z'),
+         }) {
+        CHECK(Verify(text, key, publicKey, now) == "Malformed license token");
+    }
+
+    // the stored copy comes back as it went in, without the newline
+    TestDirectory dir("licensetest");
+    std::filesystem::path path = dir.path / "license.token";
+    CHECK(LoadLicenseToken(path).empty());
+    CHECK(SaveLicenseToken(path, good));
+    CHECK(LoadLicenseToken(path) == good);
+    CHECK(Verify(LoadLicenseToken(path), key, publicKey, now) == "ok");
+
+    return CheckResult();
+}
@@ -0,0 +1,170 @@
+// KeyRegistry's compare-and-set and its log file: bindings survive a reopen, a torn or corrupt last
+// record is cut off, a file that isn't a registry is refused, racing binds of one key have exactly
+// one winner. then the HTTP interface end to end through LocalKeyRegistry and KeyRegistryClient
+#include "check.h"
+#include "http.h"
+#include "registry.h"
+#include "registryclient.h"
+#include "sha256.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static std::string KeyHash(const std::string& key) {
+    Sha256 hasher;
+    hasher.Update(key.data(), key.size());
+    return Sha256::ToHex(hasher.Final());
+}
+
+static BindResult Bind(KeyRegistry& registry, const std::string& key, const std::string& binding, std::string& current) {
+    std::string error;
+    current.clear();
+    return registry.Bind(KeyHash(key), binding, current, error);
+}
+
+static void AppendBytes(const std::filesystem::path& path, const std::string& bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::app).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+static int Run() {
+    TestDirectory dir("registrytest");
+    std::filesystem::path path = dir.path / "data" / "keys.krg";
+    std::string error, current, binding;
+
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(path, error));
+        CHECK(Bind(registry, "VX-AAAA", "10.0.0.1", current) == BindResult::Bound && current == "10.0.0.1");
+        CHECK(Bind(registry, "VX-AAAA", "10.0.0.1", current) == BindResult::AlreadyBound && current == "10.0.0.1");
+        CHECK(Bind(registry, "VX-AAAA", "10.0.0.2", current) == BindResult::Conflict && current == "10.0.0.1");
+        CHECK(Bind(registry, "VX-BBBB", "HWID-1234", current) == BindResult::Bound);
+        CHECK(registry.Lookup(KeyHash("VX-AAAA"), binding) && binding == "10.0.0.1");
+        CHECK(!registry.Lookup(KeyHash("VX-NONE"), binding));
+
+        // a hash that isn't 64 hex digits, a binding that's empty, too long or not printable
+        CHECK(registry.Bind("abc", "10.0.0.1", current, error) == BindResult::Rejected);
+        CHECK(registry.Bind(std::string(63, 'a') + "g", "10.0.0.1", current, error) == BindResult::Rejected);
+        CHECK(Bind(registry, "VX-CCCC", "", current) == BindResult::Rejected);
+        CHECK(Bind(registry, "VX-CCCC", std::string(KeyRegistry::kMaxBinding + 1, 'x'), current) == BindResult::Rejected);
+        CHECK(Bind(registry, "VX-CCCC", "10.0.0.1 x", current) == BindResult::Rejected);
+        CHECK(Bind(registry, "VX-CCCC", std::string(KeyRegistry::kMaxBinding, 'x'), current) == BindResult::Bound);
+        CHECK(registry.Size() == 3);
+    }
+    uintmax_t threeRecords = std::filesystem::file_size(path);
+
+    // everything comes back from the log, and a reopened registry still refuses to rebind
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(path, error));
+        CHECK(registry.Size() == 3);
+        CHECK(registry.Lookup(KeyHash("VX-BBBB"), binding) && binding == "HWID-1234");
+        CHECK(registry.Lookup(KeyHash("VX-CCCC"), binding) && binding == std::string(KeyRegistry::kMaxBinding, 'x'));
+        CHECK(Bind(registry, "VX-AAAA", "10.0.0.9", current) == BindResult::Conflict && current == "10.0.0.1");
+    }
+
+    // half a record, as a crash mid-write leaves it: cut off, and the next bind lands cleanly after
+    AppendBytes(path, std::string(50, '\x01'));
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(path, error));
+        CHECK(registry.Size() == 3);
+        CHECK(std::filesystem::file_size(path) == threeRecords);
+        CHECK(Bind(registry, "VX-DDDD", "10.0.0.4", current) == BindResult::Bound);
+    }
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(path, error));
+        CHECK(registry.Size() == 4);
+        CHECK(registry.Lookup(KeyHash("VX-DDDD"), binding) && binding == "10.0.0.4");
+    }
+
+    // a whole last record whose crc doesn't match is as good as torn
+    {
+        std::string bytes = ReadTestFile(path);
+        bytes[bytes.size() - 60] ^= 0x20;
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        KeyRegistry registry;
+        REQUIRE(registry.Open(path, error));
+        CHECK(registry.Size() == 3);
+        CHECK(!registry.Lookup(KeyHash("VX-DDDD"), binding));
+        CHECK(std::filesystem::file_size(path) == threeRecords);
+    }
+
+    {
+        std::filesystem::path other = dir.path / "other.json";
+        AppendBytes(other, "{\"keys\":{}}");
+        KeyRegistry registry;
+        error.clear();
+        CHECK(!registry.Open(other, error));
+        CHECK(error.find("Not a key registry") != std::string::npos);
+        CHECK(ReadTestFile(other) == "{\"keys\":{}}");
+    }
+
+    // eight machines activating the same keys at once: each key goes to exactly one of them
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(dir.path / "race.krg", error));
+        const int machines = 8;
+        const int keys = 500;
+        std::atomic<int> bound = 0, conflicts = 0;
+        std::vector<std::thread> threads;
+        for (int machine = 0; machine < machines; ++machine) {
+            threads.emplace_back([&, machine]() {
+                for (int key = 0; key < keys; ++key) {
+                    std::string seen;
+                    BindResult result = Bind(registry, "VX-" + std::to_string(key), "HWID-" + std::to_string(machine), seen);
+                    if (result == BindResult::Bound) ++bound;
+                    if (result == BindResult::Conflict) ++conflicts;
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        CHECK(bound == keys);
+        CHECK(conflicts == keys * (machines - 1));
+        CHECK(registry.Size() == keys);
+    }
+    {
+        KeyRegistry registry;
+        REQUIRE(registry.Open(dir.path / "race.krg", error));
+        CHECK(registry.Size() == 500);
+    }
+
+    // the service over HTTP, the way the launcher activates
+    LocalKeyRegistry service;
+    REQUIRE(service.Start(error));
+    HttpClient http;
+    KeyRegistryClient client(service.Url(), http);
+    CHECK(client.Bind("VX-WEB1", "192.168.1.10", current, error) == BindResult::Bound && current == "192.168.1.10");
+    CHECK(client.Bind("VX-WEB1", "192.168.1.10", current, error) == BindResult::AlreadyBound);
+    CHECK(client.Bind("VX-WEB1", "192.168.1.11", current, error) == BindResult::Conflict && current == "192.168.1.10");
+    CHECK(client.Bind("VX-WEB2", "not printable\n", current, error) == BindResult::Rejected);
+    CHECK(service.registry.Lookup(KeyHash("VX-WEB1"), binding) && binding == "192.168.1.10");
+
+    HttpRequest request;
+    request.url = service.Url() + "/v1/keys/" + KeyHash("VX-WEB1");
+    HttpResponse response = http.Fetch(request);
+    CHECK(response.status == 200 && response.body == "192.168.1.10");
+    request.url = service.Url() + "/v1/keys/" + KeyHash("VX-WEB2");
+    CHECK(http.Fetch(request).status == 404);
+    request.url = service.Url() + "/health";
+    response = http.Fetch(request);
+    CHECK(response.status == 200 && response.body == "ok 1\n");
+    request.url = service.Url() + "/v1/keys/" + KeyHash("VX-WEB1");
+    request.method = "DELETE";
+    CHECK(http.Fetch(request).status == 405);
+    service.Stop();
+
+    // nobody listening is a failure to report, not a verdict
+    KeyRegistryClient unreachable(service.Url(), http);
+    error.clear();
+    CHECK(unreachable.Bind("VX-WEB3", "10.0.0.1", current, error) == BindResult::Failed);
+    CHECK(!error.empty());
+
+    return CheckResult();
+}
+
+int main() {
+    int result = Run();
+    HttpPoolShutdown();
+    return result;
+}
@@ -0,0 +1,85 @@
+// Sha256 on every backend this CPU runs: the published test vectors, the block-boundary lengths,
+// and random data fed whole and split at every kind of place has to give the same digest each way.
+// Sha256File agrees with hashing the bytes in memory
+#include "check.h"
+#include "sha256.h"
+#include <algorithm>
+#include <vector>
+
+static std::string Digest(Sha256::Backend backend, const std::string& data) {
+    Sha256 hasher(backend);
+    hasher.Update(data.data(), data.size());
+    return Sha256::ToHex(hasher.Final());
+}
+
+// data fed in pieces of the sizes in pattern, over and over
+static std::string DigestInPieces(Sha256::Backend backend, const std::string& data, const std::vector<size_t>& pattern) {
+    Sha256 hasher(backend);
+    size_t pos = 0;
+    for (size_t i = 0; pos < data.size(); ++i) {
+        size_t piece = (std::min)(pattern[i % pattern.size()], data.size() - pos);
+        hasher.Update(data.data() + pos, piece);
+        pos += piece;
+    }
+    return Sha256::ToHex(hasher.Final());
+}
+
+int main() {
+    std::vector<Sha256::Backend> backends = { Sha256::Backend::Portable };
+    if (Sha256::Supported(Sha256::Backend::ShaNi)) backends.push_back(Sha256::Backend::ShaNi);
+    for (Sha256::Backend backend : backends) printf("backend: %s\n", Sha256::BackendName(backend));
+
+    // FIPS 180-2 and the usual extras
+    struct Vector {
+        std::string data;
+        const char* digest;
+    };
+    const Vector vectors[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "The quick brown fox jumps over the lazy dog", "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592" },
+        { std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    };
+    for (Sha256::Backend backend : backends) {
+        for (const Vector& vector : vectors) {
+            CHECK(Digest(backend, vector.data) == vector.digest);
+            CHECK(DigestInPieces(backend, vector.data, { 1 }) == vector.digest);
+        }
+    }
+
+    // every length around the 55/56/64-byte padding edges and a few blocks past them, then bigger
+    // ones, each backend against the portable one and fed in odd pieces
+    std::string data = TestPayload(300 * 1024 + 17, 5);
+    std::vector<size_t> lengths;
+    for (size_t length = 0; length <= 200; ++length) lengths.push_back(length);
+    for (size_t length : { 447, 448, 511, 512, 513, 4095, 4096, 4097, 65536 + 3, 300 * 1024 + 17 }) lengths.push_back(length);
+    for (size_t length : lengths) {
+        std::string slice = data.substr(0, length);
+        std::string expected = Digest(Sha256::Backend::Portable, slice);
+        for (Sha256::Backend backend : backends) {
+            CHECK(Digest(backend, slice) == expected);
+            CHECK(DigestInPieces(backend, slice, { 63, 1, 65, 128, 7 }) == expected);
+            CHECK(DigestInPieces(backend, slice, { 64 }) == expected);
+        }
+    }
+
+    // the same bytes at every offset into a buffer, so the block loads aren't always aligned
+    for (Sha256::Backend backend : backends) {
+        std::string expected = Digest(Sha256::Backend::Portable, data.substr(0, 4096));
+        for (size_t offset = 1; offset < 16; ++offset) {
+            std::string shifted = std::string(offset, '\0') + data.substr(0, 4096);
+            Sha256 hasher(backend);
+            hasher.Update(shifted.data() + offset, 4096);
+            CHECK(Sha256::ToHex(hasher.Final()) == expected);
+        }
+    }
+
+    TestDirectory dir("sha256test");
+    std::filesystem::path path = dir.path / "payload.bin";
+    std::ofstream(path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+    CHECK(Sha256File(path) == Digest(Sha256::Backend::Portable, data));
+    CHECK(Sha256File(dir.path / "missing.bin").empty());
+
+    return CheckResult();
+}
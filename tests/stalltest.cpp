@@ -0,0 +1,76 @@
+// stall handling against a loopback server that caps every connection and hangs one answer
+// midway without closing it: the watchdog has to notice from the falling rate, and FetchFile has
+// to reconnect for just that range's missing bytes while the other ranges finish. takes the
+// watchdog's real stall window, about a quarter of a minute
+#include "check.h"
+#include "download.h"
+#include "loopback.h"
+#include "sha256.h"
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string Digest(const std::string& data) {
+    Sha256 hasher;
+    hasher.Update(data.data(), data.size());
+    return Sha256::ToHex(hasher.Final());
+}
+
+static double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static int Run() {
+    LoopbackServer server;
+    std::string error;
+    REQUIRE(server.Start(error));
+    TestDirectory dir("stalltest");
+    HttpClient client;
+
+    // a short hang is sat out: the answer arrives whole, just late
+    {
+        server.Serve("/short.bin", TestPayload(200 * 1024, 1));
+        server.stallAfter = 64 * 1024;
+        server.stallMs = 400;
+        HttpRequest request;
+        request.url = server.Url("/short.bin");
+        Clock::time_point start = Clock::now();
+        HttpResponse response = client.Fetch(request);
+        CHECK(response.Ok() && response.body == TestPayload(200 * 1024, 1));
+        CHECK(SecondsSince(start) >= 0.4);
+        CHECK(server.stalls == 1);
+    }
+
+    // four 4 MB ranges at 4 MB/s each, one of them hangs for a minute half a second in
+    std::string payload = TestPayload(16 * 1024 * 1024, 2);
+    server.Serve("/payload.zip", payload);
+    server.bytesPerSec = 4 * 1024 * 1024;
+    server.stallAfter = 2 * 1024 * 1024;
+    server.stallMs = 60000;
+    uint64_t before = server.rangeRequests;
+
+    DownloadOptions options;
+    options.client = &client;
+    options.segments = 4;
+    std::string output = (dir.path / "payload.zip").string();
+    std::string sha256;
+    Clock::time_point start = Clock::now();
+    CHECK(FetchFile(server.Url("/payload.zip"), output, options, error, &sha256));
+    double seconds = SecondsSince(start);
+    printf("stalled range recovered in %.1f s\n", seconds);
+    CHECK(error.empty());
+    CHECK(sha256 == Digest(payload));
+    CHECK(ReadTestFile(output) == payload);
+    CHECK(server.stalls == 2);
+    CHECK(server.rangeRequests - before == 6); // the probe, four ranges, and the stalled one again
+    CHECK(seconds < 45.0); // well before the hang would have ended on its own
+
+    server.Stop();
+    return CheckResult();
+}
+
+int main() {
+    int result = Run();
+    HttpPoolShutdown();
+    return result;
+}
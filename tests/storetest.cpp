@@ -0,0 +1,159 @@
+// ContentStore behind ExtractZipParallel: a first extraction adopts every file as a blob, a second
+// one skips them, a renamed file is hardlinked from its blob, a complete pass prunes what nothing
+// references. and a crafted file with another file's crc32 and size must be written out, never
+// mistaken for the stored one
+#include "check.h"
+#include "crc32.h"
+#include "extract.h"
+#include "store.h"
+#include "zipwriter.h"
+#include <array>
+#include <map>
+
+static void WriteTestFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+static uint32_t Crc(const std::string& data) {
+    return Crc32Update(0, data.data(), data.size());
+}
+
+// data with its first byte changed and its last four chosen so the crc32 stays the same. for one
+// length crc32 is affine, crc(a ^ b) = crc(a) ^ crc(b) ^ crc(zeros), so this is 32 linear equations
+// over GF(2) in the 32 bits of the tail
+static std::string CrcCollision(const std::string& data) {
+    size_t n = data.size();
+    uint32_t zero = Crc(std::string(n, '\0'));
+    auto effect = [&](size_t byte, uint8_t bits) {
+        std::string delta(n, '\0');
+        delta[byte] = static_cast<char>(bits);
+        return Crc(delta) ^ zero;
+    };
+
+    // columns: what flipping each tail bit does to the crc, solved for the first byte's change
+    std::array<uint32_t, 32> columns;
+    for (int bit = 0; bit < 32; ++bit) columns[bit] = effect(n - 4 + bit / 8, static_cast<uint8_t>(1u << (bit % 8)));
+    uint32_t target = effect(0, 0x01);
+
+    std::array<uint32_t, 32> rows = {}; // row r: bit r of every column
+    std::array<bool, 32> rhs = {};
+    for (int r = 0; r < 32; ++r) {
+        for (int c = 0; c < 32; ++c) rows[r] |= ((columns[c] >> r) & 1u) << c;
+        rhs[r] = (target >> r) & 1u;
+    }
+    for (int c = 0, r = 0; c < 32; ++c, ++r) {
+        int pivot = r;
+        while (pivot < 32 && !((rows[pivot] >> c) & 1u)) ++pivot;
+        if (pivot == 32) return ""; // can't happen for crc32, its tail bits are independent
+        std::swap(rows[r], rows[pivot]);
+        std::swap(rhs[r], rhs[pivot]);
+        for (int other = 0; other < 32; ++other) {
+            if (other != r && ((rows[other] >> c) & 1u)) {
+                rows[other] ^= rows[r];
+                rhs[other] = rhs[other] != rhs[r];
+            }
+        }
+    }
+
+    std::string forged = data;
+    forged[0] ^= 0x01;
+    for (int bit = 0; bit < 32; ++bit) {
+        if (rhs[bit]) forged[n - 4 + bit / 8] ^= static_cast<char>(1u << (bit % 8));
+    }
+    return forged;
+}
+
+static bool Extract(const std::filesystem::path& root, const std::string& archive, const std::map<std::string, std::string>& files) {
+    ZipWriter zip;
+    int i = 0;
+    for (const auto& file : files) {
+        ZipWriter::EntryOptions options;
+        options.deflate = i++ % 2 == 0;
+        zip.Add(file.first, file.second, options);
+    }
+    std::filesystem::path path = root / archive;
+    WriteTestFile(path, zip.Finish());
+
+    ContentStore store;
+    std::string error;
+    if (!store.Open(root / "store", error)) return false;
+    bool extracted = ExtractZipParallel(path.string(), (root / "install").string(), 2, error, &store);
+    if (!extracted) fprintf(stderr, "%s\n", error.c_str());
+    return extracted && store.Commit(true, error);
+}
+
+static size_t BlobCount(const std::filesystem::path& root) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root / "store" / "objects")) {
+        if (entry.is_regular_file()) ++count;
+    }
+    return count;
+}
+
+int main() {
+    TestDirectory dir("storetest");
+    std::filesystem::path install = dir.path / "install";
+
+    std::string original = TestPayload(40000, 1);
+    std::string forged = CrcCollision(original);
+    REQUIRE(!forged.empty() && forged != original);
+    REQUIRE(Crc(forged) == Crc(original) && forged.size() == original.size());
+
+    // first install: everything written and adopted, the files hardlinked to their blobs
+    std::map<std::string, std::string> release = {
+        { "bin/app.exe", original },
+        { "data/a.pak", TestPayload(100000, 2) },
+        { "data/b.pak", std::string(70000, 'b') },
+        { "readme.txt", "hello" },
+    };
+    REQUIRE(Extract(dir.path, "v1.zip", release));
+    for (const auto& file : release) CHECK(ReadTestFile(install / file.first) == file.second);
+    CHECK(BlobCount(dir.path) == 4);
+    CHECK(std::filesystem::hard_link_count(install / "bin" / "app.exe") == 2);
+
+    // the same release again: nothing is rewritten
+    auto before = std::filesystem::last_write_time(install / "data" / "a.pak");
+    REQUIRE(Extract(dir.path, "v1.zip", release));
+    CHECK(std::filesystem::last_write_time(install / "data" / "a.pak") == before);
+    CHECK(BlobCount(dir.path) == 4);
+
+    // a file moved to a new name comes out of the store, one dropped is pruned with its blob
+    std::map<std::string, std::string> moved = release;
+    moved.erase("data/b.pak");
+    moved["data/renamed.pak"] = release["data/a.pak"];
+    moved.erase("data/a.pak");
+    REQUIRE(Extract(dir.path, "v2.zip", moved));
+    CHECK(ReadTestFile(install / "data" / "renamed.pak") == release["data/a.pak"]);
+    CHECK(std::filesystem::hard_link_count(install / "data" / "renamed.pak") >= 2);
+    CHECK(BlobCount(dir.path) == 3);
+
+    // the forged file under the same name: crc32, size and the old mtime all match the record,
+    // only the sha256 tells them apart
+    std::map<std::string, std::string> replaced = moved;
+    replaced["bin/app.exe"] = forged;
+    REQUIRE(Extract(dir.path, "v3.zip", replaced));
+    CHECK(ReadTestFile(install / "bin" / "app.exe") == forged);
+
+    // and under a new name, while the original's blob is still in the store
+    std::map<std::string, std::string> both = replaced;
+    both["bin/app.exe"] = original;
+    REQUIRE(Extract(dir.path, "v4.zip", both));
+    both["bin/forged.exe"] = forged;
+    REQUIRE(Extract(dir.path, "v5.zip", both));
+    CHECK(ReadTestFile(install / "bin" / "app.exe") == original);
+    CHECK(ReadTestFile(install / "bin" / "forged.exe") == forged);
+    CHECK(BlobCount(dir.path) == 4);
+
+    // a blob edited through its hardlink isn't handed out again
+    {
+        std::ofstream(install / "bin" / "app.exe", std::ios::binary | std::ios::app) << "x";
+        std::map<std::string, std::string> again = both;
+        again.erase("bin/app.exe");
+        again["bin/copy.exe"] = original;
+        REQUIRE(Extract(dir.path, "v6.zip", again));
+        CHECK(ReadTestFile(install / "bin" / "copy.exe") == original);
+    }
+
+    return CheckResult();
+}
@@ -0,0 +1,149 @@
+// StreamingZipExtractor fed straight from a download: a generated archive served by the loopback
+// server is extracted as its bytes arrive, and the same archive fed in 1-byte and uneven pieces.
+// corrupt, truncated and unsafe archives have to fail instead of leaving a half-checked tree
+#include "check.h"
+#include "extract.h"
+#include "http.h"
+#include "loopback.h"
+#include "zipwriter.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+// a release-like tree: nested folders, text that deflates well, noise that doesn't, empty files,
+// stored entries and streamed ones with data descriptors
+static std::map<std::string, std::string> SampleTree() {
+    std::map<std::string, std::string> files;
+    files["bin/VelocityX.exe"] = TestPayload(700 * 1024, 3);
+    files["bin/lua51.dll"] = TestPayload(90 * 1024, 4);
+    for (int i = 0; i < 40; ++i) {
+        std::string text;
+        for (int line = 0; line < 50 + i * 7; ++line) text += "local value_" + std::to_string(line) + " = " + std::to_string(line * i) + "\n";
+        files["scripts/lib/module" + std::to_string(i) + ".lua"] = text;
+    }
+    files["config/settings.json"] = "{\"theme\":\"dark\",\"autoInject\":true}";
+    files["config/empty.txt"] = "";
+    files["readme.txt"] = std::string(200 * 1024, 'r');
+    return files;
+}
+
+static std::string BuildArchive(const std::map<std::string, std::string>& files) {
+    ZipWriter zip;
+    zip.AddDirectory("bin/");
+    zip.AddDirectory("scripts/");
+    int i = 0;
+    for (const auto& file : files) {
+        ZipWriter::EntryOptions options;
+        options.deflate = i % 3 != 0;
+        options.descriptor = options.deflate && i % 2 == 0;
+        options.zip64 = i % 5 == 4;
+        zip.Add(file.first, file.second, options);
+        ++i;
+    }
+    return zip.Finish();
+}
+
+static bool TreeMatches(const std::filesystem::path& root, const std::map<std::string, std::string>& files) {
+    for (const auto& file : files) {
+        if (ReadTestFile(root / file.first) != file.second) {
+            fprintf(stderr, "mismatch in %s\n", file.first.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// feed archive in pieces of the sizes in pattern, over and over
+static bool FeedInPieces(StreamingZipExtractor& extractor, const std::string& archive, const std::vector<size_t>& pattern) {
+    size_t pos = 0;
+    for (size_t i = 0; pos < archive.size(); ++i) {
+        size_t piece = (std::min)(pattern[i % pattern.size()], archive.size() - pos);
+        if (!extractor.Feed(archive.data() + pos, piece)) return false;
+        pos += piece;
+    }
+    return extractor.Finish();
+}
+
+static int Run() {
+    std::map<std::string, std::string> files = SampleTree();
+    std::string archive = BuildArchive(files);
+    TestDirectory dir("streamtest");
+
+    // off the wire, in whatever pieces curl hands over, with the server capping the rate so the
+    // archive arrives over many reads
+    LoopbackServer server;
+    std::string error;
+    REQUIRE(server.Start(error));
+    server.Serve("/VelocityX.zip", archive);
+    server.bytesPerSec = 8 * 1024 * 1024;
+    {
+        StreamingZipExtractor extractor((dir.path / "wire").string());
+        HttpClient client;
+        HttpRequest request;
+        request.url = server.Url("/VelocityX.zip");
+        size_t pieces = 0;
+        request.onData = [&extractor, &pieces](const char* data, size_t size) {
+            ++pieces;
+            return extractor.Feed(data, size);
+        };
+        HttpResponse response = client.Fetch(request);
+        CHECK(response.Ok() && response.status == 200);
+        CHECK(extractor.Finish());
+        CHECK(extractor.Error().empty());
+        CHECK(extractor.EntriesWritten() == files.size()); // directories aren't counted
+        CHECK(pieces > 1);
+        CHECK(TreeMatches(dir.path / "wire", files));
+        CHECK(std::filesystem::is_directory(dir.path / "wire" / "scripts"));
+    }
+    server.Stop();
+
+    // every header split at every possible place
+    {
+        StreamingZipExtractor extractor((dir.path / "bytes").string());
+        CHECK(FeedInPieces(extractor, archive, { 1 }));
+        CHECK(TreeMatches(dir.path / "bytes", files));
+    }
+    {
+        StreamingZipExtractor extractor((dir.path / "uneven").string());
+        CHECK(FeedInPieces(extractor, archive, { 7, 4093, 31, 65536, 2, 1000003 }));
+        CHECK(TreeMatches(dir.path / "uneven", files));
+    }
+
+    // a flipped byte inside a stored entry: written, then caught by its crc
+    {
+        ZipWriter zip;
+        ZipWriter::EntryOptions stored;
+        stored.deflate = false;
+        zip.Add("data.bin", TestPayload(5000), stored);
+        std::string corrupt = zip.Finish();
+        corrupt[30 + 8 + 2500] ^= 0x40;
+        StreamingZipExtractor extractor((dir.path / "corrupt").string());
+        CHECK(!FeedInPieces(extractor, corrupt, { 1024 }));
+        CHECK(extractor.Error().find("CRC mismatch") != std::string::npos);
+    }
+
+    // cut off before the central directory
+    {
+        StreamingZipExtractor extractor((dir.path / "truncated").string());
+        CHECK(!FeedInPieces(extractor, archive.substr(0, archive.size() / 2), { 4096 }));
+        CHECK(!extractor.Error().empty());
+    }
+
+    // an entry that would land outside the folder
+    {
+        ZipWriter zip;
+        zip.Add("../escape.txt", "nope");
+        StreamingZipExtractor extractor((dir.path / "unsafe").string());
+        CHECK(!FeedInPieces(extractor, zip.Finish(), { 4096 }));
+        CHECK(extractor.Error().find("unsafe path") != std::string::npos);
+        CHECK(!std::filesystem::exists(dir.path / "escape.txt"));
+    }
+
+    return CheckResult();
+}
+
+int main() {
+    int result = Run();
+    HttpPoolShutdown();
+    return result;
+}
@@ -0,0 +1,129 @@
+// MappedZipArchive's central directory parsing: zip64 end records and extra fields, stored entries
+// copied straight out of the mapping, and hostile offsets near 2^64 that must be rejected (or
+// ignored) without wrapping around into a read out of bounds
+#include "check.h"
+#include "extract.h"
+#include "zipwriter.h"
+#include <cstring>
+
+static void WriteTestFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+static void PutLE64(std::string& data, size_t at, uint64_t value) {
+    for (int i = 0; i < 8; ++i, value >>= 8) data[at + i] = static_cast<char>(value & 0xFF);
+}
+
+static std::string LE32(uint32_t value) {
+    std::string bytes(4, '\0');
+    for (int i = 0; i < 4; ++i, value >>= 8) bytes[i] = static_cast<char>(value & 0xFF);
+    return bytes;
+}
+
+// where the central directory's zip64 extra field for the first entry starts
+static size_t FirstCentralExtra(const std::string& archive) {
+    size_t central = archive.find(std::string("PK\x01\x02", 4));
+    uint16_t nameLength = static_cast<unsigned char>(archive[central + 28]) | static_cast<unsigned char>(archive[central + 29]) << 8;
+    return central + 46 + nameLength;
+}
+
+static bool OpenArchive(const std::filesystem::path& path, const std::string& bytes, MappedZipArchive& archive, std::string& error) {
+    WriteTestFile(path, bytes);
+    error.clear();
+    return archive.Open(path.string(), error);
+}
+
+int main() {
+    TestDirectory dir("ziptest");
+    std::string error;
+
+    std::string stored = TestPayload(3 * 1024 * 1024 + 5, 11);
+    std::string deflated = std::string(600 * 1024, 'd') + TestPayload(1000, 12);
+
+    // zip64 everywhere: per-entry extra fields, the zip64 end record and its locator
+    std::string zip64;
+    {
+        ZipWriter zip;
+        ZipWriter::EntryOptions options;
+        options.zip64 = true;
+        options.deflate = false;
+        zip.Add("bin/payload.bin", stored, options);
+        options.deflate = true;
+        zip.Add("bin/text.txt", deflated, options);
+        zip.Add("small.txt", "plain entry, no zip64");
+        zip64 = zip.Finish(true);
+    }
+    {
+        MappedZipArchive archive;
+        REQUIRE(OpenArchive(dir.path / "zip64.zip", zip64, archive, error));
+        REQUIRE(archive.Entries().size() == 3);
+        const MappedZipArchive::Entry& first = archive.Entries()[0];
+        CHECK(first.name == "bin/payload.bin" && first.method == 0);
+        CHECK(first.uncompressedSize == stored.size() && first.compressedSize == stored.size());
+        CHECK(memcmp(archive.Data() + first.dataOffset, stored.data(), stored.size()) == 0);
+        CHECK(archive.Entries()[1].uncompressedSize == deflated.size() && archive.Entries()[1].method == 8);
+        CHECK(archive.Entries()[2].name == "small.txt");
+    }
+    std::filesystem::path out = dir.path / "zip64";
+    CHECK(ExtractZipParallel((dir.path / "zip64.zip").string(), out.string(), 2, error));
+    CHECK(ReadTestFile(out / "bin" / "payload.bin") == stored);
+    CHECK(ReadTestFile(out / "bin" / "text.txt") == deflated);
+    CHECK(ReadTestFile(out / "small.txt") == "plain entry, no zip64");
+
+    // a classic archive with a locator in front of its end record pointing near 2^64: the
+    // bounds check must not wrap, the classic values are used
+    std::string classic;
+    {
+        ZipWriter zip;
+        zip.Add("a.txt", "alpha");
+        zip.Add("b.txt", "bravo");
+        classic = zip.Finish();
+    }
+    for (uint64_t target : { ~uint64_t(0) - 15, ~uint64_t(0) - 55, uint64_t(classic.size()) - 10 }) {
+        std::string bytes = classic;
+        std::string locator = LE32(0x07064b50) + LE32(0) + std::string(8, '\0') + LE32(1);
+        PutLE64(locator, 8, target);
+        bytes.insert(bytes.size() - 22, locator);
+        MappedZipArchive archive;
+        CHECK(OpenArchive(dir.path / "locator.zip", bytes, archive, error));
+        CHECK(archive.Entries().size() == 2);
+    }
+
+    // the zip64 end record placing the central directory past the end of the file
+    {
+        std::string bytes = zip64;
+        size_t zip64End = bytes.rfind(std::string("PK\x06\x06", 4));
+        PutLE64(bytes, zip64End + 48, ~uint64_t(0) - 100);
+        MappedZipArchive archive;
+        CHECK(!OpenArchive(dir.path / "directory.zip", bytes, archive, error));
+        CHECK(error.find("central directory out of bounds") != std::string::npos);
+    }
+
+    // a local header offset that wraps when the header size is added
+    for (uint64_t offset : { ~uint64_t(0) - 8, ~uint64_t(0), uint64_t(zip64.size()) - 4 }) {
+        std::string bytes = zip64;
+        PutLE64(bytes, FirstCentralExtra(bytes) + 4 + 16, offset);
+        MappedZipArchive archive;
+        CHECK(!OpenArchive(dir.path / "local.zip", bytes, archive, error));
+        CHECK(error.find("bad local header") != std::string::npos);
+    }
+
+    // a compressed size that would run the entry's data past the end, or wrap doing so
+    for (uint64_t size : { ~uint64_t(0), uint64_t(zip64.size()) }) {
+        std::string bytes = zip64;
+        PutLE64(bytes, FirstCentralExtra(bytes) + 4 + 8, size);
+        MappedZipArchive archive;
+        CHECK(!OpenArchive(dir.path / "size.zip", bytes, archive, error));
+        CHECK(error.find("out of bounds") != std::string::npos);
+    }
+
+    // no end record at all
+    {
+        MappedZipArchive archive;
+        CHECK(!OpenArchive(dir.path / "cut.zip", zip64.substr(0, zip64.size() - 30), archive, error));
+        CHECK(!error.empty());
+    }
+
+    return CheckResult();
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <zlib.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// builds zip archives in memory for the extraction tests and benchmarks. an entry is stored or
+// deflated, optionally streamed (its sizes in a data descriptor after the data) and optionally
+// zip64 (saturated header fields, the real values in extra field 0x0001). Finish can also end the
+// archive with the zip64 end record and locator
+class ZipWriter {
+public:
+    struct EntryOptions {
+        bool deflate = true;
+        bool descriptor = false;
+        bool zip64 = false;
+        int level = 6;
+    };
+
+    void Add(const std::string& name, const std::string& data) { Add(name, data, EntryOptions()); }
+
+    void Add(const std::string& name, const std::string& data, const EntryOptions& options) {
+        Central entry;
+        entry.name = name;
+        entry.method = options.deflate ? 8 : 0;
+        entry.flags = options.descriptor ? 0x0008 : 0;
+        entry.crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(data.size())));
+        entry.uncompressedSize = data.size();
+        entry.offset = out.size();
+        entry.zip64 = options.zip64;
+        std::string payload = options.deflate ? Deflate(data, options.level) : data;
+        entry.compressedSize = payload.size();
+
+        // a streamed entry's local header has zero crc and sizes, the descriptor carries them
+        bool known = !options.descriptor;
+        Put32(0x04034b50);
+        Put16(options.zip64 ? 45 : 20);
+        Put16(entry.flags);
+        Put16(entry.method);
+        Put32(0); // time, date
+        Put32(known ? entry.crc : 0);
+        if (options.zip64) {
+            Put32(0xFFFFFFFF);
+            Put32(0xFFFFFFFF);
+        } else {
+            Put32(known ? static_cast<uint32_t>(entry.compressedSize) : 0);
+            Put32(known ? static_cast<uint32_t>(entry.uncompressedSize) : 0);
+        }
+        Put16(static_cast<uint16_t>(name.size()));
+        Put16(options.zip64 ? 20 : 0);
+        out += name;
+        if (options.zip64) {
+            Put16(0x0001);
+            Put16(16);
+            Put64(known ? entry.uncompressedSize : 0);
+            Put64(known ? entry.compressedSize : 0);
+        }
+        out += payload;
+
+        if (options.descriptor) {
+            Put32(0x08074b50);
+            Put32(entry.crc);
+            if (options.zip64) {
+                Put64(entry.compressedSize);
+                Put64(entry.uncompressedSize);
+            } else {
+                Put32(static_cast<uint32_t>(entry.compressedSize));
+                Put32(static_cast<uint32_t>(entry.uncompressedSize));
+            }
+        }
+        central.push_back(entry);
+    }
+
+    void AddDirectory(const std::string& name) {
+        EntryOptions options;
+        options.deflate = false;
+        Add(name.back() == '/' ? name : name + "/", "", options);
+    }
+
+    // the central directory and end records, then the whole archive
+    std::string Finish(bool zip64End = false) {
+        uint64_t directoryOffset = out.size();
+        for (const Central& entry : central) {
+            Put32(0x02014b50);
+            Put16(entry.zip64 ? 45 : 20); // made by
+            Put16(entry.zip64 ? 45 : 20); // needed
+            Put16(entry.flags);
+            Put16(entry.method);
+            Put32(0);
+            Put32(entry.crc);
+            Put32(entry.zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(entry.compressedSize));
+            Put32(entry.zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(entry.uncompressedSize));
+            Put16(static_cast<uint16_t>(entry.name.size()));
+            Put16(entry.zip64 ? 28 : 0);
+            Put16(0); // comment
+            Put16(0); // disk
+            Put16(0); // internal attributes
+            Put32(0); // external attributes
+            Put32(entry.zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(entry.offset));
+            out += entry.name;
+            if (entry.zip64) {
+                Put16(0x0001);
+                Put16(24);
+                Put64(entry.uncompressedSize);
+                Put64(entry.compressedSize);
+                Put64(entry.offset);
+            }
+        }
+        uint64_t directorySize = out.size() - directoryOffset;
+
+        if (zip64End) {
+            uint64_t zip64EndOffset = out.size();
+            Put32(0x06064b50);
+            Put64(44); // size of the rest of the record
+            Put16(45);
+            Put16(45);
+            Put32(0);
+            Put32(0);
+            Put64(central.size());
+            Put64(central.size());
+            Put64(directorySize);
+            Put64(directoryOffset);
+
+            Put32(0x07064b50);
+            Put32(0);
+            Put64(zip64EndOffset);
+            Put32(1);
+        }
+
+        Put32(0x06054b50);
+        Put16(0);
+        Put16(0);
+        Put16(zip64End ? 0xFFFF : static_cast<uint16_t>(central.size()));
+        Put16(zip64End ? 0xFFFF : static_cast<uint16_t>(central.size()));
+        Put32(zip64End ? 0xFFFFFFFF : static_cast<uint32_t>(directorySize));
+        Put32(zip64End ? 0xFFFFFFFF : static_cast<uint32_t>(directoryOffset));
+        Put16(0);
+        return out;
+    }
+
+    static std::string Deflate(const std::string& data, int level = 6) {
+        z_stream stream = {};
+        deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        std::string compressed(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+        stream.avail_out = static_cast<uInt>(compressed.size());
+        deflate(&stream, Z_FINISH);
+        compressed.resize(stream.total_out);
+        deflateEnd(&stream);
+        return compressed;
+    }
+
+private:
+    struct Central {
+        std::string name;
+        uint16_t method = 0;
+        uint16_t flags = 0;
+        uint32_t crc = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t offset = 0;
+        bool zip64 = false;
+    };
+
+    void Put16(uint32_t value) { PutLE(value, 2); }
+    void Put32(uint32_t value) { PutLE(value, 4); }
+    void Put64(uint64_t value) { PutLE(value, 8); }
+
+    void PutLE(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i, value >>= 8) out.push_back(static_cast<char>(value & 0xFF));
+    }
+
+    std::string out;
+    std::vector<Central> central;
+};
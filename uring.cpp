@@ -0,0 +1,267 @@
+#include "uring.h"
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define URING_AVAILABLE 1
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const unsigned kSubmitBatch = 48; // queued operations that trigger an io_uring_enter on their own
+
+UringFileWriter::~UringFileWriter() {
+    Stop();
+}
+
+#ifdef URING_AVAILABLE
+
+enum : unsigned { kOpOpen, kOpWrite, kOpClose };
+
+static int RingSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int RingEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int RingRegister(int ring, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, arg, count));
+}
+
+bool UringFileWriter::Start() {
+    Stop();
+
+    // three operations per file, never more in flight than the slots allow
+    io_uring_params params = {};
+    ring = RingSetup(kSlots * 4, &params);
+    if (ring < 0) {
+        ring = -1;
+        return false;
+    }
+
+    // linked chains on a direct descriptor opened earlier in the same chain need 5.17
+    unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_LINKED_FILE;
+    if ((params.features & required) != required) {
+        Stop();
+        return false;
+    }
+
+    sqRingSize = (std::max)(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqRing == MAP_FAILED) sqRing = nullptr;
+        if (sqes == MAP_FAILED) sqes = nullptr;
+        Stop();
+        return false;
+    }
+
+    char* base = static_cast<char*>(sqRing);
+    sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = base + params.cq_off.cqes;
+
+    // one direct descriptor per slot, empty until a chain opens into it
+    std::vector<int> files(kSlots, -1);
+    if (RingRegister(ring, IORING_REGISTER_FILES, files.data(), kSlots) < 0) {
+        Stop();
+        return false;
+    }
+
+    slots.assign(kSlots, Slot());
+    for (Slot& slot : slots) {
+        slot.buffer.resize(kBufferSize);
+    }
+    error.clear();
+    return true;
+}
+
+void UringFileWriter::Stop() {
+    // closing the ring also closes whatever direct descriptors are still open
+    if (sqes) munmap(sqes, sqesSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ring >= 0) close(ring);
+    sqes = nullptr;
+    sqRing = nullptr;
+    ring = -1;
+    unsubmitted = 0;
+    current = -1;
+    slots.clear();
+}
+
+bool UringFileWriter::Submit(unsigned waitFor) {
+    for (;;) {
+        int submitted = RingEnter(ring, unsubmitted, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0);
+        if (submitted >= 0) {
+            unsubmitted -= (std::min)(unsubmitted, static_cast<unsigned>(submitted));
+            if (unsubmitted == 0 || waitFor) return true;
+            continue;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EBUSY || errno == EAGAIN) {
+            // completions have to be reaped before the kernel takes more
+            Reap();
+            continue;
+        }
+        if (error.empty()) error = std::string("io_uring submit failed: ") + strerror(errno);
+        return false;
+    }
+}
+
+void UringFileWriter::Reap() {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    io_uring_cqe* completions = static_cast<io_uring_cqe*>(cqes);
+
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = completions[head & *cqMask];
+        Slot& slot = slots[cqe.user_data / 4];
+        unsigned op = static_cast<unsigned>(cqe.user_data % 4);
+
+        // a short write breaks the chain as well. after a failure the rest of the chain comes back
+        // cancelled, the first error is the one that counts
+        int result = cqe.res;
+        if (op == kOpWrite && result >= 0 && static_cast<size_t>(result) != slot.size) result = -EIO;
+        if (result < 0 && slot.result == 0) slot.result = result;
+
+        if (--slot.outstanding == 0) {
+            if (slot.result == 0) {
+                if (slot.done) slot.done();
+            } else if (error.empty()) {
+                error = "Failed writing " + slot.path + ": " + strerror(-slot.result);
+            }
+            slot.done = nullptr;
+        }
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+unsigned char* UringFileWriter::Buffer() {
+    if (ring < 0 || !error.empty()) return nullptr;
+
+    for (;;) {
+        Reap();
+        if (!error.empty()) return nullptr;
+        for (unsigned i = 0; i < kSlots; ++i) {
+            if (slots[i].outstanding == 0) {
+                current = static_cast<int>(i);
+                return slots[i].buffer.data();
+            }
+        }
+        // every slot is in flight, push what's queued and wait for one to come back
+        if (!Submit(1)) return nullptr;
+    }
+}
+
+bool UringFileWriter::Queue(const std::string& path, size_t size, std::function<void()> done) {
+    if (current < 0 || size > kBufferSize || !error.empty()) return false;
+
+    unsigned index = static_cast<unsigned>(current);
+    Slot& slot = slots[index];
+    current = -1;
+    slot.path = path;
+    slot.size = size;
+    slot.done = std::move(done);
+    slot.result = 0;
+    slot.outstanding = size > 0 ? 3 : 2;
+
+    io_uring_sqe* entries = static_cast<io_uring_sqe*>(sqes);
+    unsigned tail = *sqTail;
+    auto next = [&](unsigned op) {
+        unsigned position = tail & *sqMask;
+        io_uring_sqe* sqe = &entries[position];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = op;
+        sqe->user_data = index * 4 + (op == IORING_OP_OPENAT ? kOpOpen : op == IORING_OP_WRITE ? kOpWrite : kOpClose);
+        sqArray[position] = position;
+        ++tail;
+        return sqe;
+    };
+
+    // open into the slot's direct descriptor (O_CLOEXEC isn't allowed there, nothing ever sees the fd)
+    io_uring_sqe* open = next(IORING_OP_OPENAT);
+    open->fd = AT_FDCWD;
+    open->addr = reinterpret_cast<uint64_t>(slot.path.c_str());
+    open->len = 0644;
+    open->open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+    open->file_index = index + 1;
+    open->flags = IOSQE_IO_LINK;
+
+    if (size > 0) {
+        io_uring_sqe* write = next(IORING_OP_WRITE);
+        write->fd = static_cast<int>(index);
+        write->addr = reinterpret_cast<uint64_t>(slot.buffer.data());
+        write->len = static_cast<unsigned>(size);
+        write->off = 0;
+        write->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+    }
+
+    io_uring_sqe* closing = next(IORING_OP_CLOSE);
+    closing->file_index = index + 1;
+
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+    unsubmitted += slot.outstanding;
+
+    if (unsubmitted >= kSubmitBatch) return Submit(0);
+    return true;
+}
+
+bool UringFileWriter::Drain(std::string& drainError) {
+    if (ring >= 0) {
+        for (;;) {
+            Reap();
+            bool busy = false;
+            for (const Slot& slot : slots) {
+                busy = busy || slot.outstanding > 0;
+            }
+            if (!busy || !Submit(1)) break;
+        }
+    }
+    if (error.empty()) return true;
+    drainError = error;
+    return false;
+}
+
+#else
+
+bool UringFileWriter::Start() {
+    return false;
+}
+
+void UringFileWriter::Stop() {
+}
+
+unsigned char* UringFileWriter::Buffer() {
+    return nullptr;
+}
+
+bool UringFileWriter::Queue(const std::string&, size_t, std::function<void()>) {
+    return false;
+}
+
+bool UringFileWriter::Drain(std::string& drainError) {
+    if (error.empty()) return true;
+    drainError = error;
+    return false;
+}
+
+bool UringFileWriter::Submit(unsigned) {
+    return false;
+}
+
+void UringFileWriter::Reap() {
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// writes small files through io_uring on Linux (5.17+). each file is built whole in one of the
+// writer's buffers, then its open, write and close go to the kernel as one linked chain on a
+// direct descriptor, and the chains of many files share a single io_uring_enter. one writer per
+// thread, and Drain it on that thread: the kernel cancels whatever a thread leaves in flight
+// when it exits. anywhere else, or when the kernel refuses (too old, disabled by sysctl or a
+// seccomp filter), Start fails and the caller writes synchronously instead
+class UringFileWriter {
+public:
+    static const size_t kBufferSize = 128 * 1024; // biggest file it takes
+    static const unsigned kSlots = 32;            // files in flight at once
+
+    UringFileWriter() = default;
+    ~UringFileWriter();
+
+    UringFileWriter(const UringFileWriter&) = delete;
+    UringFileWriter& operator=(const UringFileWriter&) = delete;
+
+    bool Start();
+
+    // kBufferSize bytes to build the next file in, waiting for an earlier file to finish if all
+    // slots are busy. null once a write has failed
+    unsigned char* Buffer();
+
+    // create path and write the first size bytes of the last Buffer() to it. done runs on this
+    // thread, from a later call, once the file is written and closed
+    bool Queue(const std::string& path, size_t size, std::function<void()> done);
+
+    // wait for everything queued. false if any file failed, error names the first one
+    bool Drain(std::string& error);
+
+private:
+    struct Slot {
+        std::vector<unsigned char> buffer;
+        size_t size = 0;
+        std::string path;
+        std::function<void()> done;
+        int outstanding = 0; // operations of its chain not completed yet, 0 = free
+        int result = 0;      // first negative errno of the chain
+    };
+
+    bool Submit(unsigned waitFor);
+    void Reap();
+    void Stop();
+
+    int ring = -1;
+    void* sqRing = nullptr;
+    size_t sqRingSize = 0;
+    void* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    void* cqes = nullptr;
+    unsigned unsubmitted = 0;
+
+    std::vector<Slot> slots;
+    int current = -1;
+    std::string error;
+};